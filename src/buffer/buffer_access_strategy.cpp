@@ -0,0 +1,16 @@
+#include "buffer/buffer_access_strategy.h"
+
+#include <algorithm>
+
+#include "buffer/buffer_pool_manager.h"
+
+BufferAccessStrategy::BufferAccessStrategy(AccessStrategyType type, BufferPoolManager *buffer_pool_manager)
+    : type_(type) {
+  size_t ring_size = type == AccessStrategyType::kBulkRead ? BULK_READ_RING_SIZE : BULK_WRITE_RING_SIZE;
+  // 环不超过buffer pool的1/8，避免小的buffer pool被一次扫描占满
+  ring_size = std::min(ring_size, buffer_pool_manager->GetPoolSize() / 8);
+  // 分片模式下连续的页号轮流落在各个分片上，环的大小取分片数的整数倍，使每个槽位总是被同一个分片复用
+  size_t num_instances = buffer_pool_manager->GetNumInstances();
+  ring_size = std::max(num_instances, (ring_size + num_instances - 1) / num_instances * num_instances);
+  ring_.resize(ring_size);
+}
@@ -1,35 +1,99 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <new>
+
 #include "glog/logging.h"
+#include "page/b_plus_tree_page.h"
 #include "page/bitmap_page.h"
+#include "page/free_space_map_page.h"
+#include "page/table_page.h"
 
 static const char EMPTY_PAGE_DATA[PAGE_SIZE] = {0};
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+// 块的边界要落在大页边界上，缩小缓冲池时才能单独unmap一个块
+static_assert(static_cast<size_t>(BUFFER_POOL_CHUNK_SIZE) * PAGE_SIZE % HUGE_PAGE_SIZE == 0);
 
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_instances,
+                                     ReplacerType replacer_type)
     : pool_size_(pool_size), disk_manager_(disk_manager) {
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size_);
-  for (size_t i = 0; i < pool_size_; i++) {
-    free_list_.emplace_back(i);
+  if (disk_manager_->IsReadOnly()) {
+    // 只读模式：页直接指向文件映射，不需要帧、分片和replacer；逻辑页号一定小于文件的物理页数
+    read_only_ = true;
+    pool_size_ = 0;
+    mapped_pages_ = vector<atomic<Page *>>(disk_manager_->GetFileSize() / PAGE_SIZE);
+    return;
   }
+  if (num_instances > 1) {
+    // 分片模式：本对象只负责按page_id路由，帧全部由各个分片持有
+    for (size_t i = 0; i < num_instances; i++) {
+      size_t shard_size = pool_size_ / num_instances + (i < pool_size_ % num_instances ? 1 : 0);
+      shards_.push_back(new BufferPoolManager(shard_size, disk_manager_, 1, replacer_type));
+    }
+    return;
+  }
+  switch (replacer_type) {
+    case ReplacerType::kClock:
+      replacer_ = new CLOCKReplacer(pool_size_);
+      break;
+    case ReplacerType::kLRUK:
+      replacer_ = new LRUKReplacer(pool_size_);
+      break;
+    case ReplacerType::kLRU:
+    default:
+      replacer_ = new LRUReplacer(pool_size_);
+      break;
+  }
+  AddFrames(pool_size_);
 }
 
 BufferPoolManager::~BufferPoolManager() {
-  for (auto page : page_table_) {
-    FlushPage(page.first);
+  {
+    std::lock_guard<std::mutex> lock(prefetch_mutex_);
+    prefetch_stop_ = true;
+  }
+  prefetch_cv_.notify_all();
+  if (prefetcher_.joinable()) {
+    prefetcher_.join();
+  }
+  StopBackgroundWriter();
+  {
+    std::lock_guard<std::mutex> lock(release_mutex_);
+    release_stop_ = true;
+  }
+  release_cv_.notify_all();
+  if (releaser_.joinable()) {
+    releaser_.join();
+  }
+  // 每个分片析构时会写回自己的脏页，这里只写回自己的页再落盘
+  for (auto shard : shards_) {
+    delete shard;
+  }
+  shards_.clear();
+  FlushDirtyPages();
+  disk_manager_->Sync();
+  for (auto &chunk : chunks_) {
+    FreeFrameChunk(chunk);
+  }
+  for (auto &page : mapped_pages_) {
+    delete page.load();
   }
-  delete[] pages_;
   delete replacer_;
 }
 
-/**
- * TODO: Student Implement
- */
 /**
  * TODO: Student Implement
  */
 // BufferPoolManager::FetchPage(page_id)：根据逻辑页号获取对应的数据页，如果该数据页不在内存中，则需要从磁盘中进行读取；
-Page *BufferPoolManager::FetchPage(page_id_t page_id) {
+Page *BufferPoolManager::FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) {
   // 1.     Search the page table for the requested page (P).
   // 1.1    If P exists, pin it and return it immediately.
   // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
@@ -37,110 +101,116 @@ Page *BufferPoolManager::FetchPage(page_id_t page_id) {
   // 2.     If R is dirty, write it back to the disk.
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-
-  // unordered_map<page_id_t, frame_id_t> page_table_;  // to keep track of pages
-  // Page* pages_;                                      // array of pages
-  // DiskManager *disk_manager_;                        // pointer to the disk manager.
-  // Replacer *replacer_;                               // to find an unpinned page for replacement
-  // list<frame_id_t> free_list_;                       // to find a free page for replacement
-  // recursive_mutex latch_;                            // to protect shared data structure
-
-  frame_id_t frame_id_temp;
   if(page_id > MAX_VALID_PAGE_ID || page_id <= INVALID_PAGE_ID)
     return nullptr;
+  if(read_only_)
+    return FetchMappedPage(page_id);
+  if(!shards_.empty())
+    return GetShard(page_id)->FetchPage(page_id, strategy);
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
   // 1.     Search the page table for the requested page (P).
-  bool flag = false;
-  for(auto it = page_table_.begin(); it != page_table_.end(); it++) {
-    if(it->first == page_id) {
-      flag = true;
-      break;
-    }
-  }
+  auto iter = page_table_.find(page_id);
   // 1.1    If P exists, pin it and return it immediately.
-  if(flag == true){
-    frame_id_temp = page_table_[page_id];
-    // 给指定的frame_id上锁
-    replacer_->Pin(frame_id_temp);
-    pages_[frame_id_temp].pin_count_++;
-    return &pages_[frame_id_temp];
+  if(iter != page_table_.end()) {
+    frame_id_t frame_id = iter->second;
+    replacer_->Pin(frame_id);
+    if(frames_[frame_id]->pin_count_++ == 0)
+      OnFramePinned();
+    hits_++;
+    return frames_[frame_id];
   }
-  // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
-  //        Note that pages are always found from the free list first.
-  if(free_list_.size() == 0 && replacer_->Size() == 0)
+  // 1.2 ~ 3. 从free list或replacer中找到一个可用的帧（脏页会在其中写回，并从page table中删除）
+  frame_id_t frame_id = TryToFindFreePage(strategy, page_id);
+  if(frame_id == INVALID_FRAME_ID)
     return nullptr;
-  else {
-    if(free_list_.size()>0){
-      //pick from the head of the free list
-      frame_id_temp = free_list_.front();
-      //delete the frame id from free list
-      free_list_.pop_front();
-      //update page_table_
-      page_table_[page_id] = frame_id_temp;
-      // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-      disk_manager_->ReadPage(page_id, pages_[frame_id_temp].data_);
-      pages_[frame_id_temp].pin_count_ = 1;
-      pages_[frame_id_temp].page_id_ = page_id;
-      return &pages_[frame_id_temp];
-    }
-    else{
-      if(replacer_->Victim(&frame_id_temp) == false)
-        return nullptr;
-      // 2.     If R is dirty, write it back to the disk.
-      if(pages_[frame_id_temp].IsDirty()){
-        disk_manager_->WritePage(pages_[frame_id_temp].GetPageId(),pages_[frame_id_temp].GetData());
-      }
-      // 3.     Delete R from the page table and insert P.
-      // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-      pages_[frame_id_temp].page_id_ = page_id;
-      pages_[frame_id_temp].pin_count_ = 1;
-      page_table_[page_id] = frame_id_temp;
-      //readpage from disk
-      disk_manager_->ReadPage(page_id,pages_[frame_id_temp].data_);
-      return &pages_[frame_id_temp];
+  // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
+  Page &page = *frames_[frame_id];
+  disk_manager_->ReadPage(page_id, page.data_);
+  page.page_id_ = page_id;
+  page.pin_count_ = 1;
+  page.is_dirty_ = false;
+  page_table_.emplace(page_id, frame_id);
+  OnFramePinned();
+  misses_++;
+  return &page;
+}
+
+Page *BufferPoolManager::FetchMappedPage(page_id_t page_id) {
+  const char *data = disk_manager_->GetMappedPage(page_id);
+  if(data == nullptr || static_cast<size_t>(page_id) >= mapped_pages_.size())
+    return nullptr;
+  // 第一次访问时创建指向映射的页对象，不加锁：并发创建时只保留先放入的那个
+  Page *page = mapped_pages_[page_id].load(std::memory_order_acquire);
+  if(page == nullptr) {
+    auto *new_page = new Page(const_cast<char *>(data));
+    new_page->page_id_ = page_id;
+    if(mapped_pages_[page_id].compare_exchange_strong(page, new_page, std::memory_order_acq_rel)) {
+      page = new_page;
+    } else {
+      delete new_page;
     }
   }
+  return page;
 }
 
 /**
  * TODO: Student Implement
  */
 // 分配一个新的数据页，并将逻辑页号于page_id中返回
-Page *BufferPoolManager::NewPage(page_id_t &page_id) {
+Page *BufferPoolManager::NewPage(page_id_t &page_id, BufferAccessStrategy *strategy, ExtentReservation *reservation) {
   // 0.   Make sure you call AllocatePage!
   // 1.   If all the pages in the buffer pool are pinned, return nullptr.
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
   // 3.   Update P's metadata, zero out memory and add P to the page table.
   // 4.   Set the page ID output parameter. Return a pointer to P.
-  frame_id_t frame_id;
-  // If all the pages in the buffer pool are pinned, return nullptr.
-  if(free_list_.size() == 0 && replacer_->Size() == 0 ) {
+  // 页号由磁盘统一分配，分配后再交给对应的分片；分片各自加锁，路由器的锁只在不分片时需要
+  std::unique_lock<std::recursive_mutex> lock(latch_, std::defer_lock);
+  if(shards_.empty())
+    lock.lock();
+  page_id = AllocatePage(reservation);
+  if(page_id == INVALID_PAGE_ID)
     return nullptr;
+  Page *page = shards_.empty() ? NewPageWithId(page_id, strategy) : GetShard(page_id)->NewPageWithId(page_id, strategy);
+  // If all the pages in the buffer pool are pinned, return nullptr.
+  if(page == nullptr) {
+    DeallocatePage(page_id);
+    page_id = INVALID_PAGE_ID;
   }
-  // Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
-  if(free_list_.size() > 0) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  }
-  else {
-    if(replacer_->Victim(&frame_id) == false) {
-      return nullptr;
-    }
-    // 如果找到的页是dirty的，则将其写回磁盘
-    if(pages_[frame_id].IsDirty()) {
-      disk_manager_->WritePage(pages_[frame_id].page_id_, pages_[frame_id].data_);
-      pages_[frame_id].is_dirty_ = false;
-    }
-    page_table_.erase(pages_[frame_id].page_id_);
+  return page;
+}
+
+Page *BufferPoolManager::NewPageWithId(page_id_t page_id, BufferAccessStrategy *strategy) {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  // 预读可能装入了该页号被释放前的旧内容，先将其丢弃
+  auto iter = page_table_.find(page_id);
+  if(iter != page_table_.end() && frames_[iter->second]->pin_count_ == 0) {
+    frame_id_t stale_frame_id = iter->second;
+    page_table_.erase(iter);
+    replacer_->Remove(stale_frame_id);
+    frames_[stale_frame_id]->page_id_ = INVALID_PAGE_ID;
+    frames_[stale_frame_id]->is_dirty_ = false;
+    if(!IsRetiring(stale_frame_id))
+      free_list_.push_back(stale_frame_id);
   }
-  page_id = AllocatePage();
+  frame_id_t frame_id = TryToFindFreePage(strategy, page_id);
+  if(frame_id == INVALID_FRAME_ID)
+    return nullptr;
+  return InitNewPage(frame_id, page_id);
+}
+
+Page *BufferPoolManager::InitNewPage(frame_id_t frame_id, page_id_t page_id) {
   // Update P's metadata, zero out memory and add P to the page table.
-  pages_[frame_id].ResetMemory();
-  pages_[frame_id].page_id_ = page_id;
-  pages_[frame_id].pin_count_ = 1;
-  pages_[frame_id].is_dirty_ = false;
+  Page &page = *frames_[frame_id];
+  page.ResetMemory();
+  page.page_id_ = page_id;
+  page.pin_count_ = 1;
+  page.is_dirty_ = false;
   page_table_.emplace(page_id, frame_id);
-  return &pages_[frame_id];
+  OnFramePinned();
+  new_pages_++;
+  return &page;
 }
+
 /**
  * TODO: Student Implement
  */
@@ -152,35 +222,64 @@ bool BufferPoolManager::DeletePage(page_id_t page_id) {
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
   if(page_id == INVALID_PAGE_ID)
     return true;
-  // 寻找指定的page_id
-  bool flag = false;
-  for(auto it = page_table_.begin(); it != page_table_.end(); it++) {
-    if(it->first == page_id) {
-      flag = true;
-      break;
-    }
+  if(read_only_)
+    return false;
+  if(!shards_.empty())
+    return GetShard(page_id)->DeletePage(page_id);
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  if(!DiscardPage(page_id))
+    return false;
+  // 无论P是否在内存中，都需要释放磁盘上的页
+  DeallocatePage(page_id);
+  return true;
+}
+
+bool BufferPoolManager::DeletePages(const vector<page_id_t> &page_ids, size_t *num_deleted) {
+  if(read_only_)
+    return false;
+  // 先把这些页逐个移出缓冲池，再一次性在磁盘上释放
+  bool all_deleted = true;
+  vector<page_id_t> discarded;
+  for(auto page_id : page_ids) {
+    if(page_id == INVALID_PAGE_ID)
+      continue;
+    if(shards_.empty() ? DiscardPage(page_id) : GetShard(page_id)->DiscardPage(page_id))
+      discarded.push_back(page_id);
+    else
+      all_deleted = false;
   }
-  if(flag == false)
-    return true;
-  else {
-    // 如果存在，就找到对应的frame_id
-    frame_id_t frame_id_temp = page_table_[page_id];
+  if(num_deleted != nullptr)
+    *num_deleted = discarded.size();
+  disk_manager_->DeAllocatePages(std::move(discarded));
+  return all_deleted;
+}
+
+void BufferPoolManager::ReleaseReservation(ExtentReservation *reservation) {
+  disk_manager_->ReleaseReservation(reservation);
+}
+
+bool BufferPoolManager::DiscardPage(page_id_t page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  auto iter = page_table_.find(page_id);
+  if(iter != page_table_.end()) {
+    frame_id_t frame_id = iter->second;
     //If P exists, but has a non-zero pin-count, return false. Someone is using the page.
-    if(pages_[frame_id_temp].pin_count_>0)
+    if(frames_[frame_id]->pin_count_ > 0)
       return false;
-    // 此时可以删除P
-    page_table_.erase(page_id);
-    // 需要更新metadata
-    pages_[frame_id_temp].ResetMemory();
-    pages_[frame_id_temp].page_id_=INVALID_PAGE_ID;
-    pages_[frame_id_temp].is_dirty_=false;
-    // 将P返回到free list
-    free_list_.push_back(frame_id_temp);
-    // call DeallocatePage
-    disk_manager_->DeAllocatePage(page_id);
-    return true;
+    // 此时可以删除P，需要同时将其移出replacer，避免该帧被重复分配
+    page_table_.erase(iter);
+    replacer_->Remove(frame_id);
+    frames_[frame_id]->ResetMemory();
+    frames_[frame_id]->page_id_ = INVALID_PAGE_ID;
+    frames_[frame_id]->is_dirty_ = false;
+    // 将P返回到free list（正在被缩容释放的帧除外）
+    if(!IsRetiring(frame_id))
+      free_list_.push_back(frame_id);
   }
+  deleted_pages_++;
+  return true;
 }
+
 /**
  * TODO: Student Implement
  */
@@ -189,47 +288,581 @@ bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
   // 判断是否为无效的page_id
   if(page_id == INVALID_PAGE_ID)
     return false;
+  // 只读模式下的页不固定也不会被换出
+  if(read_only_)
+    return disk_manager_->GetMappedPage(page_id) != nullptr;
+  if(!shards_.empty())
+    return GetShard(page_id)->UnpinPage(page_id, is_dirty);
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
   // 判断是否存在指定的page_id
-  if(page_table_.count(page_id)==0)
+  auto iter = page_table_.find(page_id);
+  if(iter == page_table_.end())
     return false;
-  frame_id_t frame_id_temp = page_table_[page_id];
+  Page &page = *frames_[iter->second];
   // 如果数据已经被取消固定
-  if(pages_[frame_id_temp].pin_count_==0)
+  if(page.pin_count_ == 0)
     return false;
-  // 如果数据页被固定，则取消固定
-  pages_[frame_id_temp].pin_count_--;
-  replacer_->Unpin(frame_id_temp);
   if(is_dirty)
-    pages_[frame_id_temp].is_dirty_ = true;
+    page.is_dirty_ = true;
+  // 只有当引用计数降为0时，才允许replacer替换该页；正在被缩容释放的帧交给后台线程清空
+  if(--page.pin_count_ == 0) {
+    if(!IsRetiring(iter->second))
+      replacer_->Unpin(iter->second);
+    num_pinned_--;
+  }
   return true;
 }
-/**
- * TODO: Student Implement
- */
-// bool BufferPoolManager::FlushPage(page_id_t page_id) {
-//   //return false;
-//   //std::lock_guard<std::recursive_mutex> guard(latch_);
-//   if(page_table_.find(page_id)!=page_table_.end()){
-//     auto temp = page_table_[page_id];
-//     disk_manager_->WritePage(page_id, pages_[temp].data_);
-//     return true;
-//   }
-//   return false;
-// }
+
 // 将数据页转储到磁盘中，无论其是否被固定
 bool BufferPoolManager::FlushPage(page_id_t page_id) {
   if(page_id == INVALID_PAGE_ID)
     return false;
-  if(page_table_.count(page_id) == 0)
+  if(read_only_)
+    return disk_manager_->GetMappedPage(page_id) != nullptr;
+  if(!shards_.empty())
+    return GetShard(page_id)->FlushPage(page_id);
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  auto iter = page_table_.find(page_id);
+  if(iter == page_table_.end())
     return false;
-  frame_id_t frame_id_temp = page_table_[page_id];
   // 将数据页写入磁盘
-  disk_manager_->WritePage(page_id, pages_[frame_id_temp].data_);
-  pages_[frame_id_temp].is_dirty_ = false;
+  disk_manager_->WritePage(page_id, frames_[iter->second]->data_);
+  frames_[iter->second]->is_dirty_ = false;
+  flush_writes_++;
   return true;
 }
-page_id_t BufferPoolManager::AllocatePage() {
-  int next_page_id = disk_manager_->AllocatePage();
+
+frame_id_t BufferPoolManager::TryToFindFreePage() {
+  frame_id_t frame_id = INVALID_FRAME_ID;
+  // Note that pages are always found from the free list first.
+  if(!free_list_.empty()) {
+    frame_id = free_list_.front();
+    free_list_.pop_front();
+    return frame_id;
+  }
+  if(!replacer_->Victim(&frame_id))
+    return INVALID_FRAME_ID;
+  EvictFrame(frame_id);
+  return frame_id;
+}
+
+frame_id_t BufferPoolManager::TryToFindFreePage(BufferAccessStrategy *strategy, page_id_t page_id) {
+  if(strategy == nullptr)
+    return TryToFindFreePage();
+  std::scoped_lock<std::mutex> ring_lock(strategy->latch_);
+  // 环中当前槽位的页帧仍然是本分片的、仍然装着环当初读入的页且没有被固定时，直接复用该页帧
+  auto &slot = strategy->ring_[strategy->current_];
+  frame_id_t frame_id = INVALID_FRAME_ID;
+  if(slot.owner == this && slot.frame_id != INVALID_FRAME_ID && !IsRetiring(slot.frame_id)) {
+    Page &page = *frames_[slot.frame_id];
+    if(page.page_id_ == slot.page_id && page.pin_count_ == 0) {
+      frame_id = slot.frame_id;
+      replacer_->Remove(frame_id);
+      EvictFrame(frame_id);
+    }
+  }
+  if(frame_id == INVALID_FRAME_ID)
+    frame_id = TryToFindFreePage();
+  if(frame_id == INVALID_FRAME_ID)
+    return INVALID_FRAME_ID;
+  // 记录该页帧现在装着page_id，并移动到环的下一个槽位
+  slot.owner = this;
+  slot.frame_id = frame_id;
+  slot.page_id = page_id;
+  strategy->current_ = (strategy->current_ + 1) % strategy->ring_.size();
+  return frame_id;
+}
+
+void BufferPoolManager::EvictFrame(frame_id_t frame_id) {
+  // 如果找到的页是dirty的，则将其写回磁盘，并将其从page table中删除
+  Page &victim = *frames_[frame_id];
+  if(victim.IsDirty()) {
+    disk_manager_->WritePage(victim.page_id_, victim.data_);
+    victim.is_dirty_ = false;
+    sync_writes_++;
+  }
+  page_table_.erase(victim.page_id_);
+  evictions_++;
+}
+
+void BufferPoolManager::FlushAllPages() {
+  for (auto shard : shards_) {
+    shard->FlushDirtyPages();
+  }
+  FlushDirtyPages();
+  // 检查点：写回的页必须落盘
+  disk_manager_->Sync();
+}
+
+void BufferPoolManager::FlushDirtyPages() {
+  // 只读打开时没有脏页，也不能写
+  if (read_only_) {
+    return;
+  }
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  // 按页号（即物理位置）顺序写回所有脏页，干净的页不需要写
+  vector<pair<page_id_t, frame_id_t>> dirty_pages;
+  for (auto &entry : page_table_) {
+    if (frames_[entry.second]->IsDirty()) {
+      dirty_pages.emplace_back(entry);
+    }
+  }
+  sort(dirty_pages.begin(), dirty_pages.end());
+  WriteBackPages(dirty_pages);
+  flush_writes_ += dirty_pages.size();
+}
+
+void BufferPoolManager::StartBackgroundWriter(double dirty_ratio, size_t max_pages, uint32_t interval_ms) {
+  if (read_only_) {
+    return;
+  }
+  if (!shards_.empty()) {
+    for (auto shard : shards_) {
+      shard->StartBackgroundWriter(dirty_ratio, max_pages, interval_ms);
+    }
+    return;
+  }
+  if (bg_writer_.joinable()) {
+    return;
+  }
+  bg_stop_ = false;
+  bg_writer_ = thread(&BufferPoolManager::BackgroundWriterLoop, this, dirty_ratio, max_pages, interval_ms);
+}
+
+void BufferPoolManager::StopBackgroundWriter() {
+  for (auto shard : shards_) {
+    shard->StopBackgroundWriter();
+  }
+  if (!bg_writer_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(bg_mutex_);
+    bg_stop_ = true;
+  }
+  bg_cv_.notify_all();
+  bg_writer_.join();
+}
+
+void BufferPoolManager::BackgroundWriterLoop(double dirty_ratio, size_t max_pages, uint32_t interval_ms) {
+  std::unique_lock<std::mutex> lock(bg_mutex_);
+  while (!bg_stop_) {
+    lock.unlock();
+    bool busy = CleanDirtyPages(dirty_ratio, max_pages);
+    lock.lock();
+    // 脏页比例仍然超过阈值时立即开始下一轮，否则休眠一个周期
+    if (!busy) {
+      bg_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms), [this] { return bg_stop_; });
+    }
+  }
+}
+
+void BufferPoolManager::WriteBackPages(const vector<pair<page_id_t, frame_id_t>> &pages) {
+  // 一次交给磁盘，物理相邻的页合并写入，各段由异步I/O引擎并发执行，全部完成后再清除脏标记
+  vector<pair<page_id_t, const char *>> writes;
+  for (auto &entry : pages) {
+    writes.emplace_back(entry.first, frames_[entry.second]->data_);
+  }
+  disk_manager_->WritePages(std::move(writes));
+  for (auto &entry : pages) {
+    frames_[entry.second]->is_dirty_ = false;
+  }
+}
+
+bool BufferPoolManager::CleanDirtyPages(double dirty_ratio, size_t max_pages) {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  // 统计脏页比例，只挑选未被固定的脏页，被固定的页仍可能被修改
+  size_t num_dirty = 0;
+  vector<pair<page_id_t, frame_id_t>> candidates;
+  for (auto &entry : page_table_) {
+    Page &page = *frames_[entry.second];
+    if (page.IsDirty()) {
+      num_dirty++;
+      if (page.GetPinCount() == 0) {
+        candidates.emplace_back(entry);
+      }
+    }
+  }
+  if (candidates.empty() || num_dirty <= dirty_ratio * pool_size_) {
+    return false;
+  }
+  // 一批最多写max_pages个页，按页号排序使写入尽量连续
+  sort(candidates.begin(), candidates.end());
+  if (candidates.size() > max_pages) {
+    candidates.resize(max_pages);
+  }
+  WriteBackPages(candidates);
+  bg_writes_ += candidates.size();
+  return num_dirty - candidates.size() > dirty_ratio * pool_size_;
+}
+
+void BufferPoolManager::ReadAhead(page_id_t page_id, size_t num_pages,
+                                  std::function<page_id_t(const char *)> next_page_id,
+                                  std::shared_ptr<BufferAccessStrategy> strategy) {
+  // 只读模式下所有页都已经在映射中
+  if (read_only_ || page_id == INVALID_PAGE_ID || num_pages == 0) {
+    return;
+  }
+  QueuePrefetch({page_id, num_pages, std::move(next_page_id), std::move(strategy), {}});
+}
+
+void BufferPoolManager::QueuePrefetch(ReadAheadRequest request) {
+  std::lock_guard<std::mutex> lock(prefetch_mutex_);
+  if (prefetch_stop_) {
+    return;
+  }
+  if (!prefetcher_.joinable()) {
+    prefetcher_ = thread(&BufferPoolManager::PrefetchLoop, this);
+  }
+  prefetch_queue_.push_back(std::move(request));
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManager::PrefetchLoop() {
+  std::unique_lock<std::mutex> lock(prefetch_mutex_);
+  while (true) {
+    prefetch_cv_.wait(lock, [this] { return prefetch_stop_ || !prefetch_queue_.empty(); });
+    if (prefetch_stop_) {
+      return;
+    }
+    ReadAheadRequest request = std::move(prefetch_queue_.front());
+    prefetch_queue_.pop_front();
+    lock.unlock();
+    if (request.page_ids.empty()) {
+      DoReadAhead(request);
+    } else {
+      DoLoadWorkingSet(request.page_ids);
+    }
+    lock.lock();
+  }
+}
+
+void BufferPoolManager::DoReadAhead(const ReadAheadRequest &request) {
+  AlignedPages run;
+  page_id_t run_start = INVALID_PAGE_ID;
+  uint32_t run_length = 0;
+  uint64_t run_num_writes = 0;
+  bool sequential = true;
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  page_id_t page_id = request.page_id;
+  for (size_t i = 0; i < request.num_pages && page_id != INVALID_PAGE_ID && page_id <= MAX_VALID_PAGE_ID; i++) {
+    if (prev_page_id != INVALID_PAGE_ID) {
+      sequential = page_id == prev_page_id + 1;
+    }
+    prev_page_id = page_id;
+    // 已经在内存中的页只需要读出下一页的页号，不pin也不碰替换器，免得算成命中把它变热
+    page_id_t next_page_id;
+    if (PeekNextPageId(page_id, request.next_page_id, &next_page_id)) {
+      page_id = next_page_id;
+      continue;
+    }
+    // 链表上的页号连续时，一次读入本extent内剩余的若干页，否则只读一页
+    if (run_start == INVALID_PAGE_ID || page_id < run_start || page_id >= run_start + static_cast<page_id_t>(run_length)) {
+      run_start = page_id;
+      run_length = sequential ? std::min<uint32_t>(request.num_pages - i, DiskManager::GetContiguousPages(page_id)) : 1;
+      run = AllocateAlignedPages(run_length);
+      run_num_writes = disk_manager_->GetNumWrites();
+      disk_manager_->ReadPages(run_start, run_length, run.get());
+    }
+    const char *page_data = run.get() + static_cast<size_t>(page_id - run_start) * PAGE_SIZE;
+    BufferAccessStrategy *strategy = request.strategy.get();
+    bool loaded = shards_.empty() ? InstallPage(page_id, page_data, run_num_writes, strategy)
+                                  : GetShard(page_id)->InstallPage(page_id, page_data, run_num_writes, strategy);
+    if (loaded) {
+      read_ahead_pages_++;
+    }
+    page_id = request.next_page_id(page_data);
+  }
+}
+
+bool BufferPoolManager::DumpWorkingSet(const std::string &file_name) {
+  if (read_only_) {
+    return false;
+  }
+  vector<page_id_t> page_ids;
+  if (shards_.empty()) {
+    GetWorkingSet(&page_ids);
+  } else {
+    // 各分片的替换顺序互相独立，从最热的一端开始轮流取各分片的页，使合并后的顺序大致保持各页的冷热排名
+    vector<vector<page_id_t>> shard_page_ids(shards_.size());
+    size_t total = 0;
+    for (size_t i = 0; i < shards_.size(); i++) {
+      shards_[i]->GetWorkingSet(&shard_page_ids[i]);
+      total += shard_page_ids[i].size();
+    }
+    for (size_t rank = 0; page_ids.size() < total; rank++) {
+      for (auto &shard_ids : shard_page_ids) {
+        if (rank < shard_ids.size()) {
+          page_ids.push_back(shard_ids[shard_ids.size() - 1 - rank]);
+        }
+      }
+    }
+    std::reverse(page_ids.begin(), page_ids.end());
+  }
+  std::ofstream file(file_name, std::ios::out | std::ios::trunc);
+  if (!file.is_open()) {
+    LOG(ERROR) << "Can not write the working set to " << file_name;
+    return false;
+  }
+  for (auto page_id : page_ids) {
+    file << page_id << '\n';
+  }
+  file.close();
+  return !file.fail();
+}
+
+void BufferPoolManager::GetWorkingSet(vector<page_id_t> *page_ids) {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  vector<frame_id_t> frames;
+  replacer_->GetVictimOrder(&frames);
+  // 被固定的页正在使用，视为最热的页放在最后
+  for (auto &entry : page_table_) {
+    if (frames_[entry.second]->GetPinCount() > 0) {
+      frames.push_back(entry.second);
+    }
+  }
+  for (auto frame_id : frames) {
+    page_ids->push_back(frames_[frame_id]->GetPageId());
+  }
+}
+
+size_t BufferPoolManager::LoadWorkingSet(const std::string &file_name) {
+  if (read_only_) {
+    return 0;
+  }
+  std::ifstream file(file_name);
+  if (!file.is_open()) {
+    return 0;
+  }
+  vector<page_id_t> page_ids;
+  page_id_t page_id;
+  while (file >> page_id) {
+    page_ids.push_back(page_id);
+  }
+  // 从最热的页开始，只保留每个分片放得下的页，且跳过转储之后已经被释放的页
+  vector<page_id_t> hot_page_ids;
+  vector<size_t> shard_pages(GetNumInstances(), 0);
+  for (auto iter = page_ids.rbegin(); iter != page_ids.rend() && hot_page_ids.size() < pool_size_; ++iter) {
+    if (*iter < 0 || *iter > MAX_VALID_PAGE_ID || disk_manager_->IsPageFree(*iter)) {
+      continue;
+    }
+    size_t shard = shards_.empty() ? 0 : *iter % shards_.size();
+    size_t shard_size = shards_.empty() ? pool_size_ : shards_[shard]->GetPoolSize();
+    if (shard_pages[shard] < shard_size) {
+      shard_pages[shard]++;
+      hot_page_ids.push_back(*iter);
+    }
+  }
+  if (hot_page_ids.empty()) {
+    return 0;
+  }
+  std::reverse(hot_page_ids.begin(), hot_page_ids.end());
+  size_t num_pages = hot_page_ids.size();
+  QueuePrefetch({INVALID_PAGE_ID, 0, nullptr, nullptr, std::move(hot_page_ids)});
+  return num_pages;
+}
+
+void BufferPoolManager::DoLoadWorkingSet(const vector<page_id_t> &page_ids) {
+  vector<page_id_t> sorted_page_ids(page_ids);
+  std::sort(sorted_page_ids.begin(), sorted_page_ids.end());
+  sorted_page_ids.erase(std::unique(sorted_page_ids.begin(), sorted_page_ids.end()), sorted_page_ids.end());
+  // 同一个extent内页号连续的一段页用一次读入，记录每段的起始下标
+  vector<size_t> run_starts;
+  for (size_t i = 0; i < sorted_page_ids.size(); i++) {
+    if (i == 0 || sorted_page_ids[i] != sorted_page_ids[i - 1] + 1 ||
+        sorted_page_ids[i] - sorted_page_ids[run_starts.back()] >=
+            static_cast<page_id_t>(DiskManager::GetContiguousPages(sorted_page_ids[run_starts.back()]))) {
+      run_starts.push_back(i);
+    }
+  }
+  run_starts.push_back(sorted_page_ids.size());
+  // 每次把最多一个队列深度的读请求同时交给异步I/O引擎，全部完成后再装入缓冲池
+  AsyncIOEngine *async_io = disk_manager_->GetAsyncIO();
+  if (async_io == nullptr) {
+    return;
+  }
+  vector<AlignedPages> runs(ASYNC_IO_QUEUE_DEPTH);
+  for (size_t window = 0; window + 1 < run_starts.size(); window += ASYNC_IO_QUEUE_DEPTH) {
+    size_t window_end = std::min(window + ASYNC_IO_QUEUE_DEPTH, run_starts.size() - 1);
+    uint64_t window_num_writes = disk_manager_->GetNumWrites();
+    IOBatch batch;
+    for (size_t r = window; r < window_end; r++) {
+      uint32_t run_length = static_cast<uint32_t>(run_starts[r + 1] - run_starts[r]);
+      runs[r - window] = AllocateAlignedPages(run_length);
+      async_io->SubmitRead(sorted_page_ids[run_starts[r]], run_length, runs[r - window].get(), &batch);
+    }
+    batch.Wait();
+    for (size_t r = window; r < window_end; r++) {
+      for (size_t i = run_starts[r]; i < run_starts[r + 1]; i++) {
+        page_id_t page_id = sorted_page_ids[i];
+        const char *page_data = runs[r - window].get() + (i - run_starts[r]) * PAGE_SIZE;
+        bool loaded = shards_.empty() ? InstallPage(page_id, page_data, window_num_writes, nullptr)
+                                      : GetShard(page_id)->InstallPage(page_id, page_data, window_num_writes, nullptr);
+        if (loaded) {
+          read_ahead_pages_++;
+        }
+      }
+    }
+  }
+  // 按转储时从冷到热的顺序重新访问一遍，恢复替换顺序
+  for (auto page_id : page_ids) {
+    if (shards_.empty()) {
+      TouchPage(page_id);
+    } else {
+      GetShard(page_id)->TouchPage(page_id);
+    }
+  }
+}
+
+void BufferPoolManager::TouchPage(page_id_t page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  auto iter = page_table_.find(page_id);
+  if (iter == page_table_.end() || frames_[iter->second]->pin_count_ > 0 || IsRetiring(iter->second)) {
+    return;
+  }
+  replacer_->Pin(iter->second);
+  replacer_->Unpin(iter->second);
+}
+
+bool BufferPoolManager::PeekNextPageId(page_id_t page_id, const std::function<page_id_t(const char *)> &next_page_id,
+                                       page_id_t *next) {
+  if (!shards_.empty()) {
+    return GetShard(page_id)->PeekNextPageId(page_id, next_page_id, next);
+  }
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  auto it = page_table_.find(page_id);
+  if (it == page_table_.end()) {
+    return false;
+  }
+  // 持有latch时帧不会被换出，直接读帧里的数据
+  *next = next_page_id(frames_[it->second]->GetData());
+  return true;
+}
+
+bool BufferPoolManager::InstallPage(page_id_t page_id, const char *page_data, uint64_t num_writes,
+                                    BufferAccessStrategy *strategy) {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  if (page_table_.find(page_id) != page_table_.end()) {
+    return false;
+  }
+  frame_id_t frame_id = TryToFindFreePage(strategy, page_id);
+  if (frame_id == INVALID_FRAME_ID) {
+    return false;
+  }
+  Page &page = *frames_[frame_id];
+  // 读盘之后有页被写回（可能正是这一页），读到的内容可能已经过期，需要重新读取
+  if (disk_manager_->GetNumWrites() != num_writes) {
+    disk_manager_->ReadPage(page_id, page.data_);
+  } else {
+    memcpy(page.data_, page_data, PAGE_SIZE);
+  }
+  page.page_id_ = page_id;
+  page.pin_count_ = 0;
+  page.is_dirty_ = false;
+  page_table_.emplace(page_id, frame_id);
+  replacer_->Unpin(frame_id);
+  return true;
+}
+
+BufferPoolStats &BufferPoolStats::operator+=(const BufferPoolStats &other) {
+  hits += other.hits;
+  misses += other.misses;
+  evictions += other.evictions;
+  sync_writes += other.sync_writes;
+  background_writes += other.background_writes;
+  flush_writes += other.flush_writes;
+  read_ahead_pages += other.read_ahead_pages;
+  new_pages += other.new_pages;
+  deleted_pages += other.deleted_pages;
+  pinned_high_water += other.pinned_high_water;
+  pool_size += other.pool_size;
+  free_frames += other.free_frames;
+  pinned_frames += other.pinned_frames;
+  dirty_frames += other.dirty_frames;
+  table_pages += other.table_pages;
+  internal_pages += other.internal_pages;
+  leaf_pages += other.leaf_pages;
+  meta_pages += other.meta_pages;
+  return *this;
+}
+
+BufferPoolStats BufferPoolManager::GetStats() {
+  BufferPoolStats stats;
+  for (auto shard : shards_) {
+    stats += shard->GetStats();
+  }
+  // 预读计数记在负责预读的对象上（分片模式下即路由对象）
+  stats.read_ahead_pages += read_ahead_pages_;
+  if (!shards_.empty()) {
+    return stats;
+  }
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  stats.hits += hits_;
+  stats.misses += misses_;
+  stats.evictions += evictions_;
+  stats.sync_writes += sync_writes_;
+  stats.background_writes += bg_writes_;
+  stats.flush_writes += flush_writes_;
+  stats.new_pages += new_pages_;
+  stats.deleted_pages += deleted_pages_;
+  stats.pinned_high_water += pinned_high_water_;
+  stats.pool_size += pool_size_;
+  stats.free_frames += free_list_.size();
+  stats.pinned_frames += num_pinned_;
+  // 根据页头识别页的类型：B+树页的页头记录了页类型和自身页号，数据页的页头第一个字段是自身页号
+  for (auto &entry : page_table_) {
+    Page &page = *frames_[entry.second];
+    if (page.IsDirty()) {
+      stats.dirty_frames++;
+    }
+    auto *tree_page = reinterpret_cast<BPlusTreePage *>(page.GetData());
+    auto page_type = *reinterpret_cast<IndexPageType *>(page.GetData());
+    if (entry.first == CATALOG_META_PAGE_ID || entry.first == INDEX_ROOTS_PAGE_ID ||
+        FreeSpaceMapPage::IsFreeSpaceMapPage(page.GetData())) {
+      stats.meta_pages++;
+    } else if (tree_page->GetPageId() == entry.first && page_type == IndexPageType::LEAF_PAGE) {
+      stats.leaf_pages++;
+    } else if (tree_page->GetPageId() == entry.first && page_type == IndexPageType::INTERNAL_PAGE) {
+      stats.internal_pages++;
+    } else if (reinterpret_cast<TablePage *>(&page)->GetTablePageId() == entry.first) {
+      stats.table_pages++;
+    } else {
+      stats.meta_pages++;
+    }
+  }
+  return stats;
+}
+
+void BufferPoolManager::ResetStats() {
+  for (auto shard : shards_) {
+    shard->ResetStats();
+  }
+  read_ahead_pages_ = 0;
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  hits_ = misses_ = evictions_ = flush_writes_ = new_pages_ = deleted_pages_ = 0;
+  sync_writes_ = 0;
+  bg_writes_ = 0;
+  pinned_high_water_ = num_pinned_;
+}
+
+uint64_t BufferPoolManager::GetSyncWriteCount() const {
+  uint64_t count = sync_writes_;
+  for (auto shard : shards_) {
+    count += shard->GetSyncWriteCount();
+  }
+  return count;
+}
+
+uint64_t BufferPoolManager::GetBackgroundWriteCount() const {
+  uint64_t count = bg_writes_;
+  for (auto shard : shards_) {
+    count += shard->GetBackgroundWriteCount();
+  }
+  return count;
+}
+
+page_id_t BufferPoolManager::AllocatePage(ExtentReservation *reservation) {
+  int next_page_id = disk_manager_->AllocatePage(reservation);
   return next_page_id;
 }
 
@@ -237,15 +870,193 @@ void BufferPoolManager::DeallocatePage(__attribute__((unused)) page_id_t page_id
   disk_manager_->DeAllocatePage(page_id);
 }
 
+// 物理内存能放下的最多帧数，取不到时不限制
+static size_t MaxPoolSize() {
+  long num_pages = sysconf(_SC_PHYS_PAGES);
+  long page_size = sysconf(_SC_PAGESIZE);
+  if (num_pages <= 0 || page_size <= 0) {
+    return SIZE_MAX;
+  }
+  return static_cast<size_t>(num_pages) * static_cast<size_t>(page_size) / PAGE_SIZE;
+}
+
+bool BufferPoolManager::SetPoolSize(size_t pool_size) {
+  if (read_only_) {
+    return false;
+  }
+  // 超过物理内存的缓冲池要么映射失败，要么用起来被OOM杀掉
+  if (pool_size > MaxPoolSize()) {
+    LOG(WARNING) << "Buffer pool size " << pool_size << " exceeds the physical memory.";
+    return false;
+  }
+  if (!shards_.empty()) {
+    if (pool_size < shards_.size()) {
+      return false;
+    }
+    // 与构造时一样把帧平均分给各个分片
+    std::scoped_lock<std::mutex> resize_lock(resize_mutex_);
+    size_t new_pool_size = 0;
+    for (size_t i = 0; i < shards_.size(); i++) {
+      size_t shard_size = pool_size / shards_.size() + (i < pool_size % shards_.size() ? 1 : 0);
+      shards_[i]->SetPoolSize(shard_size);
+      new_pool_size += shards_[i]->GetPoolSize();
+    }
+    pool_size_ = new_pool_size;
+    return true;
+  }
+  if (pool_size == 0) {
+    return false;
+  }
+  std::scoped_lock<std::mutex> resize_lock(resize_mutex_);
+  // 上一次缩容的帧还没有释放完时，等待其完成
+  if (releaser_.joinable()) {
+    releaser_.join();
+  }
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  if (pool_size >= pool_size_) {
+    try {
+      AddFrames(pool_size - pool_size_);
+    } catch (const std::bad_alloc &) {
+      return false;
+    }
+    pool_size_ = pool_size;
+    replacer_->Resize(pool_size_);
+    return true;
+  }
+  // 只能整块释放：新的大小向上取整到块的边界
+  size_t new_pool_size = pool_size_;
+  for (auto &chunk : chunks_) {
+    if (chunk.first_frame + chunk.num_frames >= pool_size) {
+      new_pool_size = chunk.first_frame + chunk.num_frames;
+      break;
+    }
+  }
+  if (new_pool_size == pool_size_) {
+    return true;
+  }
+  // 被释放的帧立即移出free list和replacer，不会再被分配；其中的页由后台线程写回并清空
+  pool_size_ = new_pool_size;
+  free_list_.remove_if([this](frame_id_t frame_id) { return IsRetiring(frame_id); });
+  for (size_t frame_id = pool_size_; frame_id < frames_.size(); frame_id++) {
+    replacer_->Remove(static_cast<frame_id_t>(frame_id));
+  }
+  replacer_->Resize(pool_size_);
+  release_stop_ = false;
+  releaser_ = thread(&BufferPoolManager::ReleaseFrames, this);
+  return true;
+}
+
+void BufferPoolManager::AddFrames(size_t num_frames) {
+  if (num_frames == 0) {
+    return;
+  }
+  // 一次加入的所有帧的数据放在同一段映射里，按块切分，最后一块拥有映射末尾多出来的部分
+  size_t arena_size;
+  char *arena = AllocateFrameArena(num_frames * PAGE_SIZE, arena_size);
+  while (num_frames > 0) {
+    size_t chunk_size = std::min<size_t>(num_frames, BUFFER_POOL_CHUNK_SIZE);
+    size_t data_size = num_frames == chunk_size ? arena_size : chunk_size * PAGE_SIZE;
+    auto frames = static_cast<Page *>(::operator new(chunk_size * sizeof(Page)));
+    FrameChunk chunk{frames, frames_.size(), chunk_size, arena, data_size};
+    for (size_t i = 0; i < chunk_size; i++) {
+      new (&frames[i]) Page(arena + i * PAGE_SIZE);
+      free_list_.emplace_back(static_cast<frame_id_t>(frames_.size()));
+      frames_.push_back(&frames[i]);
+    }
+    chunks_.push_back(chunk);
+    num_frames -= chunk_size;
+    arena += data_size;
+    arena_size -= data_size;
+  }
+}
+
+char *BufferPoolManager::AllocateFrameArena(size_t size, size_t &mapped_size) {
+  void *arena = MAP_FAILED;
+  if (BUFFER_POOL_HUGE_PAGES) {
+    // 先尝试预留的大页，系统没有预留大页时退回普通页+透明大页
+    mapped_size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    arena = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  }
+  if (arena == MAP_FAILED) {
+    mapped_size = size;
+    arena = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (arena == MAP_FAILED) {
+      LOG(ERROR) << "Can not allocate " << size << " bytes of frames: " << strerror(errno);
+      throw std::bad_alloc();
+    }
+    if (BUFFER_POOL_HUGE_PAGES && size >= HUGE_PAGE_SIZE) {
+      madvise(arena, mapped_size, MADV_HUGEPAGE);
+    }
+  }
+  return static_cast<char *>(arena);
+}
+
+void BufferPoolManager::FreeFrameChunk(const FrameChunk &chunk) {
+  for (size_t i = 0; i < chunk.num_frames; i++) {
+    chunk.frames[i].~Page();
+  }
+  ::operator delete(chunk.frames);
+  munmap(chunk.data, chunk.data_size);
+}
+
+void BufferPoolManager::ReleaseFrames() {
+  std::unique_lock<std::mutex> release_lock(release_mutex_);
+  while (!release_stop_) {
+    release_lock.unlock();
+    bool done = true;
+    size_t num_frames;
+    {
+      std::scoped_lock<std::recursive_mutex> lock(latch_);
+      num_frames = frames_.size();
+    }
+    // 逐帧持锁，避免长时间阻塞前台的请求；被固定的帧等到下一轮再处理
+    for (size_t frame_id = pool_size_; frame_id < num_frames; frame_id++) {
+      std::scoped_lock<std::recursive_mutex> lock(latch_);
+      Page &page = *frames_[frame_id];
+      if (page.page_id_ == INVALID_PAGE_ID) {
+        continue;
+      }
+      if (page.pin_count_ > 0) {
+        done = false;
+        continue;
+      }
+      if (page.IsDirty()) {
+        disk_manager_->WritePage(page.page_id_, page.data_);
+        page.is_dirty_ = false;
+        bg_writes_++;
+      }
+      page_table_.erase(page.page_id_);
+      page.page_id_ = INVALID_PAGE_ID;
+      evictions_++;
+    }
+    if (done) {
+      std::scoped_lock<std::recursive_mutex> lock(latch_);
+      while (!chunks_.empty() && chunks_.back().first_frame >= pool_size_) {
+        FreeFrameChunk(chunks_.back());
+        chunks_.pop_back();
+      }
+      frames_.resize(pool_size_);
+      return;
+    }
+    release_lock.lock();
+    release_cv_.wait_for(release_lock, std::chrono::milliseconds(BG_WRITER_INTERVAL_MS),
+                         [this] { return release_stop_; });
+  }
+}
+
 bool BufferPoolManager::IsPageFree(page_id_t page_id) { return disk_manager_->IsPageFree(page_id); }
 
 // Only used for debug
 bool BufferPoolManager::CheckAllUnpinned() {
   bool res = true;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].pin_count_ != 0) {
+  for (auto shard : shards_) {
+    res = shard->CheckAllUnpinned() && res;
+  }
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  for (auto frame : frames_) {
+    if (frame->pin_count_ != 0) {
       res = false;
-      LOG(ERROR) << "page " << pages_[i].page_id_ << " pin count:" << pages_[i].pin_count_ << endl;
+      LOG(ERROR) << "page " << frame->page_id_ << " pin count:" << frame->pin_count_ << endl;
     }
   }
   return res;
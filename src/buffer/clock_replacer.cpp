@@ -0,0 +1,87 @@
+#include "buffer/clock_replacer.h"
+
+// num_pages 表示CLOCKReplacer需要存储的最大页数
+CLOCKReplacer::CLOCKReplacer(size_t num_pages)
+    : capacity(num_pages), in_clock(num_pages, false), ref_bits(num_pages, false) {}
+
+CLOCKReplacer::~CLOCKReplacer() = default;
+
+// 转动时钟指针：引用位为1的页帧清零后跳过，遇到第一个引用位为0的可替换页帧即为victim
+// 最多转两圈：第一圈清空所有引用位，第二圈必定能找到victim
+bool CLOCKReplacer::Victim(frame_id_t *frame_id) {
+  if(num_victims == 0) {
+    return false;
+  }
+  while(true) {
+    if(in_clock[hand]) {
+      if(!ref_bits[hand]) {
+        *frame_id = static_cast<frame_id_t>(hand);
+        in_clock[hand] = false;
+        num_victims--;
+        hand = (hand + 1) % in_clock.size();
+        return true;
+      }
+      ref_bits[hand] = false;
+    }
+    hand = (hand + 1) % in_clock.size();
+  }
+}
+
+// 固定页帧：仅清除可替换标记，不需要移动任何链表节点
+void CLOCKReplacer::Pin(frame_id_t frame_id) {
+  if(frame_id < 0 || static_cast<size_t>(frame_id) >= in_clock.size() || !in_clock[frame_id]) {
+    return;
+  }
+  in_clock[frame_id] = false;
+  num_victims--;
+}
+
+// 解除固定：标记为可替换并置引用位，表示该页帧最近被访问过
+void CLOCKReplacer::Unpin(frame_id_t frame_id) {
+  if(frame_id < 0) {
+    return;
+  }
+  if(static_cast<size_t>(frame_id) >= in_clock.size()) {
+    in_clock.resize(frame_id + 1, false);
+    ref_bits.resize(frame_id + 1, false);
+  }
+  ref_bits[frame_id] = true;
+  if(in_clock[frame_id] || num_victims >= capacity) {
+    return;
+  }
+  in_clock[frame_id] = true;
+  num_victims++;
+}
+
+// 移除页帧：除了移出时钟，还要清掉引用位，之后装入的页不继承这一次“第二次机会”
+void CLOCKReplacer::Remove(frame_id_t frame_id) {
+  Pin(frame_id);
+  if(frame_id >= 0 && static_cast<size_t>(frame_id) < ref_bits.size()) {
+    ref_bits[frame_id] = false;
+  }
+}
+
+size_t CLOCKReplacer::Size() {
+  return num_victims;
+}
+
+// 从时钟指针开始：引用位为0的页帧在第一圈就会被替换，引用位为1的要等到第二圈
+void CLOCKReplacer::GetVictimOrder(std::vector<frame_id_t> *frames) {
+  for(bool ref : {false, true}) {
+    for(size_t i = 0; i < in_clock.size(); i++) {
+      size_t frame = (hand + i) % in_clock.size();
+      if(in_clock[frame] && ref_bits[frame] == ref) {
+        frames->push_back(static_cast<frame_id_t>(frame));
+      }
+    }
+  }
+}
+
+// 缩小时不截断数组，被释放的页帧已经不在时钟中，指针扫过时会直接跳过
+void CLOCKReplacer::Resize(size_t num_pages) {
+  capacity = num_pages;
+  if(num_pages > in_clock.size()) {
+    in_clock.resize(num_pages, false);
+    ref_bits.resize(num_pages, false);
+  }
+}
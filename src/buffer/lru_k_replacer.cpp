@@ -0,0 +1,106 @@
+#include "buffer/lru_k_replacer.h"
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, size_t correlated_period)
+    : num_pages(num_pages), k_(k == 0 ? 1 : k), correlated_period_(correlated_period), frames_(num_pages) {}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+// 访问历史不足K次的页帧，其backward K-distance视为无穷大，按最近一次访问时间排在最前面；
+// 其余页帧按第K次最近访问的时间排序
+LRUKReplacer::VictimKey LRUKReplacer::GetKey(frame_id_t frame_id) const {
+  const FrameHistory &frame = frames_[frame_id];
+  if(frame.history.size() < k_) {
+    return VictimKey(false, frame.last_access, frame_id);
+  }
+  return VictimKey(true, frame.history.back(), frame_id);
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  FrameHistory &frame = frames_[frame_id];
+  current_time_++;
+  // 与上一次访问间隔在相关访问周期内，视为同一次访问，只更新最近访问时间
+  if(!frame.history.empty() && current_time_ - frame.last_access <= correlated_period_) {
+    frame.last_access = current_time_;
+    return;
+  }
+  frame.history.push_front(current_time_);
+  if(frame.history.size() > k_) {
+    frame.history.pop_back();
+  }
+  frame.last_access = current_time_;
+}
+
+// 替换backward K-distance最大的页帧，并清空其访问历史（该页帧将装入新的数据页）
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  if(victims.empty()) {
+    return false;
+  }
+  *frame_id = get<2>(*victims.begin());
+  victims.erase(victims.begin());
+  frames_[*frame_id] = FrameHistory();
+  return true;
+}
+
+// Buffer Pool命中时调用，记录一次访问并将页帧移出victims
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  if(frame_id < 0) {
+    return;
+  }
+  if(static_cast<size_t>(frame_id) >= frames_.size()) {
+    frames_.resize(frame_id + 1);
+  }
+  FrameHistory &frame = frames_[frame_id];
+  if(frame.evictable) {
+    victims.erase(GetKey(frame_id));
+    frame.evictable = false;
+  }
+  RecordAccess(frame_id);
+}
+
+// 页帧的引用计数降为0时调用。新装入的页帧不会经过Pin，此时记录其第一次访问
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  if(frame_id < 0) {
+    return;
+  }
+  if(static_cast<size_t>(frame_id) >= frames_.size()) {
+    frames_.resize(frame_id + 1);
+  }
+  FrameHistory &frame = frames_[frame_id];
+  if(frame.evictable || victims.size() >= num_pages) {
+    return;
+  }
+  if(frame.history.empty()) {
+    RecordAccess(frame_id);
+  }
+  frame.evictable = true;
+  victims.insert(GetKey(frame_id));
+}
+
+// 页帧中的页被删除或页帧被释放时调用。不是一次访问，移出victims并清空访问历史，之后装入的页从头计数
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  if(frame_id < 0 || static_cast<size_t>(frame_id) >= frames_.size()) {
+    return;
+  }
+  if(frames_[frame_id].evictable) {
+    victims.erase(GetKey(frame_id));
+  }
+  frames_[frame_id] = FrameHistory();
+}
+
+size_t LRUKReplacer::Size() {
+  return victims.size();
+}
+
+// victims已经按被替换的先后排好序
+void LRUKReplacer::GetVictimOrder(std::vector<frame_id_t> *frames) {
+  for(const auto &key : victims) {
+    frames->push_back(get<2>(key));
+  }
+}
+
+void LRUKReplacer::Resize(size_t num_pages) {
+  this->num_pages = num_pages;
+  if(num_pages > frames_.size()) {
+    frames_.resize(num_pages);
+  }
+}
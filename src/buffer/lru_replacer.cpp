@@ -2,7 +2,7 @@
 
 // num_pages the maximum number of pages the LRUReplacer will be required to store
 // num_pages 表示LRUReplacer需要存储的最大页数
-LRUReplacer::LRUReplacer(size_t num_pages){
+LRUReplacer::LRUReplacer(size_t num_pages) : victims_map(num_pages), in_victims(num_pages, false) {
   this->num_pages = num_pages;
 }
 
@@ -23,6 +23,7 @@ bool LRUReplacer::Victim(frame_id_t *frame_id) {
     *frame_id = victims.back();
     // 删除该页帧号
     victims.pop_back();
+    in_victims[*frame_id] = false;
     return true;
   }
 }
@@ -32,13 +33,12 @@ bool LRUReplacer::Victim(frame_id_t *frame_id) {
 // 将数据页固定使之不能被Replacer替换，即从lru_list_中移除该数据页对应的页帧。
 // Pin函数应当在一个数据页被Buffer Pool Manager固定时被调用
 void LRUReplacer::Pin(frame_id_t frame_id) {
-  // 遍历lru_list，移除该数据页对应的页帧
-  for(auto it = victims.begin(); it != victims.end(); it++) {
-    if(*it == frame_id) {
-      victims.erase(it);
-      break;
-    }
+  // 通过victims_map直接定位该页帧在lru_list中的位置并移除，O(1)
+  if(frame_id < 0 || static_cast<size_t>(frame_id) >= in_victims.size() || !in_victims[frame_id]) {
+    return;
   }
+  victims.erase(victims_map[frame_id]);
+  in_victims[frame_id] = false;
 }
 
 /**
@@ -51,17 +51,26 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
   if(victims.size() >= num_pages) {
     return;
   }
+  if(frame_id < 0) {
+    return;
+  }
+  if(static_cast<size_t>(frame_id) >= in_victims.size()) {
+    victims_map.resize(frame_id + 1);
+    in_victims.resize(frame_id + 1, false);
+  }
   // 如果当前数据页对应的页帧已经在lru_list中，则直接返回
-  // if(std::find(victims.begin(), victims.end(), frame_id) != victims.end()) {
-  //   return;
-  // }
-  for(auto it = victims.begin(); it != victims.end(); it++) {
-    if(*it == frame_id) {
-      return;
-    }
+  if(in_victims[frame_id]) {
+    return;
   }
-  // 将数据页对应的页帧放入lru_list中
+  // 将数据页对应的页帧放入lru_list中，并记录其位置
   victims.push_front(frame_id);
+  victims_map[frame_id] = victims.begin();
+  in_victims[frame_id] = true;
+}
+
+// LRU不记录访问历史，移除页帧和Pin一样
+void LRUReplacer::Remove(frame_id_t frame_id) {
+  Pin(frame_id);
 }
 
 /**
@@ -70,4 +79,17 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
 // LRUReplacer::Size()：此方法返回当前LRUReplacer中能够被替换的数据页的数量
 size_t LRUReplacer::Size() {
   return victims.size();
-}
\ No newline at end of file
+}
+
+// 链表尾部是最近最少使用的页帧，从尾部向头部依次输出即为被替换的先后顺序
+void LRUReplacer::GetVictimOrder(std::vector<frame_id_t> *frames) {
+  frames->insert(frames->end(), victims.rbegin(), victims.rend());
+}
+
+void LRUReplacer::Resize(size_t num_pages) {
+  this->num_pages = num_pages;
+  if(num_pages > in_victims.size()) {
+    victims_map.resize(num_pages);
+    in_victims.resize(num_pages, false);
+  }
+}
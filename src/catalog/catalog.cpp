@@ -111,6 +111,7 @@ CatalogManager::CatalogManager(BufferPoolManager *buffer_pool_manager, LockManag
 }
 
 CatalogManager::~CatalogManager() {
+  StopAutoVacuum();
   FlushCatalogMetaPage();
   delete catalog_meta_;
   for (auto iter : tables_) {
@@ -126,6 +127,12 @@ CatalogManager::~CatalogManager() {
  */
 dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schema, Txn *txn, TableInfo *&table_info) {
   // ASSERT(false, "Not Implemented yet");
+  // 只读打开的数据库不能修改目录
+  if(buffer_pool_manager_->IsReadOnly()) {
+    return DB_FAILED;
+  }
+  // 后台 vacuum 遍历 tables_ 时不能插入
+  std::lock_guard<std::mutex> guard(vacuum_latch_);
   // 先检查 table_name是否已经存在
   if(table_names_.find(table_name) != table_names_.end()) {
     return DB_ALREADY_EXIST;
@@ -201,6 +208,9 @@ dberr_t CatalogManager::GetTables(vector<TableInfo *> &tables) const {
 dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string &index_name,
                                     const std::vector<std::string> &index_keys, Txn *txn, IndexInfo *&index_info,
                                     const string &index_type) {
+  if(buffer_pool_manager_->IsReadOnly()) {
+    return DB_FAILED;
+  }
   // 1. 检查table_name是否存在
   if(table_names_.find(table_name) == table_names_.end()) {
     return DB_TABLE_NOT_EXIST;
@@ -319,6 +329,10 @@ dberr_t CatalogManager::GetTableIndexes(const std::string &table_name, std::vect
  * TODO: Student Implement
  */
 dberr_t CatalogManager::DropTable(const string &table_name) {
+  if(buffer_pool_manager_->IsReadOnly())
+    return DB_FAILED;
+  // 等正在进行的 vacuum 结束再释放表
+  std::lock_guard<std::mutex> guard(vacuum_latch_);
   // 1. 检查table_name是否存在
   if(table_names_.find(table_name) == table_names_.end())
     return DB_TABLE_NOT_EXIST;
@@ -339,6 +353,8 @@ dberr_t CatalogManager::DropTable(const string &table_name) {
   index_names_.erase(table_name);
   buffer_pool_manager_->DeletePage(catalog_meta_->table_meta_pages_.at(table_id));
   catalog_meta_->table_meta_pages_.erase(table_id);
+  // 一次性释放table_heap的所有数据页
+  table_info->GetTableHeap()->FreeTableHeap();
 
   tables_.erase(table_id);
   table_names_.erase(table_name);
@@ -350,6 +366,8 @@ dberr_t CatalogManager::DropTable(const string &table_name) {
  * TODO: Student Implement
  */
 dberr_t CatalogManager::DropIndex(const string &table_name, const string &index_name) {
+  if(buffer_pool_manager_->IsReadOnly())
+    return DB_FAILED;
   // indexes_ 是一个map，key是index_id，value是index_info
   // index_names_ 是一个map，key是table_name，value是index_name和index_id的map
   // 1. 检查table_name是否存在
@@ -364,6 +382,10 @@ dberr_t CatalogManager::DropIndex(const string &table_name, const string &index_
   // 3. 通过table_name和index_name找到index_id
   auto index_id = map_index.find(index_name)->second;
   index_names_[table_name].erase(index_name);
+  // 一次性释放b+树的所有页
+  IndexInfo *index_info = indexes_[index_id];
+  index_info->GetIndex()->Destroy();
+  delete index_info;
   indexes_.erase(index_id);
   auto catalog_meta_page = buffer_pool_manager_->FetchPage(CATALOG_META_PAGE_ID);
   buffer_pool_manager_->DeletePage(catalog_meta_->index_meta_pages_[index_id]);
@@ -452,3 +474,54 @@ dberr_t CatalogManager::GetTable(const table_id_t table_id, TableInfo *&table_in
   table_info = tables_.find(table_id)->second;
   return DB_SUCCESS;
 }
+
+dberr_t CatalogManager::VacuumTable(const string &table_name, VacuumStats &stats) {
+  if (buffer_pool_manager_->IsReadOnly()) {
+    return DB_FAILED;
+  }
+  std::lock_guard<std::mutex> guard(vacuum_latch_);
+  auto it = table_names_.find(table_name);
+  if (it == table_names_.end()) {
+    return DB_TABLE_NOT_EXIST;
+  }
+  stats = tables_[it->second]->GetTableHeap()->Vacuum(nullptr);
+  return DB_SUCCESS;
+}
+
+void CatalogManager::StartAutoVacuum(uint32_t min_dead_tuples, uint32_t interval_ms) {
+  if (buffer_pool_manager_->IsReadOnly() || autovacuum_.joinable()) {
+    return;
+  }
+  autovacuum_stop_ = false;
+  autovacuum_ = std::thread(&CatalogManager::AutoVacuumLoop, this, min_dead_tuples, interval_ms);
+}
+
+void CatalogManager::StopAutoVacuum() {
+  if (!autovacuum_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(autovacuum_mutex_);
+    autovacuum_stop_ = true;
+  }
+  autovacuum_cv_.notify_all();
+  autovacuum_.join();
+}
+
+void CatalogManager::AutoVacuumLoop(uint32_t min_dead_tuples, uint32_t interval_ms) {
+  std::unique_lock<std::mutex> lock(autovacuum_mutex_);
+  while (!autovacuum_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms), [this] { return autovacuum_stop_; })) {
+    lock.unlock();
+    {
+      std::lock_guard<std::mutex> guard(vacuum_latch_);
+      for (auto &entry : tables_) {
+        TableHeap *table_heap = entry.second->GetTableHeap();
+        // 扫描在两行之间不 pin 页，后台只回收页内的空间，空页留给 vacuum 语句释放
+        if (table_heap->GetDeadTupleCount() >= min_dead_tuples) {
+          table_heap->Vacuum(nullptr, false);
+        }
+      }
+    }
+    lock.lock();
+  }
+}
@@ -1,20 +1,21 @@
 #include "catalog/indexes.h"
 
 IndexMetadata::IndexMetadata(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                             const std::vector<uint32_t> &key_map)
-    : index_id_(index_id), index_name_(index_name), table_id_(table_id), key_map_(key_map) {}
+                             const std::vector<uint32_t> &key_map, KeyFormat key_format)
+    : index_id_(index_id), index_name_(index_name), table_id_(table_id), key_map_(key_map), key_format_(key_format) {}
 
 IndexMetadata *IndexMetadata::Create(const index_id_t index_id, const string &index_name, const table_id_t table_id,
-                                     const vector<uint32_t> &key_map) {
-  return new IndexMetadata(index_id, index_name, table_id, key_map);
+                                     const vector<uint32_t> &key_map, KeyFormat key_format) {
+  return new IndexMetadata(index_id, index_name, table_id, key_map, key_format);
 }
 
 uint32_t IndexMetadata::SerializeTo(char *buf) const {
   char *p = buf;
   uint32_t ofs = GetSerializedSize();
   ASSERT(ofs <= PAGE_SIZE, "Failed to serialize index info.");
-  // magic num
-  MACH_WRITE_UINT32(buf, INDEX_METADATA_MAGIC_NUM);
+  // magic num，同时记录键的格式
+  MACH_WRITE_UINT32(buf, key_format_ == KeyFormat::kNormalized ? INDEX_METADATA_NORMALIZED_MAGIC_NUM
+                                                                : INDEX_METADATA_MAGIC_NUM);
   buf += 4;
   // index id
   MACH_WRITE_TO(index_id_t, buf, index_id_);
@@ -60,7 +61,10 @@ uint32_t IndexMetadata::DeserializeFrom(char *buf, IndexMetadata *&index_meta) {
   // magic num
   uint32_t magic_num = MACH_READ_UINT32(buf);
   buf += 4;
-  ASSERT(magic_num == INDEX_METADATA_MAGIC_NUM, "Failed to deserialize index info.");
+  ASSERT(magic_num == INDEX_METADATA_MAGIC_NUM || magic_num == INDEX_METADATA_NORMALIZED_MAGIC_NUM,
+         "Failed to deserialize index info.");
+  // 旧的索引存的是行格式的键
+  KeyFormat key_format = magic_num == INDEX_METADATA_NORMALIZED_MAGIC_NUM ? KeyFormat::kNormalized : KeyFormat::kRow;
   // index id
   index_id_t index_id = MACH_READ_FROM(index_id_t, buf);
   buf += 4;
@@ -83,7 +87,7 @@ uint32_t IndexMetadata::DeserializeFrom(char *buf, IndexMetadata *&index_meta) {
     key_map.push_back(key_index);
   }
   // allocate space for index meta data
-  index_meta = new IndexMetadata(index_id, index_name, table_id, key_map);
+  index_meta = new IndexMetadata(index_id, index_name, table_id, key_map, key_format);
   return buf - p;
 }
 
@@ -98,6 +102,11 @@ Index *IndexInfo::CreateIndex(BufferPoolManager *buffer_pool_manager, const stri
     if(col->GetType() == TypeId::kTypeChar)max_size += 4;
     max_size += col->GetLength();
   }
+  // 规范化的键每列一个空标记，没有列数和char长度，列多的时候可能更长
+  // 行格式的索引不能算上它，否则已有索引重新打开时键长类别会变，和页里存的键长对不上
+  if (meta_data_->key_format_ == KeyFormat::kNormalized) {
+    max_size = std::max<size_t>(max_size, KeyManager::GetNormalizedKeySize(key_schema_));
+  }
 
   if (index_type == "bptree") {
     if (max_size <= 8)
@@ -117,5 +126,22 @@ Index *IndexInfo::CreateIndex(BufferPoolManager *buffer_pool_manager, const stri
   } else {
     return nullptr;
   }
-  return new BPlusTreeIndex(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager);
+  // 按键长的类别选用对应的模板实例，页里的键偏移和键拷贝在编译期确定
+  switch (max_size) {
+    case 16:
+      return new BPlusTreeIndex<16>(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager,
+                                    meta_data_->key_format_);
+    case 32:
+      return new BPlusTreeIndex<32>(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager,
+                                    meta_data_->key_format_);
+    case 64:
+      return new BPlusTreeIndex<64>(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager,
+                                    meta_data_->key_format_);
+    case 128:
+      return new BPlusTreeIndex<128>(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager,
+                                     meta_data_->key_format_);
+    default:
+      return new BPlusTreeIndex<256>(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager,
+                                     meta_data_->key_format_);
+  }
 }
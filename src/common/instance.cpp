@@ -3,16 +3,23 @@
 //
 #include "common/instance.h"
 
-DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size)
-    : db_file_name_(std::move(db_name)), init_(init) {
+DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size,
+                                 uint32_t buffer_pool_instances, ReplacerType replacer_type, bool direct_io,
+                                 bool read_only, bool auto_vacuum)
+    : db_name_(db_name), db_file_name_(std::move(db_name)), init_(init) {
   // Init database file if needed
   db_file_name_ = "./databases/" + db_file_name_;
+  if (read_only && init_) {
+    throw logic_error("Can not initialize a database opened read only.");
+  }
   if (init_) {
     remove(db_file_name_.c_str());
+    remove(GetWorkingSetFileName(db_name_).c_str());
   }
   // Initialize components
-  disk_mgr_ = new DiskManager(db_file_name_);
-  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_);
+  disk_mgr_ = new DiskManager(db_file_name_, direct_io, read_only);
+  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_, buffer_pool_instances, replacer_type);
+  bpm_->StartBackgroundWriter();
 
   // Allocate static page for db storage engine
   if (init) {
@@ -39,14 +46,27 @@ DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer
     ASSERT(!bpm_->IsPageFree(INDEX_ROOTS_PAGE_ID), "Invalid header page.");
   }
   catalog_mgr_ = new CatalogManager(bpm_, nullptr, nullptr, init);
+  if (auto_vacuum) {
+    catalog_mgr_->StartAutoVacuum();
+  }
+  // 上次正常关闭时保存了缓冲池中的页，在后台按物理顺序把它们读回来
+  if (!init_) {
+    bpm_->LoadWorkingSet(GetWorkingSetFileName(db_name_));
+  }
 }
 
 DBStorageEngine::~DBStorageEngine() {
   delete catalog_mgr_;
+  bpm_->DumpWorkingSet(GetWorkingSetFileName(db_name_));
   delete bpm_;
   delete disk_mgr_;
 }
 
+std::string DBStorageEngine::GetWorkingSetFileName(const std::string &db_name) {
+  // 以.开头，列出数据库目录时不会被当成数据库
+  return "./databases/." + db_name + WORKING_SET_FILE_SUFFIX;
+}
+
 std::unique_ptr<ExecuteContext> DBStorageEngine::MakeExecuteContext(Txn *txn) {
   return std::make_unique<ExecuteContext>(txn, catalog_mgr_, bpm_);
 }
@@ -144,6 +144,12 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
       return ExecuteExecfile(ast, context.get());
     case kNodeQuit:
       return ExecuteQuit(ast, context.get());
+    case kNodeShowBufferStatus:
+      return ExecuteShowBufferStatus(ast, context.get());
+    case kNodeSetVariable:
+      return ExecuteSetVariable(ast, context.get());
+    case kNodeVacuum:
+      return ExecuteVacuum(ast, context.get());
     default:
       break;
   }
@@ -263,9 +269,10 @@ dberr_t ExecuteEngine::ExecuteDropDatabase(pSyntaxNode ast, ExecuteContext *cont
   if (dbs_.find(db_name) == dbs_.end()) {
     return DB_NOT_EXIST;
   }
-  remove(("./databases/" + db_name).c_str());
   delete dbs_[db_name];
   dbs_.erase(db_name);
+  remove(("./databases/" + db_name).c_str());
+  remove(DBStorageEngine::GetWorkingSetFileName(db_name).c_str());
   if (db_name == current_db_) current_db_ = "";
   return DB_SUCCESS;
 }
@@ -599,3 +606,157 @@ dberr_t ExecuteEngine::ExecuteQuit(pSyntaxNode ast, ExecuteContext *context) {
   return DB_QUIT;
 }
 
+dberr_t ExecuteEngine::ExecuteShowBufferStatus(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteShowBufferStatus" << std::endl;
+#endif
+  if (current_db_.empty()) {
+    cout << "No database selected" << endl;
+    return DB_FAILED;
+  }
+  BufferPoolManager *bpm = dbs_[current_db_]->bpm_;
+  BufferPoolStats stats = bpm->GetStats();
+  stringstream ratio;
+  ratio << fixed << setprecision(4) << stats.HitRatio();
+  vector<pair<string, string>> rows = {
+      {"pool_size", to_string(stats.pool_size)},
+      {"pool_instances", to_string(bpm->GetNumInstances())},
+      {"free_frames", to_string(stats.free_frames)},
+      {"pinned_frames", to_string(stats.pinned_frames)},
+      {"pinned_high_water", to_string(stats.pinned_high_water)},
+      {"dirty_frames", to_string(stats.dirty_frames)},
+      {"table_pages", to_string(stats.table_pages)},
+      {"index_internal_pages", to_string(stats.internal_pages)},
+      {"index_leaf_pages", to_string(stats.leaf_pages)},
+      {"meta_pages", to_string(stats.meta_pages)},
+      {"hits", to_string(stats.hits)},
+      {"misses", to_string(stats.misses)},
+      {"hit_ratio", ratio.str()},
+      {"evictions", to_string(stats.evictions)},
+      {"sync_writes", to_string(stats.sync_writes)},
+      {"background_writes", to_string(stats.background_writes)},
+      {"flush_writes", to_string(stats.flush_writes)},
+      {"read_ahead_pages", to_string(stats.read_ahead_pages)},
+      {"new_pages", to_string(stats.new_pages)},
+      {"deleted_pages", to_string(stats.deleted_pages)}};
+  // 第一列为变量名，第二列为值，列宽取两列中最长的内容
+  vector<int> width{static_cast<int>(strlen("Variable_name")), static_cast<int>(strlen("Value"))};
+  for (const auto &row : rows) {
+    width[0] = max(width[0], static_cast<int>(row.first.length()));
+    width[1] = max(width[1], static_cast<int>(row.second.length()));
+  }
+  stringstream ss;
+  ResultWriter writer(ss);
+  writer.Divider(width);
+  writer.BeginRow();
+  writer.WriteHeaderCell("Variable_name", width[0]);
+  writer.WriteHeaderCell("Value", width[1]);
+  writer.EndRow();
+  writer.Divider(width);
+  for (const auto &row : rows) {
+    writer.BeginRow();
+    writer.WriteCell(row.first, width[0]);
+    writer.WriteCell(row.second, width[1]);
+    writer.EndRow();
+  }
+  writer.Divider(width);
+  std::cout << writer.stream_.rdbuf();
+  return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::ExecuteSetVariable(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteSetVariable" << std::endl;
+#endif
+  string name = ast->child_->val_;
+  string value = ast->child_->next_->val_;
+  if (name != "buffer_pool_size") {
+    cout << "Unknown system variable '" << name << "'" << endl;
+    return DB_FAILED;
+  }
+  if (current_db_.empty()) {
+    cout << "No database selected" << endl;
+    return DB_FAILED;
+  }
+  // 缓冲池大小以页为单位，必须是正整数
+  if (value.find_first_not_of("0123456789") != string::npos || value.length() > 9) {
+    cout << "Incorrect value '" << value << "' for variable '" << name << "'" << endl;
+    return DB_FAILED;
+  }
+  if (!dbs_[current_db_]->bpm_->SetPoolSize(stoul(value))) {
+    cout << "Incorrect value '" << value << "' for variable '" << name << "'" << endl;
+    return DB_FAILED;
+  }
+  return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::ExecuteVacuum(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteVacuum" << std::endl;
+#endif
+  if (current_db_.empty()) {
+    cout << "No database selected" << endl;
+    return DB_FAILED;
+  }
+  CatalogManager *catalog = dbs_[current_db_]->catalog_mgr_;
+  // 不带表名时 vacuum 所有表
+  vector<string> table_names;
+  if (ast->child_ != nullptr) {
+    table_names.emplace_back(ast->child_->val_);
+  } else {
+    vector<TableInfo *> tables;
+    catalog->GetTables(tables);
+    for (auto table : tables) {
+      table_names.push_back(table->GetTableName());
+    }
+    sort(table_names.begin(), table_names.end());
+  }
+  vector<vector<string>> rows;
+  VacuumStats total;
+  for (const auto &table_name : table_names) {
+    VacuumStats stats;
+    dberr_t result = catalog->VacuumTable(table_name, stats);
+    if (result == DB_TABLE_NOT_EXIST) {
+      cout << "Table '" << table_name << "' doesn't exist" << endl;
+      return result;
+    }
+    if (result != DB_SUCCESS) {
+      cout << "Can not vacuum table '" << table_name << "'" << endl;
+      return result;
+    }
+    total += stats;
+    rows.push_back({table_name, to_string(stats.pages_scanned), to_string(stats.tuples_removed),
+                    to_string(stats.bytes_reclaimed), to_string(stats.pages_freed)});
+  }
+  vector<string> header{"Table", "Pages_scanned", "Tuples_removed", "Bytes_reclaimed", "Pages_freed"};
+  vector<int> width;
+  for (const auto &name : header) {
+    width.push_back(static_cast<int>(name.length()));
+  }
+  for (const auto &row : rows) {
+    for (size_t i = 0; i < row.size(); i++) {
+      width[i] = max(width[i], static_cast<int>(row[i].length()));
+    }
+  }
+  stringstream ss;
+  ResultWriter writer(ss);
+  writer.Divider(width);
+  writer.BeginRow();
+  for (size_t i = 0; i < header.size(); i++) {
+    writer.WriteHeaderCell(header[i], width[i]);
+  }
+  writer.EndRow();
+  writer.Divider(width);
+  for (const auto &row : rows) {
+    writer.BeginRow();
+    for (size_t i = 0; i < row.size(); i++) {
+      writer.WriteCell(row[i], width[i]);
+    }
+    writer.EndRow();
+  }
+  writer.Divider(width);
+  std::cout << writer.stream_.rdbuf();
+  cout << total.tuples_removed << " row(s) and " << total.pages_freed << " page(s) reclaimed, "
+       << total.bytes_reclaimed << " bytes" << endl;
+  return DB_SUCCESS;
+}
@@ -4,6 +4,9 @@
 
 #include "executor/executors/insert_executor.h"
 
+#include <string>
+#include <unordered_set>
+
 InsertExecutor::InsertExecutor(ExecuteContext *exec_ctx, const InsertPlanNode *plan,
                                std::unique_ptr<AbstractExecutor> &&child_executor)
     : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
@@ -13,41 +16,61 @@ void InsertExecutor::Init() {
   exec_ctx_->GetCatalog()->GetTable(plan_->GetTableName(), table_info_);
   schema_ = table_info_->GetSchema();
   exec_ctx_->GetCatalog()->GetTableIndexes(table_info_->GetTableName(), index_info_);
+  is_inserted_ = false;
+  num_inserted_ = 0;
+  cursor_ = 0;
 }
 
 bool InsertExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
-  // Row insert_row;
-  // RowId insert_rid;
-  // if (child_executor_->Next(&insert_row, &insert_rid)) {
-  //   if (table_info_->GetTableHeap()->InsertTuple(insert_row, exec_ctx_->GetTransaction())) {
-  //     Row key_row;
-  //     for (auto info : index_info_) {  // 更新索引
-  //       insert_row.GetKeyFromRow(schema_, info->GetIndexKeySchema(), key_row);
-  //       info->GetIndex()->InsertEntry(key_row, insert_rid, exec_ctx_->GetTransaction());
-  //     }
-  //     return true;
-  //   }
+  // 第一次调用时把子执行器的所有行一次性插入，之后每次返回一行插入成功的计数
+  if (!is_inserted_) {
+    is_inserted_ = true;
+    InsertAll();
+  }
+  if (cursor_ < num_inserted_) {
+    cursor_++;
+    return true;
+  }
+  return false;
+}
+
+void InsertExecutor::InsertAll() {
+  std::vector<Row> insert_rows;
   Row insert_row;
   RowId insert_rid;
-  if (child_executor_->Next(&insert_row, &insert_rid)) {
-    for (auto info: index_info_) {
-        Row key_row;
-        insert_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), key_row);
-        std::vector<RowId> result;
-        if (!key_row.GetFields().empty() &&
-            info->GetIndex()->ScanKey(key_row, result, exec_ctx_->GetTransaction()) == DB_SUCCESS) {
-            std::cout << "key already exists" << std::endl;
-            return false;
-        }
+  while (child_executor_->Next(&insert_row, &insert_rid)) {
+    insert_rows.push_back(insert_row);
+  }
+  // 唯一键检查：既要和索引中已有的键比较，也要和同一批中前面的行比较，遇到重复键只插入它前面的行
+  std::vector<std::unordered_set<std::string>> batch_keys(index_info_.size());
+  size_t num_rows = 0;
+  for (; num_rows < insert_rows.size(); num_rows++) {
+    bool is_duplicate = false;
+    for (size_t i = 0; i < index_info_.size() && !is_duplicate; i++) {
+      Row key_row;
+      auto key_schema = index_info_[i]->GetIndexKeySchema();
+      insert_rows[num_rows].GetKeyFromRow(schema_, key_schema, key_row);
+      if (key_row.GetFields().empty()) {
+        continue;
+      }
+      std::vector<RowId> result;
+      std::string key(key_row.GetSerializedSize(key_schema), '\0');
+      key_row.SerializeTo(key.data(), key_schema);
+      is_duplicate = index_info_[i]->GetIndex()->ScanKey(key_row, result, exec_ctx_->GetTransaction()) == DB_SUCCESS ||
+                     !batch_keys[i].insert(std::move(key)).second;
     }
-    if (table_info_->GetTableHeap()->InsertTuple(insert_row, exec_ctx_->GetTransaction())) {
-        Row key_row;
-        for (auto info: index_info_) {  // 更新索引
-            insert_row.GetKeyFromRow(schema_, info->GetIndexKeySchema(), key_row);
-            info->GetIndex()->InsertEntry(key_row, insert_row.GetRowId(), exec_ctx_->GetTransaction());
-        }
-        return true;
+    if (is_duplicate) {
+      std::cout << "key already exists" << std::endl;
+      break;
     }
   }
-  return false;
-}
\ No newline at end of file
+  insert_rows.resize(num_rows);
+  num_inserted_ = table_info_->GetTableHeap()->InsertTuples(insert_rows, exec_ctx_->GetTransaction());
+  for (size_t i = 0; i < num_inserted_; i++) {  // 更新索引
+    for (auto info : index_info_) {
+      Row key_row;
+      insert_rows[i].GetKeyFromRow(schema_, info->GetIndexKeySchema(), key_row);
+      info->GetIndex()->InsertEntry(key_row, insert_rows[i].GetRowId(), exec_ctx_->GetTransaction());
+    }
+  }
+}
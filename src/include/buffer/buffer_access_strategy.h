@@ -0,0 +1,55 @@
+#ifndef MINISQL_BUFFER_ACCESS_STRATEGY_H
+#define MINISQL_BUFFER_ACCESS_STRATEGY_H
+
+#include <mutex>
+#include <vector>
+
+#include "common/config.h"
+
+using namespace std;
+
+class BufferPoolManager;
+
+/**
+ * Access patterns that should not go through the shared replacement policy.
+ */
+enum class AccessStrategyType {
+  kBulkRead,  // large sequential scans, e.g. full table scans and index backfills
+  kBulkWrite  // bulk inserts
+};
+
+/**
+ * BufferAccessStrategy confines the pages loaded by one large operation to a small private ring of frames.
+ *
+ * On a miss the buffer pool first tries to reuse the frame the ring handed out ring_size misses ago, provided that it
+ * still holds the page the ring loaded and nobody has it pinned. Otherwise a frame is taken from the free list or the
+ * replacer as usual and recorded in the ring. A scan over a table much larger than the pool therefore only ever
+ * occupies about ring_size frames and leaves the working set of other queries alone. Hits are not affected.
+ *
+ * A strategy belongs to a single operation; besides that operation only its read-ahead requests use the ring.
+ */
+class BufferAccessStrategy {
+  friend class BufferPoolManager;
+
+ public:
+  BufferAccessStrategy(AccessStrategyType type, BufferPoolManager *buffer_pool_manager);
+
+  inline AccessStrategyType GetType() const { return type_; }
+
+  /** @return the number of frames in the ring */
+  inline size_t GetRingSize() const { return ring_.size(); }
+
+ private:
+  struct RingSlot {
+    BufferPoolManager *owner{nullptr};  // the (shard of the) buffer pool that owns the frame
+    frame_id_t frame_id{INVALID_FRAME_ID};
+    page_id_t page_id{INVALID_PAGE_ID};  // the page the ring loaded into the frame
+  };
+
+  AccessStrategyType type_;
+  vector<RingSlot> ring_;
+  size_t current_{0};
+  mutex latch_;  // the scan and its read-ahead requests may recycle frames of the ring concurrently
+};
+
+#endif  // MINISQL_BUFFER_ACCESS_STRATEGY_H
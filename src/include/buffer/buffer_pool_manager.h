@@ -1,10 +1,21 @@
 #ifndef MINISQL_BUFFER_POOL_MANAGER_H
 #define MINISQL_BUFFER_POOL_MANAGER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
 #include "page/disk_file_meta_page.h"
 #include "page/page.h"
@@ -12,47 +23,390 @@
 
 using namespace std;
 
+/**
+ * Snapshot of the buffer pool counters and occupancy, see BufferPoolManager::GetStats.
+ */
+struct BufferPoolStats {
+  uint64_t hits{0};               // FetchPage calls that found the page resident
+  uint64_t misses{0};             // FetchPage calls that read the page from disk
+  uint64_t evictions{0};          // resident pages replaced to make room for another page
+  uint64_t sync_writes{0};        // dirty victims written back by FetchPage/NewPage while the caller waited
+  uint64_t background_writes{0};  // pages written back by the background writer
+  uint64_t flush_writes{0};       // pages written back by FlushPage/FlushAllPages
+  uint64_t read_ahead_pages{0};   // pages loaded by read-ahead
+  uint64_t new_pages{0};          // successful NewPage calls
+  uint64_t deleted_pages{0};      // successful DeletePage calls
+  size_t pinned_high_water{0};    // most frames pinned at the same time (summed over shards)
+  size_t pool_size{0};
+  size_t free_frames{0};
+  size_t pinned_frames{0};
+  size_t dirty_frames{0};
+  // occupancy by page type, recognized from the page header
+  size_t table_pages{0};
+  size_t internal_pages{0};  // B+ tree internal pages
+  size_t leaf_pages{0};      // B+ tree leaf pages
+  size_t meta_pages{0};      // catalog, index roots and free space map pages, and any other page of unknown type
+
+  /** @return fraction of FetchPage calls served from memory */
+  double HitRatio() const { return hits + misses == 0 ? 0 : static_cast<double>(hits) / (hits + misses); }
+
+  BufferPoolStats &operator+=(const BufferPoolStats &other);
+};
+
+/**
+ * BufferPoolManager caches disk pages in a fixed number of frames.
+ *
+ * When created with num_instances > 1 the pool is partitioned: this object only routes requests to one of
+ * num_instances independently latched BufferPoolManager shards, chosen by page_id % num_instances. Every shard owns
+ * pool_size / num_instances frames, so threads working on different pages rarely contend on the same latch.
+ * replacer_type selects the eviction policy used by every shard.
+ *
+ * An optional background writer thread per shard writes dirty, unpinned pages back ahead of eviction, so a miss
+ * rarely has to write a dirty victim synchronously while the query waits.
+ *
+ * ReadAhead loads the following pages of a page chain (e.g. a table heap) from a prefetch thread, so that a
+ * sequential scan finds them resident instead of waiting for one 4 KB read per page.
+ *
+ * Frames are allocated in chunks of BUFFER_POOL_CHUNK_SIZE frames. SetPoolSize grows the pool at once; shrinking
+ * takes frames out of use at once, then writes back and frees their pages from a background thread.
+ * The page data of all the frames added at once lives in one page aligned anonymous mapping, backed by huge pages
+ * when BUFFER_POOL_HUGE_PAGES is set (MAP_HUGETLB if the system has reserved some, transparent huge pages otherwise),
+ * so frames can be the target of O_DIRECT reads and writes and a large pool needs few TLB entries.
+ *
+ * DumpWorkingSet and LoadWorkingSet save the resident pages on shutdown and load them back from the prefetch thread
+ * on the next start, so that a restarted database does not have to warm its pool up one miss at a time.
+ *
+ * On a DiskManager opened read only the pool has no frames: FetchPage returns a page whose data points straight into
+ * the memory mapping of the file, without copying, pinning, replacement or dirty tracking. Such pages are never
+ * evicted and must not be written; NewPage, DeletePage, ReadAhead, DumpWorkingSet and SetPoolSize fail or do nothing.
+ */
 class BufferPoolManager {
  public:
-  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager);
+  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_instances = 1,
+                             ReplacerType replacer_type = ReplacerType::kLRU);
 
   ~BufferPoolManager();
 
-  Page *FetchPage(page_id_t page_id);
+  /**
+   * Fetch a page, pinning it.
+   * @param strategy if not nullptr, a miss replaces a frame of the strategy's ring instead of the shared pool
+   */
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy = nullptr);
 
   bool UnpinPage(page_id_t page_id, bool is_dirty);
 
   bool FlushPage(page_id_t page_id);
 
-  Page *NewPage(page_id_t &page_id);
+  /**
+   * Allocate a page on disk and pin it in a zeroed frame.
+   * @param reservation if not nullptr, the page is taken from the contiguous run reserved for the owning object
+   */
+  Page *NewPage(page_id_t &page_id, BufferAccessStrategy *strategy = nullptr,
+                ExtentReservation *reservation = nullptr);
 
   bool DeletePage(page_id_t page_id);
 
+  /**
+   * Delete all the pages of an object at once, e.g. of a dropped table or index.
+   * @param num_deleted if not null, set to the number of pages actually deleted
+   * @return false if some page was pinned, the other pages are deleted anyway
+   */
+  bool DeletePages(const vector<page_id_t> &page_ids, size_t *num_deleted = nullptr);
+
+  /**
+   * Give back the unused rest of an object's reserved run, called when the object goes away.
+   */
+  void ReleaseReservation(ExtentReservation *reservation);
+
   bool IsPageFree(page_id_t page_id);
 
   bool CheckAllUnpinned();
 
+  /**
+   * Checkpoint: write back every dirty page, in page id (i.e. physical) order, then sync the db file.
+   */
+  void FlushAllPages();
+
+  /**
+   * Start the background writer. Every interval_ms it checks the fraction of dirty frames; while it is above
+   * dirty_ratio, it writes back up to max_pages dirty unpinned pages per round, sorted by page id.
+   * Does nothing if the writer is already running.
+   */
+  void StartBackgroundWriter(double dirty_ratio = BG_WRITER_DIRTY_RATIO, size_t max_pages = BG_WRITER_MAX_PAGES,
+                             uint32_t interval_ms = BG_WRITER_INTERVAL_MS);
+
+  /**
+   * Stop the background writer and wait for it to exit.
+   */
+  void StopBackgroundWriter();
+
+  /**
+   * Asynchronously load up to num_pages pages of a page chain, starting at page_id. next_page_id extracts the id of
+   * the following page from a page's data, INVALID_PAGE_ID ends the chain. Pages are loaded unpinned, through the
+   * strategy's ring if one is given. Consecutive page ids of the chain are read from disk with one large read.
+   */
+  void ReadAhead(page_id_t page_id, size_t num_pages, std::function<page_id_t(const char *)> next_page_id,
+                 std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
+
+  /**
+   * Resize the pool online. Growing adds chunks of free frames. Shrinking is done in whole chunks (the new size is
+   * rounded up to a chunk boundary): the frames beyond the new size are no longer handed out, and a background thread
+   * writes back and drops their pages as soon as they are unpinned, then frees the chunks. A resize waits for the
+   * previous shrink to finish. A partitioned pool spreads the new size evenly over its shards.
+   * @return false if pool_size is smaller than the number of shards or larger than the physical memory, or if the new
+   * frames can not be allocated
+   */
+  bool SetPoolSize(size_t pool_size);
+
+  /**
+   * Write the ids of the resident pages to file_name, one per line, in replacement order: the page that would be
+   * evicted first comes first, pinned pages come last.
+   * @return false if the file can not be written
+   */
+  bool DumpWorkingSet(const std::string &file_name);
+
+  /**
+   * Load the pages listed by DumpWorkingSet back into the pool, asynchronously from the prefetch thread. Only the
+   * hottest pages that fit in the pool and are still allocated are loaded. They are read in physical order, runs of
+   * consecutive pages with one large read, then put back in the replacement order of the dump.
+   * @return number of pages queued for loading, 0 if the file can not be read
+   */
+  size_t LoadWorkingSet(const std::string &file_name);
+
+  /**
+   * @return a consistent snapshot of the counters and of the current occupancy, summed over all shards
+   */
+  BufferPoolStats GetStats();
+
+  /**
+   * Reset all counters to zero, e.g. between two phases of a benchmark.
+   */
+  void ResetStats();
+
+  /** @return number of pages loaded into the pool by read-ahead */
+  uint64_t GetReadAheadCount() const { return read_ahead_pages_; }
+
+  /** @return number of dirty victims written back synchronously by FetchPage/NewPage */
+  uint64_t GetSyncWriteCount() const;
+
+  /** @return number of pages written back by the background writer */
+  uint64_t GetBackgroundWriteCount() const;
+
+  /** @return the total number of frames in use, summed over all shards */
+  size_t GetPoolSize() const { return pool_size_; }
+
+  /** @return true if the pool serves pages straight from a read only mapping and they must not be modified */
+  bool IsReadOnly() const { return read_only_; }
+
+  /** @return the number of shards, 1 if the pool is not partitioned */
+  size_t GetNumInstances() const { return shards_.empty() ? 1 : shards_.size(); }
+
  private:
   /**
    * Allocate new page (operations like create index/table) For now just keep an increasing counter
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(ExtentReservation *reservation = nullptr);
 
   /**
    * Deallocate page (operations like drop index/table) Need bitmap in header page for tracking pages
    */
   void DeallocatePage(page_id_t page_id);
 
+  /**
+   * Drop a page from this shard without freeing it on disk.
+   * @return false if the page is pinned
+   */
+  bool DiscardPage(page_id_t page_id);
+
+  /**
+   * Write back the dirty pages of this shard, in page id order, without syncing.
+   */
+  void FlushDirtyPages();
+
+  /**
+   * Pick a frame from the free list, or evict a victim from the replacer (writing it back if dirty).
+   * @return the frame id, INVALID_FRAME_ID if every frame is pinned
+   */
   frame_id_t TryToFindFreePage();
 
+  /**
+   * Like TryToFindFreePage, but first try to recycle the frame in the current slot of the strategy's ring. The frame
+   * found is recorded in that slot as holding page_id, and the ring advances.
+   */
+  frame_id_t TryToFindFreePage(BufferAccessStrategy *strategy, page_id_t page_id);
+
+  /**
+   * Write the victim frame back if dirty and drop it from the page table.
+   */
+  void EvictFrame(frame_id_t frame_id);
+
+  /**
+   * Place an already allocated page into a free frame of this shard, used by the partitioned pool's NewPage.
+   */
+  Page *NewPageWithId(page_id_t page_id, BufferAccessStrategy *strategy);
+
+  /**
+   * Reset the frame's metadata and zero its memory for a freshly allocated page, and pin it.
+   */
+  Page *InitNewPage(frame_id_t frame_id, page_id_t page_id);
+
+  /**
+   * Read the next page id out of a resident page under the latch. The page is neither pinned nor touched in the
+   * replacer, so walking resident pages does not count as a hit or make them hotter.
+   * @return false if the page is not in the pool
+   */
+  bool PeekNextPageId(page_id_t page_id, const std::function<page_id_t(const char *)> &next_page_id,
+                      page_id_t *next);
+
+  /**
+   * Put a page read by the prefetch thread into an unpinned frame, unless it is resident already. The data was read
+   * without holding the latch: if the disk manager wrote anything since (num_writes changed), the page is read again.
+   * @return true if the page was loaded
+   */
+  bool InstallPage(page_id_t page_id, const char *page_data, uint64_t num_writes, BufferAccessStrategy *strategy);
+
+  struct ReadAheadRequest {
+    page_id_t page_id;
+    size_t num_pages;
+    std::function<page_id_t(const char *)> next_page_id;
+    std::shared_ptr<BufferAccessStrategy> strategy;
+    vector<page_id_t> page_ids;  // if not empty, load these pages (coldest first) instead of following a chain
+  };
+
+  /**
+   * Body of the prefetch thread.
+   */
+  void PrefetchLoop();
+
+  /**
+   * Walk the page chain of one read-ahead request, loading the pages that are not resident.
+   */
+  void DoReadAhead(const ReadAheadRequest &request);
+
+  /**
+   * Load the pages of a working set request, see LoadWorkingSet.
+   */
+  void DoLoadWorkingSet(const vector<page_id_t> &page_ids);
+
+  /**
+   * Append the resident pages of this shard to page_ids, in replacement order.
+   */
+  void GetWorkingSet(vector<page_id_t> *page_ids);
+
+  /**
+   * Move an unpinned resident page to the most recently used end of the replacer, without counting a hit.
+   */
+  void TouchPage(page_id_t page_id);
+
+  /**
+   * Queue a request for the prefetch thread, starting the thread if needed.
+   */
+  void QueuePrefetch(ReadAheadRequest request);
+
+  /**
+   * Body of the background writer thread.
+   */
+  void BackgroundWriterLoop(double dirty_ratio, size_t max_pages, uint32_t interval_ms);
+
+  /**
+   * Write the given (page id, frame) pairs with DiskManager::WritePages, which merges physically adjacent pages into
+   * one write and keeps the writes in flight together, then mark the frames clean. latch_ must be held.
+   */
+  void WriteBackPages(const vector<pair<page_id_t, frame_id_t>> &pages);
+
+  /**
+   * One round of the background writer.
+   * @return true if the pool is still above dirty_ratio after writing max_pages pages
+   */
+  bool CleanDirtyPages(double dirty_ratio, size_t max_pages);
+
+  /**
+   * Allocate num_frames new frames, in chunks, and put them on the free list. Throws std::bad_alloc, before any frame
+   * is added, if the memory of the frames can not be mapped.
+   */
+  void AddFrames(size_t num_frames);
+
+  /**
+   * Body of the thread releasing the frames beyond pool_size_ after a shrink.
+   */
+  void ReleaseFrames();
+
+  /** @return true if the frame is beyond the pool size, i.e. being released by a shrink */
+  inline bool IsRetiring(frame_id_t frame_id) const { return static_cast<size_t>(frame_id) >= pool_size_; }
+
+  /**
+   * Account for a frame whose pin count went from 0 to 1.
+   */
+  inline void OnFramePinned() {
+    if (++num_pinned_ > pinned_high_water_) {
+      pinned_high_water_ = num_pinned_;
+    }
+  }
+
+  inline BufferPoolManager *GetShard(page_id_t page_id) { return shards_[page_id % shards_.size()]; }
+
  private:
+  struct FrameChunk {
+    Page *frames;        // array of num_frames frames
+    size_t first_frame;  // frame id of frames[0]
+    size_t num_frames;
+    char *data;          // page data of the frames, part of a frame arena
+    size_t data_size;    // bytes of the arena owned by this chunk, at least num_frames * PAGE_SIZE
+  };
+
+  /**
+   * FetchPage of a read only pool: the page object wrapping the mapped data of page_id, created on first use.
+   */
+  Page *FetchMappedPage(page_id_t page_id);
+
+  /**
+   * Map a page aligned, zero filled frame arena of at least size bytes.
+   * @param[out] mapped_size the size actually mapped
+   */
+  static char *AllocateFrameArena(size_t size, size_t &mapped_size);
+
+  /**
+   * Destroy the frames of a chunk and unmap its part of the frame arena.
+   */
+  static void FreeFrameChunk(const FrameChunk &chunk);
+
   size_t pool_size_;                                 // number of pages in buffer pool
-  Page *pages_;                                      // array of pages
+  vector<Page *> frames_;                            // frame id -> frame, including frames being released
+  vector<FrameChunk> chunks_;                        // frame arrays, in frame id order
   DiskManager *disk_manager_;                        // pointer to the disk manager.
   unordered_map<page_id_t, frame_id_t> page_table_;  // to keep track of pages
-  Replacer *replacer_;                               // to find an unpinned page for replacement
+  Replacer *replacer_{nullptr};                      // to find an unpinned page for replacement
   list<frame_id_t> free_list_;                       // to find a free page for replacement
   recursive_mutex latch_;                            // to protect shared data structure
+  vector<BufferPoolManager *> shards_;               // partitions of the pool, empty if not partitioned
+  bool read_only_{false};                            // the db file is mapped read only, the pool has no frames
+  vector<atomic<Page *>> mapped_pages_;              // read only pool: page id -> page over the mapping
+  thread bg_writer_;                                 // background writer thread, not joinable if not running
+  mutex bg_mutex_;                                   // protects bg_stop_
+  condition_variable bg_cv_;                         // wakes the background writer up to stop
+  bool bg_stop_{false};                              // asks the background writer to exit
+  atomic<uint64_t> sync_writes_{0};                  // dirty victims written back in the foreground
+  atomic<uint64_t> bg_writes_{0};                    // pages written back by the background writer
+  thread prefetcher_;                                // prefetch thread, started by the first ReadAhead
+  mutex prefetch_mutex_;                             // protects prefetch_queue_ and prefetch_stop_
+  condition_variable prefetch_cv_;                   // wakes the prefetch thread up
+  deque<ReadAheadRequest> prefetch_queue_;           // pending read-ahead requests
+  bool prefetch_stop_{false};                        // asks the prefetch thread to exit
+  atomic<uint64_t> read_ahead_pages_{0};             // pages loaded by read-ahead
+  // counters below are protected by latch_
+  uint64_t hits_{0};
+  uint64_t misses_{0};
+  uint64_t evictions_{0};
+  uint64_t flush_writes_{0};
+  uint64_t new_pages_{0};
+  uint64_t deleted_pages_{0};
+  size_t num_pinned_{0};                             // frames with a non-zero pin count
+  size_t pinned_high_water_{0};
+  mutex resize_mutex_;                               // serializes SetPoolSize
+  thread releaser_;                                  // releases the frames of the last shrink, see ReleaseFrames
+  mutex release_mutex_;                              // protects release_stop_
+  condition_variable release_cv_;                    // wakes the releaser up to stop
+  bool release_stop_{false};                         // asks the releaser to exit
 };
 
 #endif  // MINISQL_BUFFER_POOL_MANAGER_H
@@ -1,12 +1,6 @@
 #ifndef MINISQL_CLOCK_REPLACER_H
 #define MINISQL_CLOCK_REPLACER_H
 
-#include <algorithm>
-#include <list>
-#include <map>
-#include <mutex>
-#include <queue>
-#include <unordered_set>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -15,7 +9,10 @@
 using namespace std;
 
 /**
- * CLOCKReplacer implements the clock replacement.
+ * CLOCKReplacer implements the clock (second chance) replacement.
+ *
+ * Frames are tracked in two bit arrays indexed by frame id, so Pin/Unpin only flip bits and never touch a list.
+ * Victim sweeps the clock hand, clearing reference bits until it meets an unpinned frame whose bit is already clear.
  */
 class CLOCKReplacer : public Replacer {
  public:
@@ -36,12 +33,20 @@ class CLOCKReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  void Remove(frame_id_t frame_id) override;
+
   size_t Size() override;
 
+  void Resize(size_t num_pages) override;
+
+  void GetVictimOrder(std::vector<frame_id_t> *frames) override;
+
  private:
   size_t capacity;
-  list<frame_id_t> clock_list;               // replacer中可以被替换的数据页
-  map<frame_id_t, frame_id_t> clock_status;  // 数据页的存储状态
+  vector<bool> in_clock;   // in_clock[i]表示页帧i当前是否可以被替换（即未被固定）
+  vector<bool> ref_bits;   // 页帧的引用位，被替换前会先获得一次“第二次机会”
+  size_t hand{0};          // 时钟指针，指向下一个要检查的页帧
+  size_t num_victims{0};   // 当前可以被替换的页帧数
 };
 
 #endif  // MINISQL_CLOCK_REPLACER_H
\ No newline at end of file
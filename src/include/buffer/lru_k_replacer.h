@@ -0,0 +1,79 @@
+#ifndef MINISQL_LRU_K_REPLACER_H
+#define MINISQL_LRU_K_REPLACER_H
+
+#include <deque>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+using namespace std;
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The victim is the evictable frame with the largest backward K-distance, i.e. whose K-th most recent reference is
+ * the oldest. Frames referenced fewer than K times have an infinite distance and are evicted first, in LRU order, so
+ * pages touched once by a sequential scan do not push out pages that are referenced repeatedly.
+ *
+ * Time is a logical clock advanced on every access. A reference that arrives within correlated_period ticks of the
+ * previous reference to the same frame is treated as part of that reference (e.g. one scan reading every tuple of a
+ * page), so it only refreshes the last access time and does not add to the frame's history.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k number of references kept per frame
+   * @param correlated_period references closer than this many ticks to the previous one are merged into it
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = DEFAULT_LRUK_K,
+                        size_t correlated_period = DEFAULT_LRUK_CORRELATED_PERIOD);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+  void Resize(size_t num_pages) override;
+
+  void GetVictimOrder(std::vector<frame_id_t> *frames) override;
+
+ private:
+  // 每个页帧的访问历史
+  struct FrameHistory {
+    deque<uint64_t> history;  // 最近K次（非相关）访问的时间，头部为最近一次
+    uint64_t last_access{0};  // 最近一次访问的时间（包括相关访问）
+    bool evictable{false};    // 是否在victims中
+  };
+
+  using VictimKey = tuple<bool, uint64_t, frame_id_t>;
+
+  /** Record a reference to the frame at the current logical time. */
+  void RecordAccess(frame_id_t frame_id);
+
+  /** @return the ordering key of a frame in victims: infinite distances first, then the oldest K-th reference */
+  VictimKey GetKey(frame_id_t frame_id) const;
+
+  size_t num_pages;
+  size_t k_;
+  size_t correlated_period_;
+  uint64_t current_time_{0};
+  vector<FrameHistory> frames_;
+  set<VictimKey> victims;  // 可以被替换的页帧，按被替换的先后排序
+};
+
+#endif  // MINISQL_LRU_K_REPLACER_H
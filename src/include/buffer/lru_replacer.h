@@ -36,12 +36,22 @@ public:
 
  void Unpin(frame_id_t frame_id) override;
 
+ void Remove(frame_id_t frame_id) override;
+
  size_t Size() override;
 
+ void Resize(size_t num_pages) override;
+
+ void GetVictimOrder(std::vector<frame_id_t> *frames) override;
+
 private:
  // add your own private member variables here
  // victims用于存储可以被替换的页的页帧号，尾部存储最近最少使用的页id，头部存储最近最多使用的页id
  list<frame_id_t> victims;
+ // victims_map以页帧号为下标，记录该页帧在victims中的位置，使Pin/Unpin无需遍历链表
+ vector<list<frame_id_t>::iterator> victims_map;
+ // in_victims[i]表示页帧i当前是否在victims中
+ vector<bool> in_victims;
  // num_pages表示LRUReplacer需要存储的最大页数
  size_t num_pages;
 };
@@ -2,9 +2,15 @@
 #define MINISQL_REPLACER_H
 
 #include <cstdio>
+#include <vector>
 
 #include "common/config.h"
 
+/**
+ * Replacement policies a BufferPoolManager can be created with.
+ */
+enum class ReplacerType { kLRU, kClock, kLRUK };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -33,8 +39,28 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Stop tracking a frame whose page is dropped without being evicted (deleted, discarded or released by a shrink).
+   * Unlike Pin, this is not an access: any history the policy keeps for the frame is forgotten.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) = 0;
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
+
+  /**
+   * Change the maximum number of frames the replacer tracks, when the buffer pool is resized. Frames beyond the new
+   * size must have been pinned before shrinking.
+   */
+  virtual void Resize(size_t num_pages) = 0;
+
+  /**
+   * List the frames that can be victimized, in the order the policy would evict them (first victim first).
+   * The replacer is not modified.
+   * @param[out] frames the frames are appended to it
+   */
+  virtual void GetVictimOrder(std::vector<frame_id_t> *frames) = 0;
 };
 
 #endif  // MINISQL_REPLACER_H
@@ -1,8 +1,11 @@
 #ifndef MINISQL_CATALOG_H
 #define MINISQL_CATALOG_H
 
+#include <condition_variable>
 #include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 
 #include "buffer/buffer_pool_manager.h"
@@ -94,7 +97,29 @@ class CatalogManager {
 
   dberr_t DropIndex(const std::string &table_name, const std::string &index_name);
 
+  /**
+   * Vacuum one table: reclaim its deleted tuples, compact its pages and free the pages left empty.
+   */
+  dberr_t VacuumTable(const std::string &table_name, VacuumStats &stats);
+
+  /**
+   * Start the autovacuum thread. Every interval_ms it vacuums the tables with at least min_dead_tuples deleted tuples.
+   * It only reclaims space inside the pages; empty pages are freed by VacuumTable, since a scan running concurrently
+   * may still be positioned on them. Does nothing if the thread is already running or the database is read only.
+   * Deleted tuples are reclaimed as soon as they are marked, since the executors never roll a delete back; turn it off
+   * (the default, see DEFAULT_AUTOVACUUM) before relying on TableHeap::RollbackDelete.
+   */
+  void StartAutoVacuum(uint32_t min_dead_tuples = AUTOVACUUM_MIN_DEAD_TUPLES,
+                       uint32_t interval_ms = AUTOVACUUM_INTERVAL_MS);
+
+  /**
+   * Stop the autovacuum thread and wait for it to exit.
+   */
+  void StopAutoVacuum();
+
  private:
+  void AutoVacuumLoop(uint32_t min_dead_tuples, uint32_t interval_ms);
+
   dberr_t DropTable(table_id_t table_id);
 
   dberr_t FlushCatalogMetaPage() const;
@@ -118,6 +143,12 @@ class CatalogManager {
   // map for indexes: table_name->index_name->indexes
   std::unordered_map<std::string, std::unordered_map<std::string, index_id_t>> index_names_;
   std::unordered_map<index_id_t, IndexInfo *> indexes_;
+  // autovacuum
+  std::mutex vacuum_latch_;                // keeps tables_ stable while a table is vacuumed
+  std::thread autovacuum_;                 // autovacuum thread, not joinable if not running
+  std::mutex autovacuum_mutex_;            // protects autovacuum_stop_
+  std::condition_variable autovacuum_cv_;  // wakes the autovacuum thread up to stop
+  bool autovacuum_stop_{false};            // asks the autovacuum thread to exit
 };
 
 #endif  // MINISQL_CATALOG_H
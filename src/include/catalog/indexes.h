@@ -14,8 +14,11 @@ class IndexMetadata {
   friend class IndexInfo;
 
  public:
+  /**
+   * New indexes store normalized keys, see KeyFormat.
+   */
   static IndexMetadata *Create(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                               const std::vector<uint32_t> &key_map);
+                               const std::vector<uint32_t> &key_map, KeyFormat key_format = KeyFormat::kNormalized);
 
   uint32_t SerializeTo(char *buf) const;
 
@@ -33,18 +36,23 @@ class IndexMetadata {
 
   inline index_id_t GetIndexId() const { return index_id_; }
 
+  inline KeyFormat GetKeyFormat() const { return key_format_; }
+
  private:
   IndexMetadata() = delete;
 
   explicit IndexMetadata(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                         const std::vector<uint32_t> &key_map);
+                         const std::vector<uint32_t> &key_map, KeyFormat key_format);
 
  private:
   static constexpr uint32_t INDEX_METADATA_MAGIC_NUM = 344528;
+  // written instead of INDEX_METADATA_MAGIC_NUM by indexes whose keys are normalized, older indexes keep row keys
+  static constexpr uint32_t INDEX_METADATA_NORMALIZED_MAGIC_NUM = 344529;
   index_id_t index_id_;
   std::string index_name_;
   table_id_t table_id_;
   std::vector<uint32_t> key_map_; /** The mapping of index key to tuple key */
+  KeyFormat key_format_;
 };
 
 /**
@@ -15,6 +15,26 @@ static constexpr int INDEX_ROOTS_PAGE_ID = 1;   // logical page id of the index
 
 static constexpr int PAGE_SIZE = 4096;                  // size of a data page in byte
 static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;  // default size of buffer pool
+static constexpr int DEFAULT_BUFFER_POOL_INSTANCES = 1;  // default number of buffer pool shards
+static constexpr int BUFFER_POOL_CHUNK_SIZE = 1024;      // frames allocated (and released by a shrink) together
+static constexpr bool BUFFER_POOL_HUGE_PAGES = true;     // back frames by huge pages: MAP_HUGETLB, else transparent
+static constexpr bool DEFAULT_DIRECT_IO = false;         // open db files with O_DIRECT, bypassing the OS page cache
+static constexpr int BULK_READ_RING_SIZE = 32;           // frames used by a bulk read (sequential scan) ring
+static constexpr int BULK_WRITE_RING_SIZE = 256;         // frames used by a bulk write (bulk insert) ring
+static constexpr int BULK_WRITE_MIN_ROWS = 1000;         // InsertTuples batches from this size on use a bulk write ring
+static constexpr int READ_AHEAD_PAGES = 16;              // pages prefetched ahead of a sequential table scan
+static constexpr int ASYNC_IO_QUEUE_DEPTH = 64;          // max asynchronous page reads/writes in flight per file
+static constexpr int ASYNC_IO_THREADS = 8;               // workers of the thread pool async I/O backend
+static constexpr int EXTENT_RESERVATION_PAGES = 64;      // contiguous pages reserved at a time for a table or index
+static constexpr double BG_WRITER_DIRTY_RATIO = 0.1;     // background writer: start cleaning above this dirty fraction
+static constexpr int BG_WRITER_MAX_PAGES = 64;           // background writer: max pages written per round
+static constexpr int BG_WRITER_INTERVAL_MS = 50;         // background writer: sleep between rounds, in milliseconds
+static constexpr bool DEFAULT_AUTOVACUUM = false;        // autovacuum: start the thread when a database is opened
+static constexpr int AUTOVACUUM_INTERVAL_MS = 1000;       // autovacuum: sleep between rounds, in milliseconds
+static constexpr int AUTOVACUUM_MIN_DEAD_TUPLES = 1000;   // autovacuum: vacuum a table once this many tuples are deleted
+static constexpr int DEFAULT_LRUK_K = 2;                 // references remembered per frame by the LRU-K replacer
+static constexpr int DEFAULT_LRUK_CORRELATED_PERIOD = 16;  // LRU-K: re-references within this many accesses are merged
+static constexpr const char *WORKING_SET_FILE_SUFFIX = ".buffer_pool";  // buffer pool working set saved on shutdown
 
 static constexpr uint32_t FIELD_NULL_LEN = UINT32_MAX;
 static constexpr uint32_t VARCHAR_MAX_LEN = PAGE_SIZE / 2;  // max length of varchar
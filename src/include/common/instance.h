@@ -14,16 +14,31 @@
 
 class DBStorageEngine {
  public:
-  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE);
+  /**
+   * @param read_only open an existing database without ever writing it: the file is memory mapped and shared with
+   * other readers through the OS page cache, pages are used in place without a buffer pool copy and the catalog can
+   * not be changed. init must be false.
+   * @param auto_vacuum start the autovacuum thread of the catalog, see CatalogManager::StartAutoVacuum
+   */
+  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE,
+                           uint32_t buffer_pool_instances = DEFAULT_BUFFER_POOL_INSTANCES,
+                           ReplacerType replacer_type = ReplacerType::kLRU, bool direct_io = DEFAULT_DIRECT_IO,
+                           bool read_only = false, bool auto_vacuum = DEFAULT_AUTOVACUUM);
 
   ~DBStorageEngine();
 
   std::unique_ptr<ExecuteContext> MakeExecuteContext(Txn *txn);
 
+  /**
+   * @return the file the working set of the buffer pool is saved to on shutdown, next to the database file
+   */
+  static std::string GetWorkingSetFileName(const std::string &db_name);
+
  public:
   DiskManager *disk_mgr_;
   BufferPoolManager *bpm_;
   CatalogManager *catalog_mgr_;
+  std::string db_name_;
   std::string db_file_name_;
   bool init_;
 };
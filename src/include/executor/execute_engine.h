@@ -73,6 +73,12 @@ class ExecuteEngine {
 
   dberr_t ExecuteQuit(pSyntaxNode ast, ExecuteContext *context);
 
+  dberr_t ExecuteShowBufferStatus(pSyntaxNode ast, ExecuteContext *context);
+
+  dberr_t ExecuteSetVariable(pSyntaxNode ast, ExecuteContext *context);
+
+  dberr_t ExecuteVacuum(pSyntaxNode ast, ExecuteContext *context);
+
  private:
   std::unordered_map<std::string, DBStorageEngine *> dbs_; /** all opened databases */
   std::string current_db_;                                 /** current database */
@@ -12,7 +12,8 @@
 /**
  * InsertExecutor executes an insert on a table.
  *
- * Inserted values are always pulled from a child executor.
+ * Inserted values are always pulled from a child executor. All of them are pulled by the first Next() and inserted
+ * with one TableHeap::InsertTuples batch; Next() then yields once per inserted row.
  */
 class InsertExecutor : public AbstractExecutor {
  public:
@@ -42,12 +43,18 @@ class InsertExecutor : public AbstractExecutor {
   const Schema *GetOutputSchema() const override { return plan_->OutputSchema(); }
 
  private:
+  /** Pull all the rows of the child, check unique keys and insert the rows and their index entries. */
+  void InsertAll();
+
   /** The insert plan node to be executed*/
   const InsertPlanNode *plan_;
   std::unique_ptr<AbstractExecutor> child_executor_;
   TableInfo *table_info_{};
   const Schema *schema_{};
   std::vector<IndexInfo *> index_info_;
+  bool is_inserted_{false};
+  size_t num_inserted_{0};
+  size_t cursor_{0};
 };
 
 #endif  // MINISQL_INSERT_EXECUTOR_H
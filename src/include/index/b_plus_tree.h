@@ -1,6 +1,7 @@
 #ifndef MINISQL_B_PLUS_TREE_H
 #define MINISQL_B_PLUS_TREE_H
 
+#include <fstream>
 #include <queue>
 #include <string>
 #include <vector>
@@ -11,6 +12,8 @@
 #include "page/b_plus_tree_leaf_page.h"
 #include "page/b_plus_tree_page.h"
 
+#define BPLUSTREE_TYPE BPlusTree<KeySize>
+
 /**
  * Main class providing the API for the Interactive B+ Tree.
  *
@@ -20,15 +23,21 @@
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * KeySize is the key size class of the tree (see INDEX_TEMPLATE_ARGUMENTS), it must match the key size of the
+ * KeyManager unless it is 0.
  */
+INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
-  using InternalPage = BPlusTreeInternalPage;
-  using LeafPage = BPlusTreeLeafPage;
+  using InternalPage = BPlusTreeInternalPage<KeySize>;
+  using LeafPage = BPlusTreeLeafPage<KeySize>;
 
  public:
   explicit BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager, const KeyManager &comparator,
                      int leaf_max_size = UNDEFINED_SIZE, int internal_max_size = UNDEFINED_SIZE);
 
+  ~BPlusTree() { buffer_pool_manager_->ReleaseReservation(&reservation_); }
+
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
 
@@ -41,11 +50,11 @@ class BPlusTree {
   // return the value associated with a given key
   bool GetValue(const GenericKey *key, std::vector<RowId> &result, Txn *transaction = nullptr);
 
-  IndexIterator Begin();
+  IndexIterator<KeySize> Begin();
 
-  IndexIterator Begin(const GenericKey *key);
+  IndexIterator<KeySize> Begin(const GenericKey *key);
 
-  IndexIterator End();
+  IndexIterator<KeySize> End();
 
   // expose for test purpose
   Page *FindLeafPage(const GenericKey *key, page_id_t page_id = INVALID_PAGE_ID, bool leftMost = false);
@@ -53,7 +62,7 @@ class BPlusTree {
   // used to check whether all pages are unpinned
   bool Check();
 
-  // destroy the b plus tree
+  // destroy the b plus tree (or the subtree rooted at current_page_id), freeing all its pages at once
   void Destroy(page_id_t current_page_id = INVALID_PAGE_ID);
 
   void PrintTree(std::ofstream &out, Schema *schema) {
@@ -107,6 +116,8 @@ class BPlusTree {
   KeyManager processor_;
   int leaf_max_size_;
   int internal_max_size_;
+  // run of contiguous pages the tree's new nodes are taken from
+  ExtentReservation reservation_;
 };
 
 #endif  // MINISQL_B_PLUS_TREE_H
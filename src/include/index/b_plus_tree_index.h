@@ -5,9 +5,16 @@
 #include "index/generic_key.h"
 #include "index/index.h"
 
+#define BPLUSTREE_INDEX_TYPE BPlusTreeIndex<KeySize>
+
+/**
+ * An index over a B+ tree instantiated for the key size class KeySize, see IndexInfo::CreateIndex.
+ */
+INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeIndex : public Index {
  public:
-  BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size, BufferPoolManager *buffer_pool_manager);
+  BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size, BufferPoolManager *buffer_pool_manager,
+                 KeyFormat key_format = KeyFormat::kRow);
 
   dberr_t InsertEntry(const Row &key, RowId row_id, Txn *txn) override;
 
@@ -17,17 +24,17 @@ class BPlusTreeIndex : public Index {
 
   dberr_t Destroy() override;
 
-  IndexIterator GetBeginIterator();
+  IndexIterator<KeySize> GetBeginIterator();
 
-  IndexIterator GetBeginIterator(GenericKey *key);
+  IndexIterator<KeySize> GetBeginIterator(GenericKey *key);
 
-  IndexIterator GetEndIterator();
+  IndexIterator<KeySize> GetEndIterator();
 
  protected:
   // comparator for key
   KeyManager processor_;
   // container
-  BPlusTree container_;
+  BPlusTree<KeySize> container_;
 };
 
 #endif  // MINISQL_B_PLUS_TREE_INDEX_H
@@ -1,7 +1,9 @@
 #ifndef MINISQL_GENERIC_KEY_H
 #define MINISQL_GENERIC_KEY_H
 
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
 #include "record/field.h"
 #include "record/row.h"
@@ -11,6 +13,20 @@ class GenericKey {
   char data[0];
 };
 
+/**
+ * How an index stores its keys.
+ *
+ * kRow keys use the row format of Row::SerializeTo and are compared field by field.
+ *
+ * kNormalized keys use a fixed width encoding whose byte order is the key order, so two keys compare with a single
+ * memcmp. Every column takes a null flag byte (0 for null, so nulls sort first) followed by a fixed width value:
+ *  - int: 4 bytes big endian with the sign bit flipped
+ *  - float: 4 bytes big endian, the sign bit flipped for positive values and every bit flipped for negative ones
+ *  - char(n): n bytes, padded with zeros
+ * The value bytes of a null column are zero.
+ */
+enum class KeyFormat { kRow, kNormalized };
+
 class KeyManager {
  public: /**/
   [[nodiscard]] inline GenericKey *InitKey() const {
@@ -18,6 +34,10 @@ class KeyManager {
   }
 
   inline void SerializeFromKey(GenericKey *key_buf, const Row &key, Schema *schema) const {
+    if (format_ == KeyFormat::kNormalized) {
+      EncodeNormalized(key_buf->data, key);
+      return;
+    }
     // initialize to 0
     [[maybe_unused]] uint32_t size = key.GetSerializedSize(schema);
     ASSERT(key.GetFieldCount() == schema->GetColumnCount(), "field nums not match.");
@@ -27,48 +47,195 @@ class KeyManager {
   }
 
   inline void DeserializeToKey(const GenericKey *key_buf, Row &key, Schema *schema) const {
+    if (format_ == KeyFormat::kNormalized) {
+      DecodeNormalized(key_buf->data, key);
+      return;
+    }
     [[maybe_unused]] uint32_t ofs = key.DeserializeFrom(const_cast<char *>(key_buf->data), schema);
     ASSERT(ofs <= (uint32_t)key_size_, "Index key size exceed max key size.");
   }
 
-  // compare
+  /**
+   * Compare two serialized keys in place, without deserializing them into rows. The comparison is chosen once for the
+   * key schema: a single int, float or char column is read at a fixed offset, other keys walk the fields of both keys
+   * side by side. Fields where either key is null do not take part in the comparison, as with CompareLessThan.
+   * Normalized keys are compared with memcmp, a null field is smaller than any value.
+   */
   [[nodiscard]] inline int CompareKeys(const GenericKey *lhs, const GenericKey *rhs) const {
-    //    ASSERT(malloc_usable_size((void *)&lhs) == malloc_usable_size((void *)&rhs), "key size not match.");
-    uint32_t column_count = key_schema_->GetColumnCount();
-    Row lhs_key(INVALID_ROWID);
-    Row rhs_key(INVALID_ROWID);
-    DeserializeToKey(lhs, lhs_key, key_schema_);
-    DeserializeToKey(rhs, rhs_key, key_schema_);
-
-    for (uint32_t i = 0; i < column_count; i++) {
-      Field *lhs_value = lhs_key.GetField(i);
-      Field *rhs_value = rhs_key.GetField(i);
-
-      if (lhs_value->CompareLessThan(*rhs_value) == CmpBool::kTrue) {
-        return -1;
-      }
-
-      if (lhs_value->CompareGreaterThan(*rhs_value) == CmpBool::kTrue) {
-        return 1;
+    switch (compare_type_) {
+      case CompareType::kNormalized: {
+        int cmp = memcmp(lhs->data, rhs->data, normalized_size_);
+        return (cmp > 0) - (cmp < 0);
       }
+      case CompareType::kInt:
+        return IsFirstNull(lhs->data) || IsFirstNull(rhs->data)
+                   ? 0
+                   : CompareInts(lhs->data + FIRST_FIELD_OFFSET, rhs->data + FIRST_FIELD_OFFSET);
+      case CompareType::kFloat:
+        return IsFirstNull(lhs->data) || IsFirstNull(rhs->data)
+                   ? 0
+                   : CompareFloats(lhs->data + FIRST_FIELD_OFFSET, rhs->data + FIRST_FIELD_OFFSET);
+      case CompareType::kChar:
+        return IsFirstNull(lhs->data) || IsFirstNull(rhs->data)
+                   ? 0
+                   : CompareChars(lhs->data + FIRST_FIELD_OFFSET, rhs->data + FIRST_FIELD_OFFSET);
+      default:
+        return CompareFields(lhs->data, rhs->data);
     }
-    // equals
-    return 0;
   }
 
+  /**
+   * Find the first of the keys in [lo, hi) that is not less than key. The keys are sorted and stride bytes apart,
+   * starting at base, as in the pair arrays of the B+ tree pages.
+   * Normalized keys narrow the range with a binary search and then count the keys in the last few strides whose first
+   * 4 value bytes (after the null flag of the first column) are smaller, eight at a time with AVX2 when the cpu has it.
+   * Null keys have zero value bytes and sort first, so the prefixes are sorted too.
+   */
+  int LowerBound(const char *base, size_t stride, int lo, int hi, const GenericKey *key) const;
+
   inline int GetKeySize() const { return key_size_; }
 
+  inline KeyFormat GetKeyFormat() const { return format_; }
+
+  /**
+   * @return the bytes a normalized key of the schema takes
+   */
+  static uint32_t GetNormalizedKeySize(const Schema *key_schema);
+
   KeyManager(const KeyManager &other) {
     this->key_schema_ = other.key_schema_;
     this->key_size_ = other.key_size_;
+    this->key_types_ = other.key_types_;
+    this->compare_type_ = other.compare_type_;
+    this->format_ = other.format_;
+    this->normalized_size_ = other.normalized_size_;
+    this->prefix_search_ = other.prefix_search_;
   }
 
   // constructor
-  KeyManager(Schema *key_schema, size_t key_size) : key_size_(key_size), key_schema_(key_schema) {}
+  KeyManager(Schema *key_schema, size_t key_size, KeyFormat format = KeyFormat::kRow)
+      : key_size_(key_size), key_schema_(key_schema), format_(format) {
+    for (auto column : key_schema_->GetColumns()) {
+      key_types_.push_back(column->GetType());
+    }
+    if (format_ == KeyFormat::kNormalized) {
+      normalized_size_ = GetNormalizedKeySize(key_schema_);
+      ASSERT(normalized_size_ <= (uint32_t)key_size_, "Index key size exceed max key size.");
+      compare_type_ = CompareType::kNormalized;
+      // the prefix only follows the key order when it lies inside the value of the first column
+      prefix_search_ = normalized_size_ >= 1 + sizeof(uint32_t) &&
+                       (key_types_[0] != TypeId::kTypeChar || key_schema_->GetColumn(0)->GetLength() >= sizeof(uint32_t));
+    } else if (key_types_.size() == 1) {
+      switch (key_types_[0]) {
+        case TypeId::kTypeInt:
+          compare_type_ = CompareType::kInt;
+          break;
+        case TypeId::kTypeFloat:
+          compare_type_ = CompareType::kFloat;
+          break;
+        case TypeId::kTypeChar:
+          compare_type_ = CompareType::kChar;
+          break;
+        default:
+          break;
+      }
+    }
+  }
 
  private:
+  /**
+   * Serialized key (see Row::SerializeTo): field count (4), null bitmap (1 bit per field, first field in the high bit),
+   * then the non-null fields; an int or float is 4 bytes, a char is its length (4) followed by its bytes.
+   */
+  enum class CompareType { kInt, kFloat, kChar, kComposite, kNormalized };
+
+  // a key of one column has a one byte null bitmap
+  static constexpr uint32_t FIRST_FIELD_OFFSET = sizeof(uint32_t) + 1;
+
+  static inline bool IsNull(const char *data, uint32_t i) {
+    return (static_cast<uint8_t>(data[sizeof(uint32_t) + i / 8]) & (0x80 >> (i % 8))) != 0;
+  }
+
+  static inline bool IsFirstNull(const char *data) { return (static_cast<uint8_t>(data[sizeof(uint32_t)]) & 0x80) != 0; }
+
+  static inline int CompareInts(const char *lhs, const char *rhs) {
+    int32_t lhs_value, rhs_value;
+    memcpy(&lhs_value, lhs, sizeof(int32_t));
+    memcpy(&rhs_value, rhs, sizeof(int32_t));
+    return (lhs_value > rhs_value) - (lhs_value < rhs_value);
+  }
+
+  static inline int CompareFloats(const char *lhs, const char *rhs) {
+    float lhs_value, rhs_value;
+    memcpy(&lhs_value, lhs, sizeof(float));
+    memcpy(&rhs_value, rhs, sizeof(float));
+    return (lhs_value > rhs_value) - (lhs_value < rhs_value);
+  }
+
+  // same order as TypeChar: bytes first, then the shorter string is smaller
+  static inline int CompareChars(const char *lhs, const char *rhs) {
+    uint32_t lhs_len, rhs_len;
+    memcpy(&lhs_len, lhs, sizeof(uint32_t));
+    memcpy(&rhs_len, rhs, sizeof(uint32_t));
+    int cmp = memcmp(lhs + sizeof(uint32_t), rhs + sizeof(uint32_t), std::min(lhs_len, rhs_len));
+    if (cmp != 0) {
+      return cmp < 0 ? -1 : 1;
+    }
+    return (lhs_len > rhs_len) - (lhs_len < rhs_len);
+  }
+
+  static inline uint32_t FieldSize(TypeId type, const char *field) {
+    if (type != TypeId::kTypeChar) {
+      return Type::GetTypeSize(type);
+    }
+    uint32_t len;
+    memcpy(&len, field, sizeof(uint32_t));
+    return sizeof(uint32_t) + len;
+  }
+
+  inline int CompareFields(const char *lhs, const char *rhs) const {
+    uint32_t column_count = key_types_.size();
+    uint32_t lhs_offset = sizeof(uint32_t) + (column_count + 7) / 8;
+    uint32_t rhs_offset = lhs_offset;
+    for (uint32_t i = 0; i < column_count; i++) {
+      TypeId type = key_types_[i];
+      bool lhs_null = IsNull(lhs, i);
+      bool rhs_null = IsNull(rhs, i);
+      if (!lhs_null && !rhs_null) {
+        int cmp = 0;
+        switch (type) {
+          case TypeId::kTypeInt:
+            cmp = CompareInts(lhs + lhs_offset, rhs + rhs_offset);
+            break;
+          case TypeId::kTypeFloat:
+            cmp = CompareFloats(lhs + lhs_offset, rhs + rhs_offset);
+            break;
+          default:
+            cmp = CompareChars(lhs + lhs_offset, rhs + rhs_offset);
+            break;
+        }
+        if (cmp != 0) {
+          return cmp;
+        }
+      }
+      lhs_offset += lhs_null ? 0 : FieldSize(type, lhs + lhs_offset);
+      rhs_offset += rhs_null ? 0 : FieldSize(type, rhs + rhs_offset);
+    }
+    // equals
+    return 0;
+  }
+
+  void EncodeNormalized(char *buf, const Row &key) const;
+
+  void DecodeNormalized(const char *buf, Row &key) const;
+
   int key_size_;
   Schema *key_schema_;
+  std::vector<TypeId> key_types_;  // column types of key_schema_, read once
+  CompareType compare_type_{CompareType::kComposite};
+  KeyFormat format_{KeyFormat::kRow};
+  uint32_t normalized_size_{0};  // bytes of a normalized key, the rest of the key_size_ bytes are zero
+  bool prefix_search_{false};    // LowerBound may compare the 4 value bytes after the first null flag
 };
 
 #endif  // MINISQL_GENERIC_KEY_H
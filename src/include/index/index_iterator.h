@@ -3,8 +3,11 @@
 
 #include "page/b_plus_tree_leaf_page.h"
 
+#define INDEXITERATOR_TYPE IndexIterator<KeySize>
+
+INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
-  using LeafPage = BPlusTreeLeafPage;
+  using LeafPage = BPlusTreeLeafPage<KeySize>;
 
  public:
   // you may define your own constructor based on your member variables
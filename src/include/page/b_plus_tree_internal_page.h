@@ -8,6 +8,7 @@
 #include "index/generic_key.h"
 #include "page/b_plus_tree_page.h"
 
+#define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeySize>
 #define INTERNAL_PAGE_HEADER_SIZE 28
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
@@ -22,12 +23,16 @@
  * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
  *  --------------------------------------------------------------------------
  */
+INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
  public:
   // must call initialize method after "create" a new node
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int key_size = UNDEFINED_SIZE,
             int max_size = UNDEFINED_SIZE);
 
+  // size of the keys in the pairs, a compile time constant unless KeySize is 0
+  inline int PairKeySize() const { return KeySize == 0 ? GetKeySize() : KeySize; }
+
   GenericKey *KeyAt(int index);
 
   void SetKeyAt(int index, GenericKey *key);
@@ -72,6 +77,4 @@ class BPlusTreeInternalPage : public BPlusTreePage {
 
   char data_[PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE];
 };
-
-using InternalPage = BPlusTreeInternalPage;
 #endif  // MINISQL_B_PLUS_TREE_INTERNAL_PAGE_H
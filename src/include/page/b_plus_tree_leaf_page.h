@@ -27,8 +27,10 @@
 #include "index/generic_key.h"
 #include "page/b_plus_tree_page.h"
 
+#define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeySize>
 #define LEAF_PAGE_HEADER_SIZE 32
 
+INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
  public:
   // After creating a new leaf page from buffer pool, must call initialize
@@ -36,6 +38,9 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int key_size = UNDEFINED_SIZE,
             int max_size = UNDEFINED_SIZE);
 
+  // size of the keys in the pairs, a compile time constant unless KeySize is 0
+  inline int PairKeySize() const { return KeySize == 0 ? GetKeySize() : KeySize; }
+
   // helper methods
   page_id_t GetNextPageId() const;
 
@@ -84,6 +89,4 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 
   char data_[PAGE_SIZE - LEAF_PAGE_HEADER_SIZE];
 };
-
-using LeafPage = BPlusTreeLeafPage;
 #endif  // MINISQL_B_PLUS_TREE_LEAF_PAGE_H
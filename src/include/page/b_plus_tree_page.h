@@ -12,6 +12,13 @@
 enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
 
 #define UNDEFINED_SIZE 0
+
+/**
+ * The B+ tree pages, the tree, its iterator and BPlusTreeIndex are instantiated per key size class: KeySize is one of
+ * the sizes IndexInfo::CreateIndex rounds index keys to (16, 32, 64, 128 or 256 bytes), so key offsets and key copies
+ * are compile time constants. KeySize 0 takes the key size from the KeyManager at run time.
+ */
+#define INDEX_TEMPLATE_ARGUMENTS template <int KeySize>
 /**
  * Both internal and leaf page are inherited from this page.
  *
@@ -0,0 +1,54 @@
+#ifndef MINISQL_B_PLUS_TREE_PAIRS_H
+#define MINISQL_B_PLUS_TREE_PAIRS_H
+
+/**
+ * b_plus_tree_pairs.h
+ *
+ * The key & value pair array of a B+ tree page, specialized by key size.
+ *
+ * The pages of a tree instantiated for one of the key size classes (see INDEX_TEMPLATE_ARGUMENTS) shift and copy their
+ * pairs through BPlusTreePairs<KeySize, ValueType>, so the pair size is a compile time constant and key copies and
+ * pair offsets are constant folded. KeySize 0 reads the key size of the page at run time.
+ */
+#include <cstring>
+
+#include "index/generic_key.h"
+
+template <int KeySize, typename ValueType>
+class BPlusTreePairs {
+ public:
+  BPlusTreePairs(char *data, int key_size) : data_(data), key_size_(KeySize == 0 ? key_size : KeySize) {}
+
+  inline int GetKeySize() const { return KeySize == 0 ? key_size_ : KeySize; }
+
+  inline size_t GetPairSize() const { return GetKeySize() + sizeof(ValueType); }
+
+  inline char *PairAt(int index) const { return data_ + index * GetPairSize(); }
+
+  /**
+   * Insert a pair at index of an array holding size pairs, the pairs from index on move one place right.
+   */
+  inline void InsertAt(int index, int size, const GenericKey *key, const ValueType &value) {
+    memmove(PairAt(index + 1), PairAt(index), (size - index) * GetPairSize());
+    memcpy(PairAt(index), key, GetKeySize());
+    memcpy(PairAt(index) + GetKeySize(), &value, sizeof(ValueType));
+  }
+
+  /**
+   * Remove the pair at index of an array holding size pairs, the pairs after it move one place left.
+   */
+  inline void RemoveAt(int index, int size) {
+    memmove(PairAt(index), PairAt(index + 1), (size - index - 1) * GetPairSize());
+  }
+
+  /**
+   * Copy count pairs from src to dest, the ranges may overlap.
+   */
+  inline void Copy(void *dest, const void *src, int count) { memmove(dest, src, count * GetPairSize()); }
+
+ private:
+  char *data_;
+  int key_size_;
+};
+
+#endif  // MINISQL_B_PLUS_TREE_PAIRS_H
@@ -20,6 +20,12 @@ class BitmapPage {
    */
   bool AllocatePage(uint32_t &page_offset);
 
+  /**
+   * Allocate the given page.
+   * @return false if the page is out of range or already allocated.
+   */
+  bool AllocatePageAt(uint32_t page_offset);
+
   /**
    * @return true if successfully de-allocate a page.
    */
@@ -30,6 +36,18 @@ class BitmapPage {
    */
   bool IsPageFree(uint32_t page_offset) const;
 
+  /**
+   * @return the lowest free page (a hint that may be stale in files written by older versions)
+   */
+  uint32_t GetNextFreePage() const { return next_free_page_; }
+
+  /**
+   * Find the first free page at or after start, skipping full bytes.
+   *
+   * @return offset of the free page, GetMaxSupportedSize() if there is none
+   */
+  uint32_t FindFreePage(uint32_t start) const;
+
  private:
   /**
    * check a bit(byte_index, bit_index) in bytes is free(value 0).
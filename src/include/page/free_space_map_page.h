@@ -0,0 +1,105 @@
+#ifndef MINISQL_FREE_SPACE_MAP_PAGE_H
+#define MINISQL_FREE_SPACE_MAP_PAGE_H
+
+/**
+ * Free space map page format, one byte of free space category per table page:
+ *
+ *  Header format (size in bytes):
+ *  -------------------------------------------------------------------------
+ *  | PageId (4)| LSN (4)| Magic (4)| NextPageId (4)| EntryCount (4) |
+ *  -------------------------------------------------------------------------
+ *  -------------------------------------------------------------------------------------------
+ *  | TablePageId_1 (4) | ... | TablePageId_N (4) | Category_1 (1) | ... | Category_N (1) |
+ *  -------------------------------------------------------------------------------------------
+ *
+ * Entries are appended in the order the table pages are linked into the heap. A page of category c has at least
+ * c * CATEGORY_BYTES bytes of free space, so a tuple of category ToCategory(size, true) fits into it. The magic sits
+ * where a table page keeps its previous page id, which can never hold that value.
+ **/
+
+#include <cstring>
+
+#include "page/page.h"
+
+class FreeSpaceMapPage : public Page {
+ public:
+  void Init(page_id_t page_id);
+
+  /**
+   * Recognize a free space map page from its raw data, used by the buffer pool statistics.
+   */
+  static bool IsFreeSpaceMapPage(const char *page_data) {
+    return *reinterpret_cast<const uint32_t *>(page_data + OFFSET_MAGIC) == MAGIC_NUM;
+  }
+
+  page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
+
+  void SetNextPageId(page_id_t next_page_id) {
+    memcpy(GetData() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
+  }
+
+  uint32_t GetEntryCount() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_ENTRY_COUNT); }
+
+  bool IsFull() { return GetEntryCount() == CAPACITY; }
+
+  /**
+   * Append the entry of a table page.
+   * @return the slot of the entry, or -1 if this page is full
+   */
+  int Append(page_id_t table_page_id, uint8_t category);
+
+  page_id_t GetTablePageId(uint32_t slot) {
+    return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_PAGE_IDS + sizeof(page_id_t) * slot);
+  }
+
+  /**
+   * Forget the entry of a table page that was freed. The slot stays in place with an invalid page id and category 0,
+   * so the slots after it keep their position.
+   */
+  void ClearEntry(uint32_t slot) {
+    page_id_t invalid_page_id = INVALID_PAGE_ID;
+    memcpy(GetData() + OFFSET_PAGE_IDS + sizeof(page_id_t) * slot, &invalid_page_id, sizeof(page_id_t));
+    SetCategory(slot, 0);
+  }
+
+  uint8_t GetCategory(uint32_t slot) { return *reinterpret_cast<uint8_t *>(GetData() + OFFSET_CATEGORIES + slot); }
+
+  void SetCategory(uint32_t slot, uint8_t category) { *(GetData() + OFFSET_CATEGORIES + slot) = category; }
+
+  /**
+   * @return the first slot at or after start whose category is at least min_category, or -1 if there is none
+   */
+  int FindSlot(uint8_t min_category, uint32_t start = 0);
+
+  /**
+   * @return the largest category on this page
+   */
+  uint8_t GetMaxCategory();
+
+  /**
+   * Convert a number of free bytes to a category. Free space is rounded down so that the category never promises more
+   * room than the page has, a request is rounded up so that any page of that category can hold it.
+   */
+  static uint8_t ToCategory(uint32_t bytes, bool round_up = false) {
+    uint32_t category = round_up ? (bytes + CATEGORY_BYTES - 1) / CATEGORY_BYTES : bytes / CATEGORY_BYTES;
+    return static_cast<uint8_t>(category > MAX_CATEGORY ? MAX_CATEGORY : category);
+  }
+
+ private:
+  static constexpr uint32_t MAGIC_NUM = 0xF5F5F5F5;
+  static constexpr size_t SIZE_HEADER = 20;
+  static constexpr size_t OFFSET_MAGIC = 8;
+  static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
+  static constexpr size_t OFFSET_ENTRY_COUNT = 16;
+
+ public:
+  static constexpr uint32_t CAPACITY = (PAGE_SIZE - SIZE_HEADER) / (sizeof(page_id_t) + sizeof(uint8_t));
+  static constexpr uint32_t CATEGORY_BYTES = (PAGE_SIZE + 255) / 256;
+  static constexpr uint32_t MAX_CATEGORY = 255;
+
+ private:
+  static constexpr size_t OFFSET_PAGE_IDS = SIZE_HEADER;
+  static constexpr size_t OFFSET_CATEGORIES = SIZE_HEADER + sizeof(page_id_t) * CAPACITY;
+};
+
+#endif  // MINISQL_FREE_SPACE_MAP_PAGE_H
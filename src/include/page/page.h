@@ -1,6 +1,7 @@
 #ifndef MINISQL_PAGE_H
 #define MINISQL_PAGE_H
 
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <shared_mutex>
@@ -12,6 +13,10 @@
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * The page data is not stored inside the Page object: frames of the buffer pool point into one page aligned frame
+ * arena (see BufferPoolManager), so the data can be read and written with O_DIRECT. A Page created on its own owns
+ * an aligned buffer. Code must go through GetData() and never cast a Page * to a page layout directly.
  */
 class Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
@@ -20,11 +25,18 @@ class Page {
  public:
   DISALLOW_COPY(Page)
 
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor. Allocates a page aligned buffer owned by this page and zeros it out. */
+  Page() : data_(static_cast<char *>(std::aligned_alloc(PAGE_SIZE, PAGE_SIZE))), owns_data_(true) { ResetMemory(); }
 
-  /** Default destructor. */
-  ~Page() = default;
+  /** Constructor of a buffer pool frame, whose data lives in the frame arena. */
+  explicit Page(char *data) : data_(data) {}
+
+  /** Destructor. Frees the data if this page owns it. */
+  ~Page() {
+    if (owns_data_) {
+      std::free(data_);
+    }
+  }
 
   /** @return the actual data contained within this page */
   inline char *GetData() { return data_; }
@@ -68,8 +80,10 @@ class Page {
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
-  /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  /** The actual data that is stored within a page, PAGE_SIZE bytes aligned to PAGE_SIZE. */
+  char *data_;
+  /** True if data_ was allocated by this page rather than by the buffer pool. */
+  bool owns_data_ = false;
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
   /** The pin count of this page. */
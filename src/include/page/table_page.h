@@ -9,15 +9,24 @@
  *                                free space pointer
  *
  *  Header format (size in bytes):
- *  ----------------------------------------------------------------------------
- *  | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| FreeSpacePointer(4) |
- *  ----------------------------------------------------------------------------
- *  ----------------------------------------------------------------
- *  | TupleCount (4) | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
- *  ----------------------------------------------------------------
+ *  ---------------------------------------------------------------------------------------------------------
+ *  | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| FreeSpacePointer(2) | Flags/FragmentedBytes (2) |
+ *  ---------------------------------------------------------------------------------------------------------
+ *  -------------------------------------------------------------------------------------
+ *  | TupleCount (2) | FreeSlotHead (2) | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
+ *  -------------------------------------------------------------------------------------
+ *
+ *  Pages written before format 1 stored FreeSpacePointer and TupleCount in 4 bytes each, so their Flags and
+ *  FreeSlotHead halves read as 0. Format 1 pages set FORMAT_V1_FLAG in Flags; the page is upgraded in place by the
+ *  first insert, update or delete, which only links its empty slots, no tuple moves.
+ *
+ *  Empty slots (size 0) form a list starting at FreeSlotHead, each one keeping the next empty slot in its offset
+ *  field, so an insert reuses a slot without scanning. Deleting or shrinking a tuple only adds its bytes to
+ *  FragmentedBytes; the page is compacted once when an insert or update needs more contiguous space than is left.
  **/
 
 #include <cstring>
+#include <vector>
 
 #include "common/macros.h"
 #include "common/rowid.h"
@@ -37,6 +46,13 @@ class TablePage : public Page {
 
   page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
 
+  /**
+   * Read the next page id from the raw data of a table page that is not (yet) in the buffer pool, used by read-ahead.
+   */
+  static page_id_t ReadNextPageId(const char *page_data) {
+    return *reinterpret_cast<const page_id_t *>(page_data + OFFSET_NEXT_PAGE_ID);
+  }
+
   void SetPrevPageId(page_id_t prev_page_id) {
     memcpy(GetData() + OFFSET_PREV_PAGE_ID, &prev_page_id, sizeof(page_id_t));
   }
@@ -58,25 +74,94 @@ class TablePage : public Page {
 
   bool GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_manager);
 
+  /**
+   * Decode every live tuple of the page, in slot order, into rows[0], rows[1], ... The Row objects already in rows are
+   * reused and rows only grows, so a scan can keep one batch across pages.
+   * @return number of tuples decoded
+   */
+  uint32_t GetTuples(std::vector<Row> &rows, Schema *schema, Txn *txn, LockManager *lock_manager);
+
   bool GetFirstTupleRid(RowId *first_rid);
 
   bool GetNextTupleRid(const RowId &cur_rid, RowId *next_rid);
 
+  /**
+   * @return bytes left between the slot array and the tuples plus the fragments a compaction would reclaim, the free
+   * space recorded in the free space map
+   */
+  uint32_t GetFreeSpaceRemaining() { return GetContiguousFreeSpace() + GetFragmentedBytes(); }
+
+  /**
+   * @return free space an insert of a tuple of serialized_size bytes needs, including its slot
+   */
+  static uint32_t GetSpaceNeeded(uint32_t serialized_size) { return serialized_size + SIZE_TUPLE; }
+
+  /**
+   * Reclaim the tuples marked as deleted: apply their deletes, drop the empty slots at the end of the slot array and
+   * compact the page. Slot numbers of the remaining tuples do not change.
+   * @param[out] reclaimed_bytes serialized bytes of the removed tuples
+   * @return number of tuples removed
+   */
+  uint32_t Vacuum(uint32_t *reclaimed_bytes);
+
+  /**
+   * @return true if no slot of this page holds a tuple, deleted or not
+   */
+  bool IsEmpty() { return GetTupleCount() == 0; }
+
  private:
-  uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
+  uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint16_t *>(GetData() + OFFSET_FREE_SPACE); }
 
   void SetFreeSpacePointer(uint32_t free_space_pointer) {
-    memcpy(GetData() + OFFSET_FREE_SPACE, &free_space_pointer, sizeof(uint32_t));
+    auto value = static_cast<uint16_t>(free_space_pointer);
+    memcpy(GetData() + OFFSET_FREE_SPACE, &value, sizeof(uint16_t));
   }
 
-  uint32_t GetTupleCount() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_COUNT); }
+  uint32_t GetTupleCount() { return *reinterpret_cast<uint16_t *>(GetData() + OFFSET_TUPLE_COUNT); }
+
+  void SetTupleCount(uint32_t tuple_count) {
+    auto value = static_cast<uint16_t>(tuple_count);
+    memcpy(GetData() + OFFSET_TUPLE_COUNT, &value, sizeof(uint16_t));
+  }
+
+  uint16_t GetFlags() { return *reinterpret_cast<uint16_t *>(GetData() + OFFSET_FLAGS); }
+
+  void SetFlags(uint16_t flags) { memcpy(GetData() + OFFSET_FLAGS, &flags, sizeof(uint16_t)); }
 
-  void SetTupleCount(uint32_t tuple_count) { memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t)); }
+  bool IsFormatV1() { return (GetFlags() & FORMAT_V1_FLAG) != 0; }
 
-  uint32_t GetFreeSpaceRemaining() {
+  uint32_t GetFragmentedBytes() { return IsFormatV1() ? GetFlags() & FRAGMENTED_BYTES_MASK : 0; }
+
+  void SetFragmentedBytes(uint32_t fragmented_bytes) {
+    SetFlags(static_cast<uint16_t>(FORMAT_V1_FLAG | fragmented_bytes));
+  }
+
+  uint32_t GetFreeSlotHead() { return *reinterpret_cast<uint16_t *>(GetData() + OFFSET_FREE_SLOT_HEAD); }
+
+  void SetFreeSlotHead(uint32_t slot_num) {
+    auto value = static_cast<uint16_t>(slot_num);
+    memcpy(GetData() + OFFSET_FREE_SLOT_HEAD, &value, sizeof(uint16_t));
+  }
+
+  uint32_t GetContiguousFreeSpace() {
     return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
   }
 
+  /**
+   * Convert a page written before format 1: link its empty slots into the free slot list. No-op on format 1 pages.
+   */
+  void UpgradeFormat();
+
+  /**
+   * Rebuild the free slot list from the empty slots, lowest slot first.
+   */
+  void LinkFreeSlots();
+
+  /**
+   * Move all tuples to the end of the page, turning the fragments into contiguous free space.
+   */
+  void Compact();
+
   uint32_t GetTupleOffsetAtSlot(uint32_t slot_num) {
     return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num);
   }
@@ -107,9 +192,15 @@ class TablePage : public Page {
   static constexpr size_t OFFSET_PREV_PAGE_ID = 8;
   static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
   static constexpr size_t OFFSET_FREE_SPACE = 16;
+  static constexpr size_t OFFSET_FLAGS = 18;
   static constexpr size_t OFFSET_TUPLE_COUNT = 20;
+  static constexpr size_t OFFSET_FREE_SLOT_HEAD = 22;
   static constexpr size_t OFFSET_TUPLE_OFFSET = 24;
   static constexpr size_t OFFSET_TUPLE_SIZE = 28;
+  static constexpr uint16_t FORMAT_V1_FLAG = 0x8000;
+  static constexpr uint16_t FRAGMENTED_BYTES_MASK = 0x7FFF;
+  static constexpr uint32_t NO_FREE_SLOT = 0xFFFF;
+  static_assert(PAGE_SIZE <= FRAGMENTED_BYTES_MASK, "page offsets must fit the 15 bits of FragmentedBytes");
 
  public:
   static constexpr size_t SIZE_MAX_ROW = PAGE_SIZE - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE;
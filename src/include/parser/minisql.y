@@ -1,5 +1,6 @@
 %{
   #include <stdio.h>
+  #include <string.h>
   #include "parser/parser.h"
 
   extern char *yytext;
@@ -26,8 +27,9 @@
 %type <syntax_node> sql_trx_begin sql_trx_commit sql_trx_rollback
 %type <syntax_node> sql_select select_columns column_values column_value operator
 %type <syntax_node> connector where_conditions where_condition
-%type <syntax_node> sql_insert sql_delete sql_update update_values update_value
+%type <syntax_node> sql_insert insert_rows sql_delete sql_update update_values update_value
 %type <syntax_node> sql_quit sql_exec_file
+%type <syntax_node> sql_show_buffer_status sql_set_variable sql_vacuum
 
 %%
 
@@ -58,6 +60,9 @@ sql:
   | sql_trx_rollback { $$ = $1; }
   | sql_quit { $$ = $1; }
   | sql_exec_file { $$ = $1; }
+  | sql_show_buffer_status { $$ = $1; }
+  | sql_set_variable { $$ = $1; }
+  | sql_vacuum { $$ = $1; }
   ;
 
 sql_create_database:
@@ -289,12 +294,22 @@ operator:
   ;
 
 sql_insert:
-  INSERT INTO IDENTIFIER VALUES '(' column_values ')' {
+  INSERT INTO IDENTIFIER VALUES insert_rows {
     $$ = CreateSyntaxNode(kNodeInsert, NULL);
     SyntaxNodeAddChildren($$, $3);
-    pSyntaxNode col_val_node = CreateSyntaxNode(kNodeColumnValues, NULL);
-    SyntaxNodeAddChildren(col_val_node, $6);
-    SyntaxNodeAddChildren($$, col_val_node);
+    SyntaxNodeAddChildren($$, $5);
+  }
+  ;
+
+insert_rows:
+  '(' column_values ')' ',' insert_rows {
+    $$ = CreateSyntaxNode(kNodeColumnValues, NULL);
+    SyntaxNodeAddChildren($$, $2);
+    SyntaxNodeAddSibling($$, $5);
+  }
+  | '(' column_values ')' {
+    $$ = CreateSyntaxNode(kNodeColumnValues, NULL);
+    SyntaxNodeAddChildren($$, $2);
   }
   ;
 
@@ -393,6 +408,44 @@ sql_exec_file:
   }
   ;
 
+sql_show_buffer_status:
+  SHOW IDENTIFIER IDENTIFIER {
+    /* buffer and status are not reserved words, so that they can still be used as names */
+    if (strcmp($2->val_, "buffer") != 0 || strcmp($3->val_, "status") != 0) {
+      yyerror("syntax error");
+      YYABORT;
+    }
+    $$ = CreateSyntaxNode(kNodeShowBufferStatus, NULL);
+  }
+  ;
+
+sql_set_variable:
+  SET IDENTIFIER EQ NUMBER {
+    $$ = CreateSyntaxNode(kNodeSetVariable, NULL);
+    SyntaxNodeAddChildren($$, $2);
+    SyntaxNodeAddChildren($$, $4);
+  }
+  ;
+
+sql_vacuum:
+  IDENTIFIER IDENTIFIER {
+    /* vacuum is not a reserved word either */
+    if (strcmp($1->val_, "vacuum") != 0) {
+      yyerror("syntax error");
+      YYABORT;
+    }
+    $$ = CreateSyntaxNode(kNodeVacuum, NULL);
+    SyntaxNodeAddChildren($$, $2);
+  }
+  | IDENTIFIER {
+    if (strcmp($1->val_, "vacuum") != 0) {
+      yyerror("syntax error");
+      YYABORT;
+    }
+    $$ = CreateSyntaxNode(kNodeVacuum, NULL);
+  }
+  ;
+
 %%
 int yyerror(char* error) {
 	MinisqlParserSetError(error);
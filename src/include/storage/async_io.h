@@ -0,0 +1,172 @@
+#ifndef MINISQL_ASYNC_IO_H
+#define MINISQL_ASYNC_IO_H
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/config.h"
+
+class DiskManager;
+
+/**
+ * Backends an AsyncIOEngine can run on.
+ */
+enum class AsyncIOBackend {
+  kIOUring,    // Linux io_uring, one submission/completion ring per engine
+  kThreadPool  // worker threads issuing blocking pread/pwrite, used when io_uring is not available
+};
+
+/**
+ * A group of asynchronous requests that can be waited for together.
+ */
+class IOBatch {
+  friend class AsyncIOEngine;
+
+ public:
+  IOBatch() = default;
+
+  ~IOBatch() { Wait(); }
+
+  /**
+   * Block until every request submitted with this batch has completed.
+   */
+  void Wait();
+
+ private:
+  void Add();
+
+  void Done();
+
+  std::mutex latch_;
+  std::condition_variable cv_;
+  size_t pending_{0};
+};
+
+/**
+ * AsyncIOEngine keeps many page reads and writes of a DiskManager in flight at once.
+ *
+ * Requests are queued by SubmitRead/SubmitWrite and complete in any order; the caller waits on the IOBatch it passed.
+ * At most queue_depth requests are in flight, further submissions block until one completes. With io_uring the kernel
+ * runs them concurrently and a single thread reaps the completions; otherwise ASYNC_IO_THREADS worker threads each run
+ * one blocking pread/pwrite at a time.
+ *
+ * Buffers must stay valid and unchanged until the batch is waited for. Reads beyond the end of the file are zero
+ * filled, as with DiskManager::ReadPages.
+ */
+class AsyncIOEngine {
+ public:
+  /**
+   * @param queue_depth maximum number of requests in flight
+   * @param use_io_uring false to force the thread pool backend
+   */
+  explicit AsyncIOEngine(DiskManager *disk_manager, size_t queue_depth = ASYNC_IO_QUEUE_DEPTH, bool use_io_uring = true);
+
+  /**
+   * Wait for the requests in flight and stop the engine.
+   */
+  ~AsyncIOEngine();
+
+  /**
+   * Read num_pages logical pages, stored back to back (see DiskManager::GetContiguousPages), into page_data.
+   */
+  void SubmitRead(page_id_t logical_page_id, uint32_t num_pages, char *page_data, IOBatch *batch);
+
+  /**
+   * Write one logical page.
+   */
+  void SubmitWrite(page_id_t logical_page_id, const char *page_data, IOBatch *batch);
+
+  /**
+   * Write pages.size() logical pages, stored back to back on disk, with one vectored write. pages[i] is the data of
+   * logical page logical_page_id + i.
+   */
+  void SubmitWrites(page_id_t logical_page_id, std::vector<const char *> pages, IOBatch *batch);
+
+  inline AsyncIOBackend GetBackend() const { return backend_; }
+
+  /** @return the highest number of requests that were in flight at the same time */
+  inline size_t GetMaxInflight() const { return max_inflight_; }
+
+  /** @return number of requests completed so far */
+  inline uint64_t GetNumCompleted() const { return num_completed_; }
+
+ private:
+  struct Request {
+    bool is_write;
+    page_id_t logical_page_id;
+    uint32_t num_pages;
+    IOBatch *batch;
+    size_t offset;                  // file offset
+    std::vector<struct iovec> iov;  // buffers to transfer, one per page for a write
+  };
+
+  void Submit(Request *request);
+
+  /**
+   * Finish a request reaped from io_uring that transferred count bytes (negative: -errno). A short or failed transfer
+   * is redone synchronously, which also zero fills a read beyond the end of file.
+   */
+  void CompleteIOUring(Request *request, int count);
+
+  /**
+   * Release the request's slot and notify its batch.
+   */
+  void Finish(Request *request);
+
+  /**
+   * Run a request with blocking I/O in the calling thread and finish it.
+   */
+  void RunRequest(Request *request);
+
+  /** Body of a thread pool worker. */
+  void WorkerLoop();
+
+  /** Set up the io_uring rings. @return false if io_uring is not available */
+  bool SetupIOUring();
+
+  /**
+   * Put a request on the submission ring and submit it, sq_latch_ must be held. nullptr asks the reaper to exit.
+   * @return false if the kernel refused the submission, the request is taken back off the ring and not completed
+   */
+  bool PushIOUring(Request *request);
+
+  /** Body of the io_uring completion thread. */
+  void ReapLoop();
+
+  DiskManager *disk_manager_;
+  size_t queue_depth_;
+  AsyncIOBackend backend_{AsyncIOBackend::kThreadPool};
+  std::mutex latch_;                   // protects inflight_, queue_ and stop_
+  std::condition_variable submit_cv_;  // signalled when a request completes
+  std::condition_variable work_cv_;    // signalled when the thread pool has work
+  size_t inflight_{0};
+  std::deque<Request *> queue_;        // requests waiting for a thread pool worker
+  bool stop_{false};
+  std::vector<std::thread> threads_;
+  std::atomic<size_t> max_inflight_{0};
+  std::atomic<uint64_t> num_completed_{0};
+  // io_uring state
+  int ring_fd_{-1};
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  void *sqes_{nullptr};
+  size_t sqes_size_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_mask_{nullptr};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned *cq_mask_{nullptr};
+  void *cqes_{nullptr};
+  std::mutex sq_latch_;  // serializes writers of the submission ring
+};
+
+#endif  // MINISQL_ASYNC_IO_H
@@ -2,15 +2,40 @@
 #define DISK_MGR_H
 
 #include <atomic>
-#include <fstream>
+#include <cstdlib>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "common/config.h"
 #include "common/macros.h"
 #include "page/bitmap_page.h"
 #include "page/disk_file_meta_page.h"
+#include "storage/async_io.h"
+
+/**
+ * A run of contiguous logical pages reserved for one table heap or B+ tree, [next_page_id_, end_page_id_).
+ * The pages stay free on disk until they are handed out, so a reservation that is never used up leaks nothing.
+ */
+struct ExtentReservation {
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  page_id_t end_page_id_{INVALID_PAGE_ID};
+};
+
+/** Frees a buffer returned by AllocateAlignedPages. */
+struct AlignedPagesDeleter {
+  void operator()(char *data) const { std::free(data); }
+};
+
+/** Whole pages aligned to PAGE_SIZE, as the buffers of O_DIRECT reads and writes must be. */
+using AlignedPages = std::unique_ptr<char[], AlignedPagesDeleter>;
+
+inline AlignedPages AllocateAlignedPages(size_t num_pages) {
+  return AlignedPages(static_cast<char *>(std::aligned_alloc(PAGE_SIZE, num_pages * PAGE_SIZE)));
+}
 
 /**
  * DiskManager takes care of the allocation and de allocation of pages within a database. It performs the reading and
@@ -19,10 +44,30 @@
  * Disk page storage format: (Free Page BitMap Size = PAGE_SIZE * 8, we note it as N)
  * | Meta Page | Free Page BitMap 1 | Page 1 | Page 2 | ....
  *      | Page N | Free Page BitMap 2 | Page N+1 | ... | Page 2N | ... |
+ *
+ * Page I/O uses positioned reads and writes (pread/pwrite) on a raw file descriptor, so ReadPage, WritePage and
+ * ReadPages need no latch and may run concurrently; db_io_latch_ only protects the meta page and the bitmaps.
+ * Writes are not forced to stable storage: call Sync at durability points (checkpoint, commit, close).
+ * Bitmap pages stay in memory once read, so AllocatePage, DeAllocatePage and IsPageFree do no I/O; like the meta
+ * page, changed bitmaps are only written back by Sync.
+ * An object that allocates through an ExtentReservation gets its pages from runs of EXTENT_RESERVATION_PAGES
+ * contiguous pages that no other allocation uses, so interleaved inserts into several objects do not scatter them.
+ * GetAsyncIO gives an engine that keeps many page reads and writes in flight, for bulk prefetch and write back.
+ *
+ * With direct_io the file is opened with O_DIRECT, so pages are not cached a second time by the OS page cache; the
+ * buffer pool frames are page aligned and are read and written in place, any other buffer that is not aligned goes
+ * through an aligned copy. File systems that do not support O_DIRECT fall back to buffered I/O.
+ *
+ * With read_only the file is opened read only and mapped into memory as a whole; GetMappedPage gives a page straight
+ * from the mapping, which lives in the OS page cache and so is shared by every process that maps the same file.
+ * The mapping is not writable, and allocating, freeing and writing pages fail. The file must not grow while it is
+ * open read only: pages beyond its size at open time are not mapped.
  */
 class DiskManager {
+  friend class AsyncIOEngine;
+
  public:
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool direct_io = DEFAULT_DIRECT_IO, bool read_only = false);
 
   ~DiskManager() {
     if (!closed) {
@@ -42,17 +87,76 @@ class DiskManager {
    */
   void WritePage(page_id_t logical_page_id, const char *page_data);
 
+  /**
+   * Read num_pages physically contiguous pages starting at logical_page_id with a single read.
+   * The pages must lie in one extent, i.e. num_pages <= GetContiguousPages(logical_page_id).
+   */
+  void ReadPages(page_id_t logical_page_id, uint32_t num_pages, char *page_data);
+
+  /**
+   * Write many pages at once, e.g. at a checkpoint. The pages are sorted by physical position and every run of
+   * physically adjacent pages (at most IOV_MAX) is written with a single vectored write; the runs are issued together
+   * through the asynchronous I/O engine. Returns when all of them are written.
+   */
+  void WritePages(std::vector<std::pair<page_id_t, const char *>> pages);
+
+  /**
+   * @return how many logical pages starting at logical_page_id are stored back to back on disk (rest of its extent)
+   */
+  static uint32_t GetContiguousPages(page_id_t logical_page_id) { return BITMAP_SIZE - logical_page_id % BITMAP_SIZE; }
+
+  /**
+   * @return number of pages written so far, lets a reader that holds no buffer pool latch detect a concurrent write
+   */
+  uint64_t GetNumWrites() const { return num_writes_; }
+
+  /** @return true if the file is read and written with O_DIRECT */
+  bool IsDirectIO() const { return direct_io_; }
+
+  /** @return size of the db file */
+  size_t GetFileSize() const { return file_size_; }
+
+  /** @return true if the file is opened read only and mapped into memory */
+  bool IsReadOnly() const { return read_only_; }
+
+  /**
+   * @return the data of a logical page inside the read only mapping, nullptr if the page lies beyond the end of file
+   * or the file is not opened read only
+   */
+  const char *GetMappedPage(page_id_t logical_page_id);
+
+  /**
+   * Write the meta page and force every write issued so far to stable storage.
+   */
+  void Sync();
+
+  /**
+   * @return the asynchronous I/O engine of this file, started on first use, or nullptr once the file is closed
+   */
+  AsyncIOEngine *GetAsyncIO();
+
   /**
    * Get next free page from disk
+   * @param reservation if not nullptr, take the next page of the owner's run, reserving a new run when it is used up
    * @return logical page id of allocated page
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(ExtentReservation *reservation = nullptr);
+
+  /**
+   * Give back the unused rest of a reservation's run to the other allocations.
+   */
+  void ReleaseReservation(ExtentReservation *reservation);
 
   /**
    * Free this page and reset bit map
    */
   void DeAllocatePage(page_id_t logical_page_id);
 
+  /**
+   * Free many pages at once, e.g. all the pages of a dropped table, clearing the bits of each extent in one pass.
+   */
+  void DeAllocatePages(std::vector<page_id_t> logical_page_ids);
+
   /**
    * Return whether specific logical_page_id is free
    */
@@ -73,33 +177,93 @@ class DiskManager {
 
  private:
   /**
-   * Helper function to get disk file size
+   * Read physical page from disk
    */
-  int GetFileSize(const std::string &file_name);
+  void ReadPhysicalPage(page_id_t physical_page_id, char *page_data);
 
   /**
-   * Read physical page from disk
+   * Read num_pages consecutive physical pages from disk, zero filling whatever lies beyond the end of file
    */
-  void ReadPhysicalPage(page_id_t physical_page_id, char *page_data);
+  void ReadPhysicalPages(page_id_t physical_page_id, uint32_t num_pages, char *page_data);
 
   /**
    * Write data to physical page in disk
    */
   void WritePhysicalPage(page_id_t physical_page_id, const char *page_data);
 
+  /**
+   * Write the buffers to consecutive physical pages starting at physical_page_id, with pwritev
+   */
+  void WritePhysicalPages(page_id_t physical_page_id, std::vector<struct iovec> iov);
+
+  /**
+   * @return false if the buffers can not be handed to the kernel as they are, i.e. O_DIRECT is on and one of them is
+   * not page aligned
+   */
+  bool CanTransferDirectly(const std::vector<struct iovec> &iov) const;
+
   /**
    * Map logical page id to physical page id
    */
   page_id_t MapPageId(page_id_t logical_page_id);
 
+  /**
+   * Record that the file now extends at least up to end, after a write
+   */
+  void ExtendFileSize(size_t end);
+
+  /**
+   * @return the resident bitmap page of an extent, read from disk on first use; db_io_latch_ must be held
+   */
+  char *GetBitmap(uint32_t extent_id);
+
+  /**
+   * Mark a free page as allocated in its bitmap and in the meta page. db_io_latch_ must be held.
+   * @return false if the page is not free
+   */
+  bool TakePage(page_id_t logical_page_id);
+
+  /**
+   * Reserve a new run for the reservation: up to EXTENT_RESERVATION_PAGES free, unreserved pages in one extent,
+   * searching from start. db_io_latch_ must be held.
+   * @return false if the file is full
+   */
+  bool ReserveRun(ExtentReservation *reservation, page_id_t start);
+
+  /**
+   * @return end of the reserved run containing logical_page_id, INVALID_PAGE_ID if it is not reserved
+   */
+  page_id_t GetReservedRunEnd(page_id_t logical_page_id);
+
+  /**
+   * @return physical page id of the bitmap page of an extent
+   */
+  static page_id_t GetBitmapPageId(uint32_t extent_id) { return extent_id * (BITMAP_SIZE + 1) + 1; }
+
  private:
-  // stream to write db file
-  std::fstream db_io_;
+  // file descriptor of the db file
+  int fd_{-1};
   std::string file_name_;
-  // with multiple buffer pool instances, need to protect file access
+  bool direct_io_{false};
+  bool read_only_{false};
+  // read only mapping of the whole file
+  char *mapping_{nullptr};
+  size_t mapping_size_{0};
+  // size of the db file, maintained by the writes instead of asking the file system on every read
+  std::atomic<size_t> file_size_{0};
+  // protects the meta page and the bitmap pages
   std::recursive_mutex db_io_latch_;
+  std::atomic<uint64_t> num_writes_{0};
+  std::atomic<AsyncIOEngine *> async_io_{nullptr};
+  // resident bitmap pages by extent (nullptr until first used) and whether they changed since the last Sync
+  std::vector<AlignedPages> bitmaps_;
+  std::vector<bool> bitmap_dirty_;
+  // every extent before this one is full
+  uint32_t free_extent_hint_{0};
+  // runs held by live reservations, first page id -> end page id
+  std::map<page_id_t, page_id_t> reserved_runs_;
   bool closed{false};
-  char meta_data_[PAGE_SIZE];
+  alignas(PAGE_SIZE) char meta_data_[PAGE_SIZE];
 };
 
 #endif
\ No newline at end of file
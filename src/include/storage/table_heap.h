@@ -1,13 +1,37 @@
 #ifndef MINISQL_TABLE_HEAP_H
 #define MINISQL_TABLE_HEAP_H
 
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
+#include "page/free_space_map_page.h"
 #include "page/header_page.h"
 #include "page/table_page.h"
 #include "recovery/log_manager.h"
 #include "storage/table_iterator.h"
 
+/**
+ * What one TableHeap::Vacuum pass reclaimed.
+ */
+struct VacuumStats {
+  uint32_t pages_scanned{0};
+  uint32_t tuples_removed{0};   // tuples marked as deleted whose slot and bytes were reclaimed
+  uint64_t bytes_reclaimed{0};  // serialized bytes of the removed tuples
+  uint32_t pages_freed{0};      // empty pages unlinked from the chain and deallocated
+
+  VacuumStats &operator+=(const VacuumStats &other) {
+    pages_scanned += other.pages_scanned;
+    tuples_removed += other.tuples_removed;
+    bytes_reclaimed += other.bytes_reclaimed;
+    pages_freed += other.pages_freed;
+    return *this;
+  }
+};
+
 class TableHeap {
   friend class TableIterator;
 
@@ -17,20 +41,38 @@ class TableHeap {
     return new TableHeap(buffer_pool_manager, schema, txn, log_manager, lock_manager);
   }
 
+  /**
+   * Open an existing table heap. Without fsm_page_id the free space map is rebuilt by one walk of the page chain on the
+   * first modification.
+   */
   static TableHeap *Create(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                           LogManager *log_manager, LockManager *lock_manager) {
-    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager);
+                           LogManager *log_manager, LockManager *lock_manager, page_id_t fsm_page_id = INVALID_PAGE_ID) {
+    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager, fsm_page_id);
   }
 
-  ~TableHeap() {}
+  ~TableHeap() { buffer_pool_manager_->ReleaseReservation(&reservation_); }
 
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
+   * The last page of the heap is tried first, then a page the free space map records enough room for, and only then a
+   * new page is appended.
    * @param[in/out] row Tuple Row to insert, the rid of the inserted tuple is wrapped in object row
    * @param[in] txn The recovery performing the insert
+   * @param[in] strategy Buffer ring for bulk inserts, nullptr to go through the shared pool
    * @return true iff the insert is successful
    */
-  bool InsertTuple(Row &row, Txn *txn);
+  bool InsertTuple(Row &row, Txn *txn, BufferAccessStrategy *strategy = nullptr);
+
+  /**
+   * Insert a batch of tuples, in order. The last page is filled first, then new pages are appended, each one filled
+   * under a single pin and latch before moving on. Unlike InsertTuple, free space elsewhere in the heap is not reused.
+   * @param[in/out] rows Tuples to insert, the rid of each inserted tuple is wrapped in its row
+   * @param[in] txn The recovery performing the insert
+   * @param[in] strategy Buffer ring for bulk inserts. If nullptr, batches of at least BULK_WRITE_MIN_ROWS rows use a
+   * bulk write ring of their own and smaller ones go through the shared pool
+   * @return number of leading rows inserted, less than rows.size() if a tuple is too large or no page is available
+   */
+  size_t InsertTuples(std::vector<Row> &rows, Txn *txn, BufferAccessStrategy *strategy = nullptr);
 
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
@@ -68,9 +110,10 @@ class TableHeap {
    * @param[in] row Current row, row id of the tuple is wrapped in row
    * @param[out] next_row Next row, row id of the tuple is wrapped in next_row
    * @param[in] txn recovery performing the read
+   * @param[in] strategy Buffer ring of the scan, nullptr to go through the shared pool
    * @return true if the read was successful (i.e. the tuple exists)
    */
-  bool GetNextTuple(const Row &row, Row &next_row, Txn *txn);
+  bool GetNextTuple(const Row &row, Row &next_row, Txn *txn, BufferAccessStrategy *strategy = nullptr);
 
   /**
    * Read a tuple from the table.
@@ -80,25 +123,38 @@ class TableHeap {
    */
   bool GetTuple(Row *row, Txn *txn);
 
+  /**
+   * Reclaim the tuples marked as deleted on every page, compact the pages and record their free space in the free space
+   * map. With free_empty_pages, pages left empty are also unlinked from the chain and deallocated, except the first and
+   * the last page and pages somebody else has pinned. latch_ is taken page by page, so inserts are not blocked for the
+   * whole walk. There is no transaction rollback: a tuple marked as deleted is treated as deleted for good.
+   * @param[in] txn Txn performing the vacuum
+   * @param[in] free_empty_pages Deallocate empty pages, only safe when no scan may be positioned on them
+   * @return what was reclaimed
+   */
+  VacuumStats Vacuum(Txn *txn, bool free_empty_pages = true);
+
+  /**
+   * @return number of tuples marked as deleted since the last vacuum, a hint for the autovacuum
+   */
+  inline uint32_t GetDeadTupleCount() const { return dead_tuples_.load(); }
+
+  /**
+   * Free all the pages of the table heap at once and give back its reserved run
+   */
   void FreeTableHeap() {
-    auto next_page_id = first_page_id_;
-    while (next_page_id != INVALID_PAGE_ID) {
-      auto old_page_id = next_page_id;
-      auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(old_page_id));
-      assert(page != nullptr);
-      next_page_id = page->GetNextPageId();
-      buffer_pool_manager_->UnpinPage(old_page_id, false);
-      buffer_pool_manager_->DeletePage(old_page_id);
-    }
+    DeleteTable();
+    buffer_pool_manager_->ReleaseReservation(&reservation_);
+    first_page_id_ = INVALID_PAGE_ID;
   }
 
   /**
-   * Free table heap and release storage in disk file
+   * Free the page chain starting at page_id (the whole table heap by default) and release storage in disk file
    */
   void DeleteTable(page_id_t page_id = INVALID_PAGE_ID);
 
   /**
-   * @return the begin iterator of this table
+   * @return the begin iterator of this table, the scan reads pages through a bulk read ring
    */
   TableIterator Begin(Txn *txn);
 
@@ -112,6 +168,11 @@ class TableHeap {
    */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /**
+   * @return the id of the first page of the free space map, to be stored next to the first page id
+   */
+  inline page_id_t GetFsmPageId() const { return fsm_page_id_; }
+
  private:
   /**
    * create table heap and initialize first page
@@ -126,12 +187,67 @@ class TableHeap {
   };
 
   explicit TableHeap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                     LogManager *log_manager, LockManager *lock_manager)
+                     LogManager *log_manager, LockManager *lock_manager, page_id_t fsm_page_id)
       : buffer_pool_manager_(buffer_pool_manager),
         first_page_id_(first_page_id),
         schema_(schema),
         log_manager_(log_manager),
-        lock_manager_(lock_manager) {}
+        lock_manager_(lock_manager),
+        fsm_page_id_(fsm_page_id) {}
+
+  /**
+   * Try to insert the row into one existing page and record the page's free space afterwards, latch_ must be held.
+   */
+  bool InsertIntoPage(page_id_t page_id, Row &row, Txn *txn, BufferAccessStrategy *strategy);
+
+  /**
+   * Insert rows[begin], rows[begin + 1], ... into a pinned and write latched page until one does not fit.
+   * @return index of the first row not inserted
+   */
+  size_t FillPage(TablePage *page, std::vector<Row> &rows, size_t begin, Txn *txn);
+
+  /**
+   * Build the in-memory index of the free space map on first use: read the map pages, then add the pages of the chain
+   * the map does not cover yet (a heap written before the map existed), latch_ must be held.
+   */
+  void LoadFreeSpaceMap();
+
+  /**
+   * Record the free space of a table page after ApplyDelete or UpdateTuple.
+   */
+  void RecordFreeSpace(page_id_t page_id, uint32_t free_space);
+
+  /**
+   * Update the category of a page already in the map, latch_ must be held.
+   */
+  void SetFreeSpace(page_id_t page_id, uint32_t free_space);
+
+  /**
+   * Add the entry of a page just linked at the end of the chain, starting a new map page when the last one is full,
+   * latch_ must be held.
+   */
+  void AppendFreeSpaceEntry(page_id_t page_id, uint32_t free_space);
+
+  /**
+   * Index the map slot of a table page, extending the run of the previous page when both are contiguous.
+   */
+  void AddFreeSpaceRun(page_id_t page_id, uint32_t slot);
+
+  /**
+   * Remove a freed table page from the map, latch_ must be held.
+   */
+  void ForgetFreeSpaceEntry(page_id_t page_id);
+
+  /**
+   * @return the map slot of a table page, or -1 if the page is not in the map
+   */
+  int LookupFreeSpaceSlot(page_id_t page_id) const;
+
+  // pages of the heap are mostly taken from contiguous runs, so the page id -> map slot index stores runs
+  struct FreeSpaceRun {
+    uint32_t first_slot;
+    uint32_t count;
+  };
 
  private:
   BufferPoolManager *buffer_pool_manager_;
@@ -139,6 +255,19 @@ class TableHeap {
   Schema *schema_;
   [[maybe_unused]] LogManager *log_manager_;
   [[maybe_unused]] LockManager *lock_manager_;
+  // run of contiguous pages new table pages are taken from
+  ExtentReservation reservation_;
+  // free space map, persisted in a chain of FreeSpaceMapPage starting at fsm_page_id_
+  std::mutex latch_;  // protects the free space map index and the end of the page chain
+  page_id_t fsm_page_id_{INVALID_PAGE_ID};
+  bool fsm_loaded_{false};
+  page_id_t last_page_id_{INVALID_PAGE_ID};  // cached tail of the page chain, tried first by inserts
+  std::vector<page_id_t> fsm_pages_;         // page ids of the map pages, in chain order
+  std::vector<uint8_t> fsm_max_;             // upper bound of the categories on each map page
+  std::map<page_id_t, FreeSpaceRun> fsm_runs_;
+  uint32_t fsm_entries_{0};
+  std::atomic<uint32_t> dead_tuples_{0};
+  std::mutex vacuum_latch_;  // one vacuum pass at a time, latch_ is only held while a page is vacuumed
 };
 
 #endif  // MINISQL_TABLE_HEAP_H
@@ -1,16 +1,32 @@
 #ifndef MINISQL_TABLE_ITERATOR_H
 #define MINISQL_TABLE_ITERATOR_H
 
+#include <memory>
+#include <vector>
+
+#include "buffer/buffer_access_strategy.h"
 #include "common/rowid.h"
 #include "concurrency/txn.h"
 #include "record/row.h"
 
 class TableHeap;
+class TablePage;
 
+/**
+ * Iterator over the live tuples of a table heap. The page under the iterator stays pinned; its live tuples are decoded
+ * into a batch under a single read latch when the iterator enters the page, and the next page is only fetched once the
+ * batch is exhausted. The batch holds copies, so the page may change under the iterator (e.g. be compacted by vacuum)
+ * without invalidating the current row; the pin only keeps the page in the chain until the iterator moves on.
+ */
 class TableIterator {
 public:
  // you may define your own constructor based on your member variables
- explicit TableIterator(TableHeap *table_heap, RowId rid, Txn *txn);
+ /**
+  * Position the iterator on the first live tuple at or after rid, following the page chain. A null table_heap makes the
+  * end iterator.
+  */
+ explicit TableIterator(TableHeap *table_heap, RowId rid, Txn *txn,
+                        std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
 
  explicit TableIterator(const TableIterator &other);
 
@@ -28,14 +44,39 @@ public:
 
   TableIterator &operator++();
 
+  /**
+   * Copies the iterator, which pins the page and copies the batch again; prefer ++iter.
+   */
   TableIterator operator++(int);
 
   TableIterator(TableIterator &other);
 private:
+  /**
+   * Pin page_id and decode its live tuples into the batch.
+   * @return false if the page can not be fetched
+   */
+  bool LoadPage(page_id_t page_id);
+
+  /**
+   * Unpin the current page and load the following pages until one has a live tuple, or become the end iterator.
+   */
+  void NextPage();
+
+  /**
+   * Unpin the current page and drop the batch.
+   */
+  void Release();
+
   TableHeap * table_heap_{nullptr};
   Txn *txn_{nullptr};
-  Row row_{Row()};
+  std::shared_ptr<BufferAccessStrategy> strategy_{nullptr};  // 扫描使用的buffer ring，迭代器的拷贝共享同一个环
+  size_t pages_scanned_{0};    // 沿着页链表已经扫描过的页数
+  size_t next_read_ahead_{0};  // 扫描到第几页时发起下一次预读
   // add your own private member variables here
+  TablePage *page_{nullptr};  // 当前 pin 住的页
+  std::vector<Row> batch_;    // 当前页的有效元组，Row 对象跨页复用
+  size_t batch_size_{0};      // batch_ 中前 batch_size_ 个有效
+  size_t pos_{0};             // 当前元组在 batch_ 中的下标
 };
 
 #endif  // MINISQL_TABLE_ITERATOR_H
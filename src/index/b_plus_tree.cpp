@@ -10,12 +10,15 @@
 /**
  * TODO: Student Implement
  */
-BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager, const KeyManager &KM, int leaf_max_size, int internal_max_size)
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_TYPE::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager, const KeyManager &KM, int leaf_max_size, int internal_max_size)
           : index_id_(index_id),
             buffer_pool_manager_(buffer_pool_manager),
             processor_(KM), // KeyManager，用于序列化和反序列化
             leaf_max_size_(leaf_max_size),
             internal_max_size_(internal_max_size) {
+  // 页里按KeySize排布键值对，必须和KeyManager的键长一致
+  ASSERT(KeySize == 0 || KeySize == processor_.GetKeySize(), "Key size does not match the key size class of the tree.");
   // 最大分叉数 = (页大小 - 指针) / (数据大小 + 指针大小)
   if(leaf_max_size == 0){
     leaf_max_size_ = (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (sizeof(RowId) + processor_.GetKeySize());
@@ -26,20 +29,52 @@ BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager
   }
   // 获取页面
   Page* page = buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID);
-  IndexRootsPage* root_page = reinterpret_cast<IndexRootsPage*>(page);
+  IndexRootsPage* root_page = reinterpret_cast<IndexRootsPage*>(page->GetData());
   root_page->GetRootId(index_id,&root_page_id_);
   buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, true);
 }
 
-// 删除当前页
-void BPlusTree::Destroy(page_id_t bpt_pageent_page_id) {
-  buffer_pool_manager_->DeletePage(bpt_pageent_page_id);
+// 删除整棵树（或以current_page_id为根的子树），先收集所有页再一次性释放
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Destroy(page_id_t current_page_id) {
+  bool whole_tree = current_page_id == INVALID_PAGE_ID || current_page_id == root_page_id_;
+  if(current_page_id == INVALID_PAGE_ID){
+    current_page_id = root_page_id_;
+  }
+  std::vector<page_id_t> page_ids;
+  std::queue<page_id_t> pending;
+  if(current_page_id != INVALID_PAGE_ID){
+    pending.push(current_page_id);
+  }
+  while(!pending.empty()){
+    page_id_t page_id = pending.front();
+    pending.pop();
+    auto *node = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(page_id)->GetData());
+    if(!node->IsLeafPage()){
+      auto *internal = reinterpret_cast<InternalPage *>(node);
+      for(int i = 0; i < internal->GetSize(); i++){
+        pending.push(internal->ValueAt(i));
+      }
+    }
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_ids.push_back(page_id);
+  }
+  buffer_pool_manager_->DeletePages(page_ids);
+  if(whole_tree){
+    // 从索引根页中删除该索引
+    auto *roots_page = reinterpret_cast<IndexRootsPage *>(buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID)->GetData());
+    roots_page->Delete(index_id_);
+    buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, true);
+    root_page_id_ = INVALID_PAGE_ID;
+    buffer_pool_manager_->ReleaseReservation(&reservation_);
+  }
 }
 
 /*
  * Helper   function to decide whether bpt_pageent b+tree is empty
  */
-bool BPlusTree::IsEmpty() const {
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsEmpty() const {
   // 根据页id判断即可
   return root_page_id_ == INVALID_PAGE_ID;
 }
@@ -52,12 +87,14 @@ bool BPlusTree::IsEmpty() const {
  * This method is used for point query
  * @return : true means key exists
  */
-bool BPlusTree::GetValue(const GenericKey *key, std::vector<RowId> &result, Txn *transaction) { 
-  auto *leaf_page = reinterpret_cast<LeafPage *>(FindLeafPage(key));
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::GetValue(const GenericKey *key, std::vector<RowId> &result, Txn *transaction) { 
+  Page *page = FindLeafPage(key);
   RowId val;
-  if(root_page_id_ == INVALID_PAGE_ID){
+  if(page == nullptr){
     return false;
   }else{
+    auto *leaf_page = reinterpret_cast<LeafPage *>(page->GetData());
     if(leaf_page->Lookup(key, val, processor_)){ // 找到
       buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
       result.push_back(val);
@@ -79,7 +116,11 @@ bool BPlusTree::GetValue(const GenericKey *key, std::vector<RowId> &result, Txn
  * @return: since we only support unique key, if user try to insert duplicate
  * keys return false, otherwise return true.
  */
-bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *transaction) { 
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::Insert(GenericKey *key, const RowId &value, Txn *transaction) { 
+  // 只读打开的数据库中页不可写
+  if(buffer_pool_manager_->IsReadOnly())
+    return false;
   if(IsEmpty()){
     StartNewTree(key, value);
     return true;
@@ -93,15 +134,16 @@ bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *transaction) {
  * an "out of memory" exception if returned value is nullptr), then update b+
  * tree's root page id and insert entry directly into leaf page.
  */
-void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::StartNewTree(GenericKey *key, const RowId &value) {
   // 申请新页
   page_id_t new_id;
-  Page *test_page = buffer_pool_manager_->NewPage(new_id);
+  Page *test_page = buffer_pool_manager_->NewPage(new_id, nullptr, &reservation_);
   // 判断内存是否足够
   if(test_page == nullptr)
     throw("Error: get new page failed!");
   // 可以创建新ye
-  BPlusTreeLeafPage *new_page = reinterpret_cast<BPlusTreeLeafPage *>(test_page->GetData());
+  LeafPage *new_page = reinterpret_cast<LeafPage *>(test_page->GetData());
   root_page_id_ = new_id;
   UpdateRootPageId(1);
   new_page->Init(new_id, INVALID_PAGE_ID, processor_.GetKeySize(), leaf_max_size_);
@@ -117,11 +159,12 @@ void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
  * @return: since we only support unique key, if user try to insert duplicate
  * keys return false, otherwise return true.
  */
-bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transaction) { 
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transaction) { 
   // 找到右边叶节点 false
-  BPlusTreeLeafPage *insert_tar = reinterpret_cast<BPlusTreeLeafPage *>(FindLeafPage(key,root_page_id_, false)->GetData());
+  LeafPage *insert_tar = reinterpret_cast<LeafPage *>(FindLeafPage(key,root_page_id_, false)->GetData());
   if(insert_tar->GetSize() >= leaf_max_size_){
-    BPlusTreeLeafPage *new_page = Split(insert_tar, transaction);
+    LeafPage *new_page = Split(insert_tar, transaction);
     if (processor_.CompareKeys(key, new_page->KeyAt(0)) > 0) {
       new_page->Insert(key, value, processor_);
     } else {
@@ -147,32 +190,37 @@ bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transac
  * an "out of memory" exception if returned value is nullptr), then move half
  * of key & value pairs from input page to newly created page
  */
-BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Txn *transaction) { 
+INDEX_TEMPLATE_ARGUMENTS
+BPlusTreeInternalPage<KeySize> *BPLUSTREE_TYPE::Split(InternalPage *node, Txn *transaction) { 
   page_id_t id;
-  BPlusTreeInternalPage *new_page = reinterpret_cast<BPlusTreeInternalPage *>(buffer_pool_manager_->NewPage(id));
-  if(new_page == nullptr){
+  Page *page = buffer_pool_manager_->NewPage(id, nullptr, &reservation_);
+  if(page == nullptr){
     throw("Error: out of memory!");
     return nullptr;
   }else{
-    new_page->Init(id, node->GetParentPageId(), processor_.GetKeySize(), leaf_max_size_);
+    auto *new_page = reinterpret_cast<InternalPage *>(page->GetData());
+    new_page->Init(id, node->GetParentPageId(), processor_.GetKeySize(), internal_max_size_);
     node->MoveHalfTo(new_page, buffer_pool_manager_);
-    buffer_pool_manager_->UnpinPage(id, true);
+    // 新页保持pin住，由调用者用完后unpin
     return new_page;
   }
 }
 
-BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction) { 
+INDEX_TEMPLATE_ARGUMENTS
+BPlusTreeLeafPage<KeySize> *BPLUSTREE_TYPE::Split(LeafPage *node, Txn *transaction) { 
   page_id_t id;
-  BPlusTreeLeafPage *new_page = reinterpret_cast<BPlusTreeLeafPage *>(buffer_pool_manager_->NewPage(id));
-  if(new_page == nullptr){
+  Page *page = buffer_pool_manager_->NewPage(id, nullptr, &reservation_);
+  if(page == nullptr){
     throw("Error: out of memory!");
     return nullptr;
   }else{
+    auto *new_page = reinterpret_cast<LeafPage *>(page->GetData());
     new_page->Init(id, node->GetParentPageId(), processor_.GetKeySize(), leaf_max_size_);
     node->MoveHalfTo(new_page);
-    node->SetNextPageId(new_page->GetPageId());
+    // 新页接在node后面，先接上node原来的下一页
     new_page->SetNextPageId(node->GetNextPageId());
-    buffer_pool_manager_->UnpinPage(id, true);
+    node->SetNextPageId(new_page->GetPageId());
+    // 新页保持pin住，由调用者用完后unpin
     return new_page;
   }
 }
@@ -186,11 +234,12 @@ BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction) {
  * adjusted to take info of new_node into account. Remember to deal with split
  * recursively if necessary.
  */
-void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node, Txn *transaction) {
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node, Txn *transaction) {
   page_id_t id;
   if(old_node->IsRootPage()){ // 创建新的根节点
-    auto new_page = reinterpret_cast<BPlusTreeInternalPage *>(buffer_pool_manager_->NewPage(id)->GetData());
-    new_page->Init(id, INVALID_PAGE_ID, old_node->GetKeySize(), leaf_max_size_);
+    auto new_page = reinterpret_cast<InternalPage *>(buffer_pool_manager_->NewPage(id, nullptr, &reservation_)->GetData());
+    new_page->Init(id, INVALID_PAGE_ID, old_node->GetKeySize(), internal_max_size_);
     new_page->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
     root_page_id_ = id;
     UpdateRootPageId(0);  // 取0，对根进行更新
@@ -199,12 +248,13 @@ void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlus
     buffer_pool_manager_->UnpinPage(id, true);
   }else{  // 非根节点
     id = old_node->GetParentPageId();
-    auto parent_page = reinterpret_cast<BPlusTreeInternalPage *>(buffer_pool_manager_->FetchPage(old_node->GetParentPageId())->GetData());
+    auto parent_page = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(old_node->GetParentPageId())->GetData());
     int size = parent_page->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
     // 超出内部节点大小，需要分裂，递归向上
     if(size >= internal_max_size_){
-      BPlusTreeInternalPage *new_page = reinterpret_cast<BPlusTreeInternalPage *>(Split(parent_page, transaction));
+      InternalPage *new_page = Split(parent_page, transaction);
       InsertIntoParent(parent_page, new_page->KeyAt(0), new_page, transaction);
+      buffer_pool_manager_->UnpinPage(new_page->GetPageId(), true);
     }
     buffer_pool_manager_->UnpinPage(id, true);
   }
@@ -220,19 +270,22 @@ void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlus
  * delete entry from leaf page. Remember to deal with redistribute or merge if
  * necessary.
  */
-void BPlusTree::Remove(const GenericKey *key, Txn *transaction) {
-  if(IsEmpty()){
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Remove(const GenericKey *key, Txn *transaction) {
+  if(IsEmpty() || buffer_pool_manager_->IsReadOnly()){
     return;
   }else{
-    BPlusTreeLeafPage *leaf_page = reinterpret_cast<BPlusTreeLeafPage *>(FindLeafPage(key, root_page_id_, false)->GetData());
+    LeafPage *leaf_page = reinterpret_cast<LeafPage *>(FindLeafPage(key, root_page_id_, false)->GetData());
     // 删除键值对后有两种情况：删除后比半满小，需要合并；
     // 删除了叶子节点第一个元素，需要更新父节点
     // 但实际上这个操作是多余的，中间节点只是起到一个索引作用，所以不需要实现（上课也讲过）
     leaf_page->RemoveAndDeleteRecord(key, processor_);
-    if(CoalesceOrRedistribute(leaf_page, transaction)){
-      buffer_pool_manager_->DeletePage(leaf_page->GetPageId());
-    }else{
-      buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), true);
+    page_id_t leaf_id = leaf_page->GetPageId();
+    bool should_delete = CoalesceOrRedistribute(leaf_page, transaction);
+    // 先unpin再删除，被pin住的页删不掉
+    buffer_pool_manager_->UnpinPage(leaf_id, true);
+    if(should_delete){
+      buffer_pool_manager_->DeletePage(leaf_id);
     }
   }
 }
@@ -244,83 +297,80 @@ void BPlusTree::Remove(const GenericKey *key, Txn *transaction) {
  * @return: true means target leaf page should be deleted, false means no
  * deletion happens
  */
+INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-bool BPlusTree::CoalesceOrRedistribute(N *&node, Txn *transaction) {
+bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *&node, Txn *transaction) {
   // case0: node 是根节点，使用 AdjustRoot
   // 从父节点爬到兄弟节点
-  // case1：node 不是第一个节点，前一个兄弟大小比最小大小大，调用redis
-  // case2：node 无法redis，且不是第一个节点，和前一个合并，调用coalesce
-  // case3：node 不是最后一个节点，后一个兄弟大小比最小大小大，调用redis
-  // case4：node 无法redis，且是一个节点，和后一个合并，调用coalesce
-  // 最后判断父节点是否比最小大小小，如果小就递归
-  // true 则删除 node，false 则不删除
-  N *sibling_page;
-  page_id_t sibling_id;
-  BPlusTreeInternalPage *parent_page = reinterpret_cast<BPlusTreeInternalPage *>(buffer_pool_manager_->FetchPage(node->GetParentPageId())->GetData());
-  if(node->IsRootPage()) 
+  // case1：node 不是第一个节点，和前一个兄弟合并放不下，调用redis
+  // case2：node 不是第一个节点，能放下，node并入前一个兄弟，调用coalesce
+  // case3：node 是第一个节点，和后一个兄弟合并放不下，调用redis
+  // case4：node 是第一个节点，能放下，后一个兄弟并入node，由这里删除兄弟
+  // 合并总是把右边的页并入左边的页，父节点在coalesce里递归处理
+  // true 则删除 node，false 则不删除（node 由调用者unpin）
+  if(node->IsRootPage())
     return AdjustRoot(node);
-  else if(node->GetSize() < node->GetMinSize()){
-    int node_index = parent_page->ValueIndex(node->GetPageId());
-    if(node_index > 0){ // 不是第一个节点
-      // 兄弟节点设为node前一个
-      // sibling_id = parent_page->ValueAt(node_index - 1);
-      sibling_page = reinterpret_cast<N *>(buffer_pool_manager_->FetchPage(parent_page->ValueAt(node_index - 1))->GetData());
-    }else{  // 第一个节点
-      // 兄弟节点 设为第一个，node为第二个
-      // sibling_id = parent_page->ValueAt(0);
-      sibling_page = node;
-      node = reinterpret_cast<N *>(buffer_pool_manager_->FetchPage(parent_page->ValueAt(1))->GetData());
-    }
-    // 合并
-    if(node->GetSize() + sibling_page->GetSize() <= node->GetMaxSize()){
-      buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
-      if(!Coalesce(sibling_page, node, parent_page, node_index, transaction))
-        buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-      return true;
-    }else{  // 分裂
-      Redistribute(sibling_page, node, node_index);
-      buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-      buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
-      return false;
-    }
+  if(node->GetSize() >= node->GetMinSize())
+    return false;
+  page_id_t parent_id = node->GetParentPageId();
+  auto *parent_page = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(parent_id)->GetData());
+  int node_index = parent_page->ValueIndex(node->GetPageId());
+  page_id_t sibling_id = parent_page->ValueAt(node_index == 0 ? 1 : node_index - 1);
+  auto *sibling_page = reinterpret_cast<N *>(buffer_pool_manager_->FetchPage(sibling_id)->GetData());
+  // 叶子平时最多存 max 个，内部节点插入后满了就分裂，平时最多存 max - 1 个
+  int merge_limit = node->IsLeafPage() ? node->GetMaxSize() : node->GetMaxSize() - 1;
+  if(node->GetSize() + sibling_page->GetSize() > merge_limit){
+    Redistribute(sibling_page, node, node_index);
+    buffer_pool_manager_->UnpinPage(sibling_id, true);
+    buffer_pool_manager_->UnpinPage(parent_id, true);
+    return false;
+  }
+  bool delete_parent;
+  bool delete_node;
+  if(node_index == 0){
+    // 兄弟在右边，把兄弟并入node，node保留
+    delete_parent = Coalesce(node, sibling_page, parent_page, 1, transaction);
+    buffer_pool_manager_->UnpinPage(sibling_id, true);
+    buffer_pool_manager_->DeletePage(sibling_id);
+    delete_node = false;
+  }else{
+    delete_parent = Coalesce(sibling_page, node, parent_page, node_index, transaction);
+    buffer_pool_manager_->UnpinPage(sibling_id, true);
+    delete_node = true;
+  }
+  buffer_pool_manager_->UnpinPage(parent_id, true);
+  if(delete_parent){
+    buffer_pool_manager_->DeletePage(parent_id);
   }
+  return delete_node;
 }
 
 /*
- * Move all the key & value pairs from one page to its sibling page, and notify
- * buffer pool manager to delete this page. Parent page must be adjusted to
- * take info of deletion into account. Remember to deal with coalesce or
- * redistribute recursively if necessary.
- * Using template N to represent either internal page or leaf page.
- * @param   neighbor_node      sibling page of input "node"
- * @param   node               input from method coalesceOrRedistribute()
- * @param   parent             parent page of input "node"
+ * Move all the key & value pairs from one page to its sibling page. The caller
+ * deletes the emptied page. Parent page must be adjusted to take info of
+ * deletion into account. Remember to deal with coalesce or redistribute
+ * recursively if necessary.
+ * @param   neighbor_node      left page that receives the pairs
+ * @param   node               right page that is emptied
+ * @param   parent             parent page of both pages
+ * @param   index              index of node in parent
  * @return  true means parent node should be deleted, false means no deletion happened
  */
-bool BPlusTree::Coalesce(LeafPage *&neighbor_node, LeafPage *&node, InternalPage *&parent, int index,
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::Coalesce(LeafPage *&neighbor_node, LeafPage *&node, InternalPage *&parent, int index,
                          Txn *transaction) {
-  int idx_tmp = index == 0 ? 1 : index;
   node->MoveAllTo(neighbor_node);
-  parent->Remove(idx_tmp);  // 调整父节点
-  if(parent->GetSize() < parent->GetMinSize()){
-    return CoalesceOrRedistribute(parent, transaction);
-  }else{
-    return false;
-  }
-  buffer_pool_manager_->UnpinPage(node->GetPageId(), false);  // 通知buffer
+  parent->Remove(index);  // 调整父节点
+  return CoalesceOrRedistribute(parent, transaction);
 }
 
-bool BPlusTree::Coalesce(InternalPage *&neighbor_node, InternalPage *&node, InternalPage *&parent, int index,
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::Coalesce(InternalPage *&neighbor_node, InternalPage *&node, InternalPage *&parent, int index,
                          Txn *transaction) {
-  int idx_tmp = index == 0 ? 1 : index;
-  node->MoveAllTo(neighbor_node, parent->KeyAt(idx_tmp), buffer_pool_manager_);
-  parent->Remove(idx_tmp);
-  if(parent->GetSize() < parent->GetMinSize()){
-    return CoalesceOrRedistribute(parent, transaction);
-  }else{
-    return false;
-  }
-  buffer_pool_manager_->UnpinPage(node->GetPageId(), false);  // 通知buffer
+  // 父节点里的分隔键下放到左边的页
+  node->MoveAllTo(neighbor_node, parent->KeyAt(index), buffer_pool_manager_);
+  parent->Remove(index);
+  return CoalesceOrRedistribute(parent, transaction);
 }
 /*
  * Redistribute key & value pairs from one page to its sibling page. If index ==
@@ -331,26 +381,31 @@ bool BPlusTree::Coalesce(InternalPage *&neighbor_node, InternalPage *&node, Inte
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
  */
-void BPlusTree::Redistribute(LeafPage *neighbor_node, LeafPage *node, int index) {
-  BPlusTreeInternalPage *parent_node = reinterpret_cast<BPlusTreeInternalPage *>(buffer_pool_manager_->FetchPage(node->GetParentPageId()));
-  if(index == 0){ // first
-    node->MoveFirstToEndOf(neighbor_node);
-    parent_node->SetKeyAt(parent_node->ValueIndex(neighbor_node->GetPageId()), neighbor_node->KeyAt(0));
-  }else{  // last
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Redistribute(LeafPage *neighbor_node, LeafPage *node, int index) {
+  auto *parent_node = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(node->GetParentPageId())->GetData());
+  if(index == 0){ // 兄弟在右边，借兄弟的第一个
+    neighbor_node->MoveFirstToEndOf(node);
+    parent_node->SetKeyAt(1, neighbor_node->KeyAt(0));
+  }else{  // 兄弟在左边，借兄弟的最后一个
     neighbor_node->MoveLastToFrontOf(node);
-    parent_node->SetKeyAt(parent_node->ValueIndex(node->GetPageId()), node->KeyAt(0));
+    parent_node->SetKeyAt(index, node->KeyAt(0));
   }
   buffer_pool_manager_->UnpinPage(node->GetParentPageId(), true);
 }
 
-void BPlusTree::Redistribute(InternalPage *neighbor_node, InternalPage *node, int index) {
-  BPlusTreeInternalPage *parent_node = reinterpret_cast<BPlusTreeInternalPage *>(buffer_pool_manager_->FetchPage(node->GetParentPageId()));
-  if(index == 0){ // first
-    node->MoveFirstToEndOf(node, parent_node->KeyAt(0), buffer_pool_manager_);
-    parent_node->SetKeyAt(parent_node->ValueIndex(neighbor_node->GetPageId()), neighbor_node->KeyAt(0));
-  }else{  // last
-    neighbor_node->MoveLastToFrontOf(node, parent_node->KeyAt(1), buffer_pool_manager_);
-    parent_node->SetKeyAt(parent_node->ValueIndex(node->GetPageId()), node->KeyAt(0));
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Redistribute(InternalPage *neighbor_node, InternalPage *node, int index) {
+  auto *parent_node = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(node->GetParentPageId())->GetData());
+  if(index == 0){ // 兄弟在右边，分隔键下放到node末尾，兄弟剩下的第一个键上移
+    neighbor_node->MoveFirstToEndOf(node, parent_node->KeyAt(1), buffer_pool_manager_);
+    parent_node->SetKeyAt(1, neighbor_node->KeyAt(0));
+  }else{  // 兄弟在左边，分隔键下放到node开头，兄弟的最后一个键上移
+    GenericKey *last_key = processor_.InitKey();
+    memcpy(last_key, neighbor_node->KeyAt(neighbor_node->GetSize() - 1), processor_.GetKeySize());
+    neighbor_node->MoveLastToFrontOf(node, parent_node->KeyAt(index), buffer_pool_manager_);
+    parent_node->SetKeyAt(index, last_key);
+    free(last_key);
   }
   buffer_pool_manager_->UnpinPage(node->GetParentPageId(), true);
 }
@@ -364,15 +419,16 @@ void BPlusTree::Redistribute(InternalPage *neighbor_node, InternalPage *node, in
  * @return : true means root page should be deleted, false means no deletion
  * happened
  */
-bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
-  if(old_root_node->GetSize() == 1){  // 还有一个
-    root_page_id_ = reinterpret_cast<BPlusTreeInternalPage *>(old_root_node)->ValueAt(0);
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
+  if(!old_root_node->IsLeafPage() && old_root_node->GetSize() == 1){  // 内部根只剩一个孩子，孩子成为新根
+    root_page_id_ = reinterpret_cast<InternalPage *>(old_root_node)->ValueAt(0);
     UpdateRootPageId(0);
-    BPlusTreeInternalPage *new_root = reinterpret_cast<BPlusTreeInternalPage *>(buffer_pool_manager_->FetchPage(root_page_id_));
+    auto *new_root = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(root_page_id_)->GetData());
     new_root->SetParentPageId(INVALID_PAGE_ID); // 设为新根
     buffer_pool_manager_->UnpinPage(root_page_id_, true);
     return true;
-  }else if(old_root_node->GetSize() == 0){  // 最后一个
+  }else if(old_root_node->IsLeafPage() && old_root_node->GetSize() == 0){  // 最后一个
     // 直接删掉
     root_page_id_ = INVALID_PAGE_ID;
     UpdateRootPageId(0);
@@ -390,11 +446,12 @@ bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
  * index iterator
  * @return : index iterator
  */
-IndexIterator BPlusTree::Begin() {
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator<KeySize> BPLUSTREE_TYPE::Begin() {
   // true 最左边
-  BPlusTreeLeafPage *leaf_page = reinterpret_cast<BPlusTreeLeafPage *>(FindLeafPage(nullptr, INVALID_PAGE_ID, true));
+  LeafPage *leaf_page = reinterpret_cast<LeafPage *>(FindLeafPage(nullptr, INVALID_PAGE_ID, true)->GetData());
   buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
-  return IndexIterator(leaf_page->GetPageId(), buffer_pool_manager_, 0);
+  return IndexIterator<KeySize>(leaf_page->GetPageId(), buffer_pool_manager_, 0);
 }
 
 /*
@@ -402,10 +459,11 @@ IndexIterator BPlusTree::Begin() {
  * first, then construct index iterator
  * @return : index iterator
  */
-IndexIterator BPlusTree::Begin(const GenericKey *key) {
-  BPlusTreeLeafPage *leaf_page = reinterpret_cast<BPlusTreeLeafPage *>(FindLeafPage(key, INVALID_PAGE_ID, false));
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator<KeySize> BPLUSTREE_TYPE::Begin(const GenericKey *key) {
+  LeafPage *leaf_page = reinterpret_cast<LeafPage *>(FindLeafPage(key, INVALID_PAGE_ID, false)->GetData());
   buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
-  return IndexIterator(leaf_page->GetPageId(), buffer_pool_manager_, leaf_page->KeyIndex(key, processor_));
+  return IndexIterator<KeySize>(leaf_page->GetPageId(), buffer_pool_manager_, leaf_page->KeyIndex(key, processor_));
 }
 
 /*
@@ -413,8 +471,9 @@ IndexIterator BPlusTree::Begin(const GenericKey *key) {
  * of the key/value pair in the leaf node
  * @return : index iterator
  */
-IndexIterator BPlusTree::End() { 
-  return IndexIterator(); 
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator<KeySize> BPLUSTREE_TYPE::End() { 
+  return IndexIterator<KeySize>(); 
 }
 
 /*****************************************************************************
@@ -425,7 +484,8 @@ IndexIterator BPlusTree::End() {
  * the left most leaf page
  * Note: the leaf page is pinned, you need to unpin it after use.
  */
-Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool leftMost) {
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPage(const GenericKey *key, page_id_t page_id, bool leftMost) {
   if(IsEmpty()) 
     return nullptr;
   // 抓取根节点，从根节点一直到叶子
@@ -436,7 +496,7 @@ Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool lef
 
   while(!now_bpt_page->IsLeafPage()) {
     buffer_pool_manager_->UnpinPage(now_id, false);
-    auto *in_bpt_page = reinterpret_cast<InternalPage *>(now_page);
+    auto *in_bpt_page = reinterpret_cast<InternalPage *>(now_page->GetData());
     if(leftMost){ // 最左边
       now_id = in_bpt_page->ValueAt(0);
     }else{  // 一般情况
@@ -456,12 +516,12 @@ Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool lef
  * insert a record <index_name, bpt_pageent_page_id> into header page instead of
  * updating it.
  */
-void BPlusTree::UpdateRootPageId(int insert_record) {
-  auto *root_page = reinterpret_cast<IndexRootsPage *>(buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID));
-  if(insert_record == 0){ // false 更新
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
+  auto *root_page = reinterpret_cast<IndexRootsPage *>(buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID)->GetData());
+  // 树删空后记录还在，重新建树时插入会失败，这时改为更新
+  if(insert_record == 0 || !root_page->Insert(index_id_, root_page_id_)){ // false 更新
     root_page->Update(index_id_, root_page_id_);
-  }else{
-    root_page->Insert(index_id_, root_page_id_);
   }
   buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, true);
 }
@@ -469,7 +529,8 @@ void BPlusTree::UpdateRootPageId(int insert_record) {
 /**
  * This method is used for debug only, You don't need to modify
  */
-void BPlusTree::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out, Schema *schema) const {
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out, Schema *schema) const {
   std::string leaf_prefix("LEAF_");
   std::string internal_prefix("INT_");
   if (page->IsLeafPage()) {
@@ -560,7 +621,8 @@ void BPlusTree::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstre
 /**
  * This function is for debug only, you don't need to modify
  */
-void BPlusTree::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const {
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const {
   if (page->IsLeafPage()) {
     auto *leaf = reinterpret_cast<LeafPage *>(page);
     std::cout << "Leaf Page: " << leaf->GetPageId() << " parent: " << leaf->GetParentPageId()
@@ -585,10 +647,18 @@ void BPlusTree::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const {
   }
 }
 
-bool BPlusTree::Check() {
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::Check() {
   bool all_unpinned = buffer_pool_manager_->CheckAllUnpinned();
   if (!all_unpinned) {
     LOG(ERROR) << "problem in page unpin" << endl;
   }
   return all_unpinned;
-}
\ No newline at end of file
+}
+
+template class BPlusTree<0>;
+template class BPlusTree<16>;
+template class BPlusTree<32>;
+template class BPlusTree<64>;
+template class BPlusTree<128>;
+template class BPlusTree<256>;
@@ -3,13 +3,15 @@
 #include "index/generic_key.h"
 #include "utils/tree_file_mgr.h"
 #include <algorithm>
-BPlusTreeIndex::BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size,
-                               BufferPoolManager *buffer_pool_manager)
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size,
+                                     BufferPoolManager *buffer_pool_manager, KeyFormat key_format)
     : Index(index_id, key_schema),
-      processor_(key_schema_, key_size),
+      processor_(key_schema_, key_size, key_format),
       container_(index_id, buffer_pool_manager, processor_) {}
 
-dberr_t BPlusTreeIndex::InsertEntry(const Row &key, RowId row_id, Txn *txn) {
+INDEX_TEMPLATE_ARGUMENTS
+dberr_t BPLUSTREE_INDEX_TYPE::InsertEntry(const Row &key, RowId row_id, Txn *txn) {
   // ASSERT(row_id.Get() != INVALID_ROWID.Get(), "Invalid row id for index insert.");
   GenericKey *index_key = processor_.InitKey();
   processor_.SerializeFromKey(index_key, key, key_schema_);
@@ -27,7 +29,8 @@ dberr_t BPlusTreeIndex::InsertEntry(const Row &key, RowId row_id, Txn *txn) {
   return DB_SUCCESS;
 }
 
-dberr_t BPlusTreeIndex::RemoveEntry(const Row &key, RowId row_id, Txn *txn) {
+INDEX_TEMPLATE_ARGUMENTS
+dberr_t BPLUSTREE_INDEX_TYPE::RemoveEntry(const Row &key, RowId row_id, Txn *txn) {
   GenericKey *index_key = processor_.InitKey();
   processor_.SerializeFromKey(index_key, key, key_schema_);
 
@@ -36,7 +39,8 @@ dberr_t BPlusTreeIndex::RemoveEntry(const Row &key, RowId row_id, Txn *txn) {
   return DB_SUCCESS;
 }
 
-dberr_t BPlusTreeIndex::ScanKey(const Row &key, vector<RowId> &result, Txn *txn, string compare_operator) {
+INDEX_TEMPLATE_ARGUMENTS
+dberr_t BPLUSTREE_INDEX_TYPE::ScanKey(const Row &key, vector<RowId> &result, Txn *txn, string compare_operator) {
   GenericKey *index_key = processor_.InitKey();
   processor_.SerializeFromKey(index_key, key, key_schema_);
   auto end_iter = GetEndIterator();
@@ -79,19 +83,30 @@ dberr_t BPlusTreeIndex::ScanKey(const Row &key, vector<RowId> &result, Txn *txn,
     return DB_KEY_NOT_FOUND;
 }
 
-dberr_t BPlusTreeIndex::Destroy() {
+INDEX_TEMPLATE_ARGUMENTS
+dberr_t BPLUSTREE_INDEX_TYPE::Destroy() {
   container_.Destroy();
   return DB_SUCCESS;
 }
 
-IndexIterator BPlusTreeIndex::GetBeginIterator() {
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator<KeySize> BPLUSTREE_INDEX_TYPE::GetBeginIterator() {
   return container_.Begin();
 }
 
-IndexIterator BPlusTreeIndex::GetBeginIterator(GenericKey *key) {
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator<KeySize> BPLUSTREE_INDEX_TYPE::GetBeginIterator(GenericKey *key) {
   return container_.Begin(key);
 }
 
-IndexIterator BPlusTreeIndex::GetEndIterator() {
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator<KeySize> BPLUSTREE_INDEX_TYPE::GetEndIterator() {
   return container_.End();
-}
\ No newline at end of file
+}
+
+template class BPlusTreeIndex<0>;
+template class BPlusTreeIndex<16>;
+template class BPlusTreeIndex<32>;
+template class BPlusTreeIndex<64>;
+template class BPlusTreeIndex<128>;
+template class BPlusTreeIndex<256>;
@@ -0,0 +1,188 @@
+#include "index/generic_key.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KEY_SEARCH_AVX2
+#endif
+
+// 二分查找缩小到这么多个键以内后，再按前缀顺序数
+static constexpr int PREFIX_SCAN_KEYS = 32;
+// 规范化键的前缀，按大端读，无符号比较的顺序就是键的顺序
+static constexpr uint32_t PREFIX_SIZE = sizeof(uint32_t);
+// 前缀跳过第一列的空标记，否则非空键的前缀第一个字节都是1，密集的整数键前缀几乎全相同
+static constexpr uint32_t PREFIX_OFFSET = 1;
+
+static inline uint32_t ReadBigEndian(const char *buf) {
+  auto bytes = reinterpret_cast<const uint8_t *>(buf);
+  return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+         (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+}
+
+static inline void WriteBigEndian(char *buf, uint32_t value) {
+  auto bytes = reinterpret_cast<uint8_t *>(buf);
+  bytes[0] = static_cast<uint8_t>(value >> 24);
+  bytes[1] = static_cast<uint8_t>(value >> 16);
+  bytes[2] = static_cast<uint8_t>(value >> 8);
+  bytes[3] = static_cast<uint8_t>(value);
+}
+
+// 列在规范化键里的宽度，不含空标记
+static inline uint32_t NormalizedWidth(const Column *column) {
+  return column->GetType() == TypeId::kTypeChar ? column->GetLength() : Type::GetTypeSize(column->GetType());
+}
+
+uint32_t KeyManager::GetNormalizedKeySize(const Schema *key_schema) {
+  uint32_t size = 0;
+  for (auto column : key_schema->GetColumns()) {
+    size += 1 + NormalizedWidth(column);
+  }
+  return size;
+}
+
+void KeyManager::EncodeNormalized(char *buf, const Row &key) const {
+  ASSERT(key.GetFieldCount() == key_types_.size(), "field nums not match.");
+  memset(buf, 0, key_size_);
+  const auto &columns = key_schema_->GetColumns();
+  char *p = buf;
+  for (uint32_t i = 0; i < key_types_.size(); i++) {
+    uint32_t width = NormalizedWidth(columns[i]);
+    Field *field = key.GetField(i);
+    if (field->IsNull()) {  // 空值标记为0，值全为0，排在最前面
+      p += 1 + width;
+      continue;
+    }
+    *p++ = 1;
+    if (key_types_[i] == TypeId::kTypeChar) {
+      // 补0到列宽，不含0字节的字符串按字节序比较和原来的顺序一致
+      uint32_t len = field->GetLength();
+      ASSERT(len <= width, "Index key size exceed max key size.");
+      memcpy(p, field->GetData(), std::min(len, width));
+    } else {
+      uint32_t bits;
+      field->SerializeTo(reinterpret_cast<char *>(&bits));
+      if (key_types_[i] == TypeId::kTypeInt) {
+        bits ^= 0x80000000u;  // 翻转符号位，负数排在正数前面
+      } else {
+        float value;
+        memcpy(&value, &bits, sizeof(float));
+        if (value == 0.0f) {
+          bits = 0;  // -0.0 和 0.0 相等
+        }
+        // 正数翻转符号位，负数全部取反，这样越小的负数字节序越小
+        bits = (bits & 0x80000000u) ? ~bits : bits ^ 0x80000000u;
+      }
+      WriteBigEndian(p, bits);
+    }
+    p += width;
+  }
+}
+
+void KeyManager::DecodeNormalized(const char *buf, Row &key) const {
+  key.destroy();
+  const auto &columns = key_schema_->GetColumns();
+  const char *p = buf;
+  for (uint32_t i = 0; i < key_types_.size(); i++) {
+    uint32_t width = NormalizedWidth(columns[i]);
+    if (*p++ == 0) {
+      key.GetFields().push_back(new Field(key_types_[i]));
+      p += width;
+      continue;
+    }
+    if (key_types_[i] == TypeId::kTypeChar) {
+      uint32_t len = strnlen(p, width);
+      key.GetFields().push_back(new Field(TypeId::kTypeChar, const_cast<char *>(p), len, true));
+    } else {
+      uint32_t bits = ReadBigEndian(p);
+      if (key_types_[i] == TypeId::kTypeInt) {
+        key.GetFields().push_back(new Field(TypeId::kTypeInt, static_cast<int32_t>(bits ^ 0x80000000u)));
+      } else {
+        bits = (bits & 0x80000000u) ? bits ^ 0x80000000u : ~bits;
+        float value;
+        memcpy(&value, &bits, sizeof(float));
+        key.GetFields().push_back(new Field(TypeId::kTypeFloat, value));
+      }
+    }
+    p += width;
+  }
+}
+
+#ifdef KEY_SEARCH_AVX2
+/**
+ * 一次数8个前缀小于target的键，stride是键之间的字节数
+ * gather按小端读4个字节，先反转字节序，再翻转符号位把无符号比较变成有符号比较
+ */
+__attribute__((target("avx2"))) static int CountSmallerPrefixesAVX2(const char *base, size_t stride, int count,
+                                                                     uint32_t target) {
+  const __m256i index = _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(stride)),
+                                           _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4,
+                                         11, 10, 9, 8, 15, 14, 13, 12);
+  const __m256i sign = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+  const __m256i needle = _mm256_set1_epi32(static_cast<int>(target ^ 0x80000000u));
+  int smaller = 0;
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i prefixes = _mm256_i32gather_epi32(reinterpret_cast<const int *>(base + i * stride), index, 1);
+    prefixes = _mm256_xor_si256(_mm256_shuffle_epi8(prefixes, bswap), sign);
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(needle, prefixes)));
+    smaller += __builtin_popcount(mask);
+    if (mask != 0xFF) {  // 键是有序的，后面不会再有更小的
+      return smaller;
+    }
+  }
+  for (; i < count && ReadBigEndian(base + i * stride) < target; i++) {
+    smaller++;
+  }
+  return smaller;
+}
+
+static bool HasAVX2() {
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  return has_avx2;
+}
+#endif
+
+static int CountSmallerPrefixes(const char *base, size_t stride, int count, uint32_t target) {
+#ifdef KEY_SEARCH_AVX2
+  if (HasAVX2()) {
+    return CountSmallerPrefixesAVX2(base, stride, count, target);
+  }
+#endif
+  int smaller = 0;
+  while (smaller < count && ReadBigEndian(base + smaller * stride) < target) {
+    smaller++;
+  }
+  return smaller;
+}
+
+int KeyManager::LowerBound(const char *base, size_t stride, int lo, int hi, const GenericKey *key) const {
+  auto key_at = [base, stride](int i) { return reinterpret_cast<const GenericKey *>(base + i * stride); };
+  if (format_ != KeyFormat::kNormalized || !prefix_search_) {
+    // 行格式的键，和前缀不在第一列值里的规范化键，只做二分查找
+    while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      if (CompareKeys(key_at(mid), key) < 0) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+  while (hi - lo > PREFIX_SCAN_KEYS) {
+    int mid = (lo + hi) / 2;
+    if (memcmp(key_at(mid)->data, key->data, normalized_size_) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  // 前缀更小的键一定更小，前缀相同的键再完整比较
+  uint32_t target = ReadBigEndian(key->data + PREFIX_OFFSET);
+  lo += CountSmallerPrefixes(key_at(lo)->data + PREFIX_OFFSET, stride, hi - lo, target);
+  while (lo < hi && ReadBigEndian(key_at(lo)->data + PREFIX_OFFSET) == target &&
+         memcmp(key_at(lo)->data, key->data, normalized_size_) < 0) {
+    lo++;
+  }
+  return lo;
+}
@@ -3,39 +3,57 @@
 #include "index/basic_comparator.h"
 #include "index/generic_key.h"
 
-IndexIterator::IndexIterator() = default;
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator() = default;
 
-IndexIterator::IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index)
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index)
     : current_page_id(page_id), item_index(index), buffer_pool_manager(bpm) {
   page = reinterpret_cast<LeafPage *>(buffer_pool_manager->FetchPage(current_page_id)->GetData());
 }
 
-IndexIterator::~IndexIterator() {
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::~IndexIterator() {
   if (current_page_id != INVALID_PAGE_ID)
     buffer_pool_manager->UnpinPage(current_page_id, false);
 }
 
-std::pair<GenericKey *, RowId> IndexIterator::operator*() {
+INDEX_TEMPLATE_ARGUMENTS
+std::pair<GenericKey *, RowId> INDEXITERATOR_TYPE::operator*() {
   return page->GetItem(item_index); // 前迭代器指向的索引项数据
 }
 
-IndexIterator &IndexIterator::operator++() {
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
   // 先检查到没到当前页最后了，如果到了，就unpin掉然后fetch下一页
   if(item_index < page->GetSize() - 1){
     item_index++;
   }else{
     buffer_pool_manager->UnpinPage(current_page_id, false);
     current_page_id = page->GetNextPageId();
-    page = reinterpret_cast<BPlusTreeLeafPage *>(buffer_pool_manager->FetchPage(page->GetNextPageId()));
+    // 最后一个叶子之后就是End()，不再抓取页
+    page = nullptr;
+    if(current_page_id != INVALID_PAGE_ID){
+      page = reinterpret_cast<LeafPage *>(buffer_pool_manager->FetchPage(current_page_id)->GetData());
+    }
     item_index = 0;
   }
   return *this;
 }
 
-bool IndexIterator::operator==(const IndexIterator &itr) const {
+INDEX_TEMPLATE_ARGUMENTS
+bool INDEXITERATOR_TYPE::operator==(const IndexIterator &itr) const {
   return current_page_id == itr.current_page_id && item_index == itr.item_index;
 }
 
-bool IndexIterator::operator!=(const IndexIterator &itr) const {
+INDEX_TEMPLATE_ARGUMENTS
+bool INDEXITERATOR_TYPE::operator!=(const IndexIterator &itr) const {
   return !(*this == itr);
-}
\ No newline at end of file
+}
+
+template class IndexIterator<0>;
+template class IndexIterator<16>;
+template class IndexIterator<32>;
+template class IndexIterator<64>;
+template class IndexIterator<128>;
+template class IndexIterator<256>;
@@ -1,11 +1,12 @@
 #include "page/b_plus_tree_internal_page.h"
 
 #include "index/generic_key.h"
+#include "page/b_plus_tree_pairs.h"
 
 #define pairs_off (data_)
-#define pair_size (GetKeySize() + sizeof(page_id_t))
+#define pair_size (PairKeySize() + sizeof(page_id_t))
 #define key_off 0
-#define val_off GetKeySize()
+#define val_off PairKeySize()
 
 /**
  * TODO: Student Implement
@@ -18,7 +19,8 @@
  * Including set page type, set current size, set page id, set parent id and set
  * max page size
  */
-void InternalPage::Init(page_id_t page_id, page_id_t parent_id, int key_size, int max_size) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int key_size, int max_size) {
     SetPageType(IndexPageType::INTERNAL_PAGE);
     SetKeySize(key_size);
     SetPageId(page_id);
@@ -32,23 +34,28 @@ void InternalPage::Init(page_id_t page_id, page_id_t parent_id, int key_size, in
  * array offset)
  */
 // 返回index处指向子节点的指针
-GenericKey *InternalPage::KeyAt(int index) {
+INDEX_TEMPLATE_ARGUMENTS
+GenericKey *B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) {
   return reinterpret_cast<GenericKey *>(pairs_off + index * pair_size + key_off);
 }
 // 把index处的key改为新的key值
-void InternalPage::SetKeyAt(int index, GenericKey *key) {
-  memcpy(pairs_off + index * pair_size + key_off, key, GetKeySize());
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, GenericKey *key) {
+  memcpy(pairs_off + index * pair_size + key_off, key, PairKeySize());
 }
 // 返回index所指的值
-page_id_t InternalPage::ValueAt(int index) const {
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const {
   return *reinterpret_cast<const page_id_t *>(pairs_off + index * pair_size + val_off);
 }
 // 设置index所指的值
-void InternalPage::SetValueAt(int index, page_id_t value) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetValueAt(int index, page_id_t value) {
   *reinterpret_cast<page_id_t *>(pairs_off + index * pair_size + val_off) = value;
 }
 // 查找value的位置，返回index
-int InternalPage::ValueIndex(const page_id_t &value) const {
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const page_id_t &value) const {
   for (int i = 0; i < GetSize(); ++i) {
     if (ValueAt(i) == value)
       return i;
@@ -56,12 +63,15 @@ int InternalPage::ValueIndex(const page_id_t &value) const {
   return -1;
 }
 // 返回index处的key
-void *InternalPage::PairPtrAt(int index) {
+INDEX_TEMPLATE_ARGUMENTS
+void *B_PLUS_TREE_INTERNAL_PAGE_TYPE::PairPtrAt(int index) {
   return KeyAt(index);
 }
 // 复制内部节点的键值对从src到dest
-void InternalPage::PairCopy(void *dest, void *src, int pair_num) {
-  memcpy(dest, src, pair_num * (GetKeySize() + sizeof(page_id_t)));
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PairCopy(void *dest, void *src, int pair_num) {
+  // 重叠区间（整体前移/后移）要用memmove
+  BPlusTreePairs<KeySize, page_id_t>(pairs_off, GetKeySize()).Copy(dest, src, pair_num);
 }
 /*****************************************************************************
  * LOOKUP
@@ -70,22 +80,14 @@ void InternalPage::PairCopy(void *dest, void *src, int pair_num) {
  * Find and return the child pointer(page_id) which points to the child page
  * that contains input "key"
  * Start the search from the second key(the first key should always be invalid)
- * 用了二分查找
+ * 找第一个不小于key的键，相等就走它的孩子，否则走前一个孩子
  */
-page_id_t InternalPage::Lookup(const GenericKey *key, const KeyManager &KM) {
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const GenericKey *key, const KeyManager &KM) {
   if(GetSize() == 0) return -1;
-  else if(GetSize() == 1 || KM.CompareKeys(key, KeyAt(1)) < 0) return ValueAt(0);
-  else{
-    int l = 1, r = GetSize();
-    while(l < r - 1){
-      int mid = (l + r) / 2;
-      int cmp_res = KM.CompareKeys(key, KeyAt(mid));
-      if(cmp_res < 0) r = mid;
-      else if(cmp_res > 0) l = mid;
-      else if(cmp_res == 0) return ValueAt(mid);
-    }
-    return ValueAt(l);
-  }
+  int idx = KM.LowerBound(pairs_off, pair_size, 1, GetSize(), key);
+  if(idx < GetSize() && KM.CompareKeys(key, KeyAt(idx)) == 0) return ValueAt(idx);
+  return ValueAt(idx - 1);
 }
 
 /*****************************************************************************
@@ -97,7 +99,8 @@ page_id_t InternalPage::Lookup(const GenericKey *key, const KeyManager &KM) {
  * page, you should create a new root page and populate its elements.
  * NOTE: This method is only called within InsertIntoParent()(b_plus_tree.cpp)
  */
-void InternalPage::PopulateNewRoot(const page_id_t &old_value, GenericKey *new_key, const page_id_t &new_value) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(const page_id_t &old_value, GenericKey *new_key, const page_id_t &new_value) {
   SetSize(2);
   // 只需要设置第一个key和前两个value
   SetKeyAt(1, new_key);
@@ -110,15 +113,11 @@ void InternalPage::PopulateNewRoot(const page_id_t &old_value, GenericKey *new_k
  * old_value
  * @return:  new size after insertion
  */
-int InternalPage::InsertNodeAfter(const page_id_t &old_value, GenericKey *new_key, const page_id_t &new_value) {
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const page_id_t &old_value, GenericKey *new_key, const page_id_t &new_value) {
+  // old_value找不到时为-1，插到最前面
   int old_idx = ValueIndex(old_value);
-  // PairCopy(PairPtrAt(old_idx + 1), PairPtrAt(old_idx), GetSize() - old_idx - 1);
-  for(int i = GetSize() - 1; i > old_idx; i--){
-    SetKeyAt(i + 1, KeyAt(i));
-    SetValueAt(i + 1, ValueAt(i));
-  }
-  SetKeyAt(old_idx + 1, new_key);
-  SetValueAt(old_idx + 1, new_value);
+  BPlusTreePairs<KeySize, page_id_t>(pairs_off, GetKeySize()).InsertAt(old_idx + 1, GetSize(), new_key, new_value);
   SetSize(GetSize() + 1);
   return GetSize();
 }
@@ -131,7 +130,8 @@ int InternalPage::InsertNodeAfter(const page_id_t &old_value, GenericKey *new_ke
  * buffer_pool_manager 是干嘛的？传给CopyNFrom()用于Fetch数据页
  * CopyNFrom(void *src, int size, BufferPoolManager *buffer_pool_manager)
  */
-void InternalPage::MoveHalfTo(InternalPage *recipient, BufferPoolManager *buffer_pool_manager) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(BPlusTreeInternalPage *recipient, BufferPoolManager *buffer_pool_manager) {
   int half = GetSize() / 2;
   int begin = GetSize() - GetSize() / 2;
   // 把后一半的数据移动到recipient页
@@ -144,17 +144,16 @@ void InternalPage::MoveHalfTo(InternalPage *recipient, BufferPoolManager *buffer
  * So I need to 'adopt' them by changing their parent page id, which needs to be persisted with BufferPoolManger
  *
  */
-void InternalPage::CopyNFrom(void *src, int size, BufferPoolManager *buffer_pool_manager) {
-  // 转成char，按字节读写
-  char *source = reinterpret_cast<char *>(src);
-
-  for (int i = 0; i < size; i++) {
-    GenericKey *key = reinterpret_cast<GenericKey *>(source);
-    source += GetKeySize();
-    page_id_t *pageId = reinterpret_cast<page_id_t *>(source);
-    source += sizeof(page_id_t);
-    // 把key和value加到当前页的末尾
-    CopyLastFrom(key, *pageId, buffer_pool_manager);
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(void *src, int size, BufferPoolManager *buffer_pool_manager) {
+  // 整块拷到当前页的末尾，再逐个领养孩子
+  int old_size = GetSize();
+  PairCopy(PairPtrAt(old_size), src, size);
+  SetSize(old_size + size);
+  for (int i = old_size; i < GetSize(); i++) {
+    auto *child = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager->FetchPage(ValueAt(i))->GetData());
+    child->SetParentPageId(GetPageId());
+    buffer_pool_manager->UnpinPage(ValueAt(i), true);
   }
 }
 
@@ -166,12 +165,10 @@ void InternalPage::CopyNFrom(void *src, int size, BufferPoolManager *buffer_pool
  * array offset)
  * NOTE: store key&value pair continuously after deletion
  */
-void InternalPage::Remove(int index) {
-  // 序号比大小少一
-  for(int i = index; i < GetSize() - 1; i++){
-    SetKeyAt(i, KeyAt(i + 1));
-    SetValueAt(i, ValueAt(i + 1));
-  }
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
+  // 后面的元素整体前移一格
+  BPlusTreePairs<KeySize, page_id_t>(pairs_off, GetKeySize()).RemoveAt(index, GetSize());
   SetSize(GetSize() - 1);
 }
 
@@ -179,7 +176,8 @@ void InternalPage::Remove(int index) {
  * Remove the only key & value pair in internal page and return the value
  * NOTE: only call this method within AdjustRoot()(in b_plus_tree.cpp)
  */
-page_id_t InternalPage::RemoveAndReturnOnlyChild() {
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() {
   // 判断当前页是否只有一个指针
   if(GetSize() == 1){
     return ValueAt(0);
@@ -197,15 +195,17 @@ page_id_t InternalPage::RemoveAndReturnOnlyChild() {
  * The middle_key is the separation key you should get from the parent. You need
  * to make sure the middle key is added to the recipient to maintain the invariant.
  * You also need to use BufferPoolManager to persist changes to the parent page id for those
- * pages that are moved to the recipient
+ * pages that are moved to the recipient. The emptied page is deleted by the caller.
  */
-void InternalPage::MoveAllTo(InternalPage *recipient, GenericKey *middle_key, BufferPoolManager *buffer_pool_manager) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient, GenericKey *middle_key, BufferPoolManager *buffer_pool_manager) {
   // 把middle_key加到recipient页
   // 和拷贝类似的函数都可以用之后实现的
   recipient->CopyLastFrom(middle_key, ValueAt(0), buffer_pool_manager);
   // 把当前页的所有数据移动到recipient页
   recipient->CopyNFrom(PairPtrAt(1), GetSize() - 1, buffer_pool_manager);
-  buffer_pool_manager->DeletePage(GetPageId());
+  // 当前页还被调用者pin着，由调用者unpin后删除
+  SetSize(0);
 }
 
 /*****************************************************************************
@@ -219,7 +219,8 @@ void InternalPage::MoveAllTo(InternalPage *recipient, GenericKey *middle_key, Bu
  * You also need to use BufferPoolManager to persist changes to the parent page id for those
  * pages that are moved to the recipient
  */
-void InternalPage::MoveFirstToEndOf(InternalPage *recipient, GenericKey *middle_key, BufferPoolManager *buffer_pool_manager) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, GenericKey *middle_key, BufferPoolManager *buffer_pool_manager) {
   recipient->CopyLastFrom(middle_key, ValueAt(0), buffer_pool_manager);
   Remove(0);
 }
@@ -228,14 +229,15 @@ void InternalPage::MoveFirstToEndOf(InternalPage *recipient, GenericKey *middle_
  * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
  * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
  */
-void InternalPage::CopyLastFrom(GenericKey *key, const page_id_t value, BufferPoolManager *buffer_pool_manager) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(GenericKey *key, const page_id_t value, BufferPoolManager *buffer_pool_manager) {
   // 把key和value加到当前页的末尾
   SetKeyAt(GetSize(), key);
   SetValueAt(GetSize(), value);
   SetSize(GetSize() + 1);
   // 更新page头文件
   // 由于我们的内部节点是从父类继承来的，所以需要强制转换page，变成内部节点的page，用完之后Unipin掉，不然过不了测试
-  InternalPage *interpage = reinterpret_cast<InternalPage *>(buffer_pool_manager->FetchPage(value));
+  auto *interpage = reinterpret_cast<BPlusTreeInternalPage *>(buffer_pool_manager->FetchPage(value)->GetData());
   interpage->SetParentPageId(GetPageId());
   buffer_pool_manager->UnpinPage(value, true);
 }
@@ -247,7 +249,8 @@ void InternalPage::CopyLastFrom(GenericKey *key, const page_id_t value, BufferPo
  * You also need to use BufferPoolManager to persist changes to the parent page id for those pages that are
  * moved to the recipient
  */
-void InternalPage::MoveLastToFrontOf(InternalPage *recipient, GenericKey *middle_key, BufferPoolManager *buffer_pool_manager) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, GenericKey *middle_key, BufferPoolManager *buffer_pool_manager) {
   recipient->CopyFirstFrom(ValueAt(GetSize() - 1), buffer_pool_manager);
   recipient->SetKeyAt(1, middle_key);  // 把middle_key加到recipient第一个的后面
   Remove(GetSize() - 1);  // Remove函数中有SetSize的功能
@@ -257,11 +260,19 @@ void InternalPage::MoveLastToFrontOf(InternalPage *recipient, GenericKey *middle
  * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
  * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
  */
-void InternalPage::CopyFirstFrom(const page_id_t value, BufferPoolManager *buffer_pool_manager) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const page_id_t value, BufferPoolManager *buffer_pool_manager) {
   // 把key和value加到当前页的开头
   InsertNodeAfter(-1, KeyAt(0), value);
   // 更新page头文件
-  InternalPage *interpage = reinterpret_cast<InternalPage *>(buffer_pool_manager->FetchPage(value));
+  auto *interpage = reinterpret_cast<BPlusTreeInternalPage *>(buffer_pool_manager->FetchPage(value)->GetData());
   interpage->SetParentPageId(GetPageId());
   buffer_pool_manager->UnpinPage(value, true);
-}
\ No newline at end of file
+}
+
+template class BPlusTreeInternalPage<0>;
+template class BPlusTreeInternalPage<16>;
+template class BPlusTreeInternalPage<32>;
+template class BPlusTreeInternalPage<64>;
+template class BPlusTreeInternalPage<128>;
+template class BPlusTreeInternalPage<256>;
@@ -3,11 +3,12 @@
 #include <algorithm>
 
 #include "index/generic_key.h"
+#include "page/b_plus_tree_pairs.h"
 
 #define pairs_off (data_)
-#define pair_size (GetKeySize() + sizeof(RowId))
+#define pair_size (PairKeySize() + sizeof(RowId))
 #define key_off 0
-#define val_off GetKeySize()
+#define val_off PairKeySize()
 /*****************************************************************************
  * HELPER METHODS AND UTILITIES
  *****************************************************************************/
@@ -21,7 +22,8 @@
  * next page id and set max size
  * 未初始化next_page_id
  */
-void LeafPage::Init(page_id_t page_id, page_id_t parent_id, int key_size, int max_size) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int key_size, int max_size) {
   SetPageType(IndexPageType::LEAF_PAGE);
   SetSize(0);
   SetPageId(page_id);
@@ -35,11 +37,13 @@ void LeafPage::Init(page_id_t page_id, page_id_t parent_id, int key_size, int ma
  * Helper methods to set/get next page id
  */
 // 下一页
-page_id_t LeafPage::GetNextPageId() const {
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const {
   return next_page_id_;
 }
 // 设置下一页
-void LeafPage::SetNextPageId(page_id_t next_page_id) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {
   next_page_id_ = next_page_id;
   if (next_page_id == 0) {
     LOG(INFO) << "Fatal error";
@@ -52,20 +56,12 @@ void LeafPage::SetNextPageId(page_id_t next_page_id) {
 /**
  * Helper method to find the first index i so that pairs_[i].first >= key
  * NOTE: This method is only used when generating index iterator
- * 二分查找
+ * 二分查找，规范化的键最后一段按前缀批量比较，见KeyManager::LowerBound
  */
-int LeafPage::KeyIndex(const GenericKey *key, const KeyManager &KM) {
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const GenericKey *key, const KeyManager &KM) {
   // 叶子节点键的数量和值的数量是相等的
-  // 这里不能把r设为GetSize() - 1，会导致最后一个元素无法访问
-  int l = 0, r = GetSize();
-  while (l < r) {
-    int mid = (l + r) / 2;
-    int cmp_res = KM.CompareKeys(key, KeyAt(mid));
-    if(cmp_res < 0) r = mid;
-    else if(cmp_res > 0) l = mid + 1;
-    else return mid;
-  }
-  return l;
+  return KM.LowerBound(pairs_off, pair_size, 0, GetSize(), key);
 }
 
 /*
@@ -73,34 +69,42 @@ int LeafPage::KeyIndex(const GenericKey *key, const KeyManager &KM) {
  * array offset)
  */
 // 返回指针
-GenericKey *LeafPage::KeyAt(int index) {
+INDEX_TEMPLATE_ARGUMENTS
+GenericKey *B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) {
   return reinterpret_cast<GenericKey *>(pairs_off + index * pair_size + key_off);
 }
 // 设置键
-void LeafPage::SetKeyAt(int index, GenericKey *key) {
-  memcpy(pairs_off + index * pair_size + key_off, key, GetKeySize());
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetKeyAt(int index, GenericKey *key) {
+  memcpy(pairs_off + index * pair_size + key_off, key, PairKeySize());
 }
 // 返回值
-RowId LeafPage::ValueAt(int index) const {
+INDEX_TEMPLATE_ARGUMENTS
+RowId B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const {
   return *reinterpret_cast<const RowId *>(pairs_off + index * pair_size + val_off);
 }
 // 设置值
-void LeafPage::SetValueAt(int index, RowId value) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetValueAt(int index, RowId value) {
   *reinterpret_cast<RowId *>(pairs_off + index * pair_size + val_off) = value;
 }
 // 返回键值对
-void *LeafPage::PairPtrAt(int index) {
+INDEX_TEMPLATE_ARGUMENTS
+void *B_PLUS_TREE_LEAF_PAGE_TYPE::PairPtrAt(int index) {
   return KeyAt(index);
 }
 // 拷贝键值对
-void LeafPage::PairCopy(void *dest, void *src, int pair_num) {
-  memcpy(dest, src, pair_num * (GetKeySize() + sizeof(RowId)));
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::PairCopy(void *dest, void *src, int pair_num) {
+  // 重叠区间（整体前移/后移）要用memmove
+  BPlusTreePairs<KeySize, RowId>(pairs_off, GetKeySize()).Copy(dest, src, pair_num);
 }
 /*
  * Helper method to find and return the key & value pair associated with input
  * "index"(a.k.a. array offset)
  */
-std::pair<GenericKey *, RowId> LeafPage::GetItem(int index) { 
+INDEX_TEMPLATE_ARGUMENTS
+std::pair<GenericKey *, RowId> B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) { 
   return {KeyAt(index), ValueAt(index)}; 
 }
 
@@ -111,31 +115,15 @@ std::pair<GenericKey *, RowId> LeafPage::GetItem(int index) {
  * Insert key & value pair into leaf page ordered by key
  * @return page size after insertion
  */
-int LeafPage::Insert(GenericKey *key, const RowId &value, const KeyManager &KM) {
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(GenericKey *key, const RowId &value, const KeyManager &KM) {
   // 插入的位置
   int idx = KeyIndex(key, KM);
-
-  if(idx == -1){    // 插入到最后
-    SetKeyAt(GetSize(), key);
-    SetValueAt(GetSize(), value);
-    SetSize(GetSize() + 1);
-    return GetSize();
-  }else if(idx >= GetSize()){ 
-    SetKeyAt(idx, key);
-    SetValueAt(idx, value);
-    SetSize(GetSize() + 1);
-    return GetSize();
-  }else if(KM.CompareKeys(key, KeyAt(idx)) == 0){  // 已经存在
+  if(idx < GetSize() && KM.CompareKeys(key, KeyAt(idx)) == 0){  // 已经存在
     return GetSize();
   }
-  // 移动后面的元素
-  for(int i = GetSize() - 1; i >= idx; i--){
-    SetKeyAt(i + 1, KeyAt(i));
-    SetValueAt(i + 1, ValueAt(i));
-  }
-  // 插入新元素
-  SetKeyAt(idx, key);
-  SetValueAt(idx, value);
+  // 后面的元素整体后移一格，再放入新元素，键的大小按类别在编译期确定
+  BPlusTreePairs<KeySize, RowId>(pairs_off, GetKeySize()).InsertAt(idx, GetSize(), key, value);
   // 更新大小
   SetSize(GetSize() + 1);
   return GetSize();
@@ -147,7 +135,8 @@ int LeafPage::Insert(GenericKey *key, const RowId &value, const KeyManager &KM)
 /*
  * Remove half of key & value pairs from this page to "recipient" page
  */
-void LeafPage::MoveHalfTo(LeafPage *recipient) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {
   recipient->CopyNFrom(PairPtrAt(GetSize() - GetSize() / 2), GetSize() / 2);
   SetSize(GetSize() - GetSize() / 2);
 }
@@ -155,7 +144,8 @@ void LeafPage::MoveHalfTo(LeafPage *recipient) {
 /*
  * Copy starting from items, and copy {size} number of elements into me.
  */
-void LeafPage::CopyNFrom(void *src, int size) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(void *src, int size) {
   PairCopy(PairPtrAt(GetSize()), src, size);
   SetSize(size + GetSize());
 }
@@ -168,7 +158,8 @@ void LeafPage::CopyNFrom(void *src, int size) {
  * does, then store its corresponding value in input "value" and return true.
  * If the key does not exist, then return false
  */
-bool LeafPage::Lookup(const GenericKey *key, RowId &value, const KeyManager &KM) {
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const GenericKey *key, RowId &value, const KeyManager &KM) {
   int idx = KeyIndex(key, KM);
   if(idx < GetSize() && KM.CompareKeys(key, KeyAt(idx)) == 0){  // 没有溢出并且存在
     value = ValueAt(idx);
@@ -187,14 +178,12 @@ bool LeafPage::Lookup(const GenericKey *key, RowId &value, const KeyManager &KM)
  * NOTE: store key&value pair continuously after deletion
  * @return  page size after deletion
  */
-int LeafPage::RemoveAndDeleteRecord(const GenericKey *key, const KeyManager &KM) {
-  RowId val;
-  if(Lookup(key, val, KM)){
-    int idx = KeyIndex(key, KM);
-    for(int i = idx; i < GetSize() - 1; i++){
-      SetKeyAt(i, KeyAt(i + 1));
-      SetValueAt(i, ValueAt(i + 1));
-    }
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const GenericKey *key, const KeyManager &KM) {
+  int idx = KeyIndex(key, KM);
+  if(idx < GetSize() && KM.CompareKeys(key, KeyAt(idx)) == 0){
+    // 后面的元素整体前移一格
+    BPlusTreePairs<KeySize, RowId>(pairs_off, GetKeySize()).RemoveAt(idx, GetSize());
     SetSize(GetSize() - 1);
     return GetSize();
   }else{
@@ -209,7 +198,8 @@ int LeafPage::RemoveAndDeleteRecord(const GenericKey *key, const KeyManager &KM)
  * Remove all key & value pairs from this page to "recipient" page. Don't forget
  * to update the next_page id in the sibling page
  */
-void LeafPage::MoveAllTo(LeafPage *recipient) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {
   recipient->CopyNFrom(PairPtrAt(0), GetSize());
   recipient->SetNextPageId(GetNextPageId());
   SetSize(0);
@@ -223,7 +213,8 @@ void LeafPage::MoveAllTo(LeafPage *recipient) {
  * 然后整体向前移动
  * 
  */
-void LeafPage::MoveFirstToEndOf(LeafPage *recipient) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {
   recipient->CopyLastFrom(KeyAt(0), ValueAt(0));
   PairCopy(PairPtrAt(0), PairPtrAt(1), GetSize() - 1);
   SetSize(GetSize() - 1);
@@ -232,7 +223,8 @@ void LeafPage::MoveFirstToEndOf(LeafPage *recipient) {
 /*
  * 把键值对放在最后
  */
-void LeafPage::CopyLastFrom(GenericKey *key, const RowId value) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(GenericKey *key, const RowId value) {
   SetKeyAt(GetSize(), key);
   SetValueAt(GetSize(), value);
   SetSize(GetSize() + 1);
@@ -241,7 +233,8 @@ void LeafPage::CopyLastFrom(GenericKey *key, const RowId value) {
 /*
  * 把最后一个键值对放在recipient的最前面
  */
-void LeafPage::MoveLastToFrontOf(LeafPage *recipient) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {
   recipient->CopyFirstFrom(KeyAt(GetSize() - 1), ValueAt(GetSize() - 1));
   SetSize(GetSize() - 1);
 }
@@ -250,10 +243,18 @@ void LeafPage::MoveLastToFrontOf(LeafPage *recipient) {
  * 把键值对放在最前面
  *
  */
-void LeafPage::CopyFirstFrom(GenericKey *key, const RowId value) {
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(GenericKey *key, const RowId value) {
   // 先整体往后移动
   PairCopy(PairPtrAt(1), PairPtrAt(0), GetSize());
   SetKeyAt(0, key);
   SetValueAt(0, value);
   SetSize(GetSize() + 1);
-}
\ No newline at end of file
+}
+
+template class BPlusTreeLeafPage<0>;
+template class BPlusTreeLeafPage<16>;
+template class BPlusTreeLeafPage<32>;
+template class BPlusTreeLeafPage<64>;
+template class BPlusTreeLeafPage<128>;
+template class BPlusTreeLeafPage<256>;
@@ -16,26 +16,63 @@ bool BitmapPage<PageSize>::AllocatePage(uint32_t &page_offset) {
     return false;
     //full or invalid offset
   }
+  // next_free_page_只是提示，旧文件中它可能指向已分配的页，此时重新查找
+  if(next_free_page_ >= MAX_CHARS * 8 || !IsPageFree(next_free_page_)){
+    next_free_page_ = FindFreePage(0);
+  }
+  // page_offset表示分配的页的偏移量
+  page_offset = next_free_page_;
+  return AllocatePageAt(page_offset);
+}
+
+template <size_t PageSize>
+bool BitmapPage<PageSize>::AllocatePageAt(uint32_t page_offset) {
+  if(page_offset >= MAX_CHARS * 8 || !IsPageFree(page_offset)){
+    return false;
+  }
   // 下一个空闲页的字节索引
-  uint32_t byte_index = next_free_page_ / 8;
+  uint32_t byte_index = page_offset / 8;
   // 下一个空闲页的位索引
-  uint8_t bit_index = next_free_page_ % 8;
+  uint8_t bit_index = page_offset % 8;
   // 1 << n_bit_index = 2^(n_bit_index) = 100..000
   // 将n_byte_index字节的第n_bit_index位置1,表示该页已经被分配
   bytes[byte_index] = bytes[byte_index] | (1 << bit_index);
-  // page_offset表示分配的页的偏移量
-  page_offset = next_free_page_;
-  // 更新下一个空闲页的索引
-  for(uint32_t i = 0;i < MAX_CHARS * 8; i++){
-    if((bytes[i / 8] & (1 << (i % 8))) == 0) {
-      next_free_page_ = i;
-      break;
+  page_allocated_ += 1;
+  // 分配的正是最小的空闲页时更新next_free_page_，它之前的页都已分配，只需向后查找
+  if(page_offset == next_free_page_){
+    next_free_page_ = FindFreePage(page_offset + 1);
+    // 后面没有空闲页，从头再找一遍（next_free_page_不是最小空闲页时才会发生）
+    if(next_free_page_ == MAX_CHARS * 8){
+      next_free_page_ = FindFreePage(0);
     }
   }
-  page_allocated_ += 1;
   return true;
 }
 
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::FindFreePage(uint32_t start) const {
+  if(page_allocated_ >= MAX_CHARS * 8){
+    return MAX_CHARS * 8;
+  }
+  // 先在start所在字节内逐位查找，之后整字节跳过已满(0xFF)的字节
+  uint32_t i = start;
+  for(; i < MAX_CHARS * 8 && i % 8 != 0; i++){
+    if(IsPageFreeLow(i / 8, i % 8)){
+      return i;
+    }
+  }
+  for(uint32_t byte_index = i / 8; byte_index < MAX_CHARS; byte_index++){
+    if(bytes[byte_index] != 0xFF){
+      for(uint8_t bit_index = 0; bit_index < 8; bit_index++){
+        if(IsPageFreeLow(byte_index, bit_index)){
+          return byte_index * 8 + bit_index;
+        }
+      }
+    }
+  }
+  return MAX_CHARS * 8;
+}
+
 /**
  * TODO: Student Implement
  */
@@ -54,8 +91,10 @@ bool BitmapPage<PageSize>::DeAllocatePage(uint32_t page_offset) {
   // 如果没有释放，则将该页的字节索引的第bit_index位置0
   bytes[byte_index] = bytes[byte_index] & ~(1 << bit_index);
   page_allocated_-= 1;
-  // 当前的offset被释放，更新next_free_page_
-  next_free_page_ = page_offset;
+  // 保持next_free_page_为最小的空闲页，分配时优先填满前面的页
+  if(page_offset < next_free_page_){
+    next_free_page_ = page_offset;
+  }
   return true;
 }
 
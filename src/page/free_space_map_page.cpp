@@ -0,0 +1,41 @@
+#include "page/free_space_map_page.h"
+
+#include <algorithm>
+
+void FreeSpaceMapPage::Init(page_id_t page_id) {
+  memcpy(GetData(), &page_id, sizeof(page_id));
+  memcpy(GetData() + OFFSET_MAGIC, &MAGIC_NUM, sizeof(uint32_t));
+  SetNextPageId(INVALID_PAGE_ID);
+  uint32_t entry_count = 0;
+  memcpy(GetData() + OFFSET_ENTRY_COUNT, &entry_count, sizeof(uint32_t));
+}
+
+int FreeSpaceMapPage::Append(page_id_t table_page_id, uint8_t category) {
+  uint32_t slot = GetEntryCount();
+  if (slot >= CAPACITY) {
+    return -1;
+  }
+  memcpy(GetData() + OFFSET_PAGE_IDS + sizeof(page_id_t) * slot, &table_page_id, sizeof(page_id_t));
+  SetCategory(slot, category);
+  uint32_t entry_count = slot + 1;
+  memcpy(GetData() + OFFSET_ENTRY_COUNT, &entry_count, sizeof(uint32_t));
+  return static_cast<int>(slot);
+}
+
+int FreeSpaceMapPage::FindSlot(uint8_t min_category, uint32_t start) {
+  // 类别数组是连续的字节，顺序扫描一页最多 CAPACITY 个字节
+  auto categories = reinterpret_cast<const uint8_t *>(GetData() + OFFSET_CATEGORIES);
+  uint32_t count = GetEntryCount();
+  for (uint32_t i = start; i < count; i++) {
+    if (categories[i] >= min_category) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+uint8_t FreeSpaceMapPage::GetMaxCategory() {
+  auto categories = reinterpret_cast<const uint8_t *>(GetData() + OFFSET_CATEGORIES);
+  uint32_t count = GetEntryCount();
+  return count == 0 ? 0 : *std::max_element(categories, categories + count);
+}
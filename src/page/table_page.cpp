@@ -1,5 +1,8 @@
 #include "page/table_page.h"
 
+#include <algorithm>
+#include <vector>
+
 // TODO: Update interface implementation if apply recovery
 
 void TablePage::Init(page_id_t page_id, page_id_t prev_id, LogManager *log_mgr, Txn *txn) {
@@ -7,26 +10,30 @@ void TablePage::Init(page_id_t page_id, page_id_t prev_id, LogManager *log_mgr,
   SetPrevPageId(prev_id);
   SetNextPageId(INVALID_PAGE_ID);
   SetFreeSpacePointer(PAGE_SIZE);
+  SetFragmentedBytes(0);
   SetTupleCount(0);
+  SetFreeSlotHead(NO_FREE_SLOT);
 }
 
 bool TablePage::InsertTuple(Row &row, Schema *schema, Txn *txn, LockManager *lock_manager, LogManager *log_manager) {
   uint32_t serialized_size = row.GetSerializedSize(schema);
   ASSERT(serialized_size > 0, "Can not have empty row.");
-  if (GetFreeSpaceRemaining() < serialized_size + SIZE_TUPLE) {
+  UpgradeFormat();
+  // 有空槽位时直接从链表头取一个，不需要为新槽位留空间
+  uint32_t slot_num = GetFreeSlotHead();
+  uint32_t needed = serialized_size + (slot_num == NO_FREE_SLOT ? SIZE_TUPLE : 0);
+  if (GetFreeSpaceRemaining() < needed) {
     return false;
   }
-  // Try to find a free slot to reuse.
-  uint32_t i;
-  for (i = 0; i < GetTupleCount(); i++) {
-    // If the slot is empty, i.e. its tuple has size 0,
-    if (GetTupleSize(i) == 0) {
-      // Then we break out of the loop at index i.
-      break;
-    }
+  // 连续空间不够但加上碎片够时整理一次页
+  if (GetContiguousFreeSpace() < needed) {
+    Compact();
   }
-  if (i == GetTupleCount() && GetFreeSpaceRemaining() < serialized_size + SIZE_TUPLE) {
-    return false;
+  if (slot_num == NO_FREE_SLOT) {
+    slot_num = GetTupleCount();
+    SetTupleCount(slot_num + 1);
+  } else {
+    SetFreeSlotHead(GetTupleOffsetAtSlot(slot_num));
   }
   // Otherwise we claim available free space..
   SetFreeSpacePointer(GetFreeSpacePointer() - serialized_size);
@@ -34,13 +41,10 @@ bool TablePage::InsertTuple(Row &row, Schema *schema, Txn *txn, LockManager *loc
   ASSERT(write_bytes == serialized_size, "Unexpected behavior in row serialize.");
 
   // Set the tuple.
-  SetTupleOffsetAtSlot(i, GetFreeSpacePointer());
-  SetTupleSize(i, serialized_size);
+  SetTupleOffsetAtSlot(slot_num, GetFreeSpacePointer());
+  SetTupleSize(slot_num, serialized_size);
   // Set rid
-  row.SetRowId(RowId(GetTablePageId(), i));
-  if (i == GetTupleCount()) {
-    SetTupleCount(GetTupleCount() + 1);
-  }
+  row.SetRowId(RowId(GetTablePageId(), slot_num));
   return true;
 }
 
@@ -81,55 +85,56 @@ bool TablePage::UpdateTuple(const Row &new_row, Row *old_row, Schema *schema, Tx
   if (GetFreeSpaceRemaining() + tuple_size < serialized_size) {
     return false;
   }
+  UpgradeFormat();
   // Copy out the old value.
   uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
   uint32_t __attribute__((unused)) read_bytes = old_row->DeserializeFrom(GetData() + tuple_offset, schema);
   ASSERT(tuple_size == read_bytes, "Unexpected behavior in tuple deserialize.");
-  uint32_t free_space_pointer = GetFreeSpacePointer();
-  ASSERT(tuple_offset >= free_space_pointer, "Offset should appear after current free space position.");
-  memmove(GetData() + free_space_pointer + tuple_size - serialized_size, GetData() + free_space_pointer,
-          tuple_offset - free_space_pointer);
-  SetFreeSpacePointer(free_space_pointer + tuple_size - serialized_size);
-  new_row.SerializeTo(GetData() + tuple_offset + tuple_size - serialized_size, schema);
-  SetTupleSize(slot_num, serialized_size);
-
-  // Update all tuple offsets.
-  for (uint32_t i = 0; i < GetTupleCount(); ++i) {
-    uint32_t tuple_offset_i = GetTupleOffsetAtSlot(i);
-    if (GetTupleSize(i) > 0 && tuple_offset_i < tuple_offset + tuple_size) {
-      SetTupleOffsetAtSlot(i, tuple_offset_i + tuple_size - new_row.GetSerializedSize(schema));
+  if (serialized_size <= tuple_size) {
+    // 新元组不比旧的大就原地覆盖，多出来的字节记为碎片
+    new_row.SerializeTo(GetData() + tuple_offset, schema);
+    SetFragmentedBytes(GetFragmentedBytes() + tuple_size - serialized_size);
+  } else {
+    // 旧元组整个变成碎片，新元组写进空闲区；槽位大小先置 0，整理时跳过旧元组
+    SetTupleSize(slot_num, 0);
+    SetFragmentedBytes(GetFragmentedBytes() + tuple_size);
+    if (GetContiguousFreeSpace() < serialized_size) {
+      Compact();
     }
+    SetFreeSpacePointer(GetFreeSpacePointer() - serialized_size);
+    new_row.SerializeTo(GetData() + GetFreeSpacePointer(), schema);
+    SetTupleOffsetAtSlot(slot_num, GetFreeSpacePointer());
   }
+  SetTupleSize(slot_num, serialized_size);
   return true;
 }
 
 void TablePage::ApplyDelete(const RowId &rid, Txn *txn, LogManager *log_manager) {
   uint32_t slot_num = rid.GetSlotNum();
   ASSERT(slot_num < GetTupleCount(), "Cannot have more slots than tuples.");
+  UpgradeFormat();
 
   uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
   uint32_t tuple_size = GetTupleSize(slot_num);
+  // The slot is already empty.
+  if (tuple_size == 0) {
+    return;
+  }
   // Check if this is a delete operation, i.e. commit a delete.
   if (IsDeleted(tuple_size)) {
     tuple_size = UnsetDeletedFlag(tuple_size);
   }
 
-  uint32_t free_space_pointer = GetFreeSpacePointer();
-  ASSERT(tuple_offset >= free_space_pointer, "Free space appears before tuples.");
-
-  memmove(GetData() + free_space_pointer + tuple_size, GetData() + free_space_pointer,
-          tuple_offset - free_space_pointer);
-  SetFreeSpacePointer(free_space_pointer + tuple_size);
-  SetTupleSize(slot_num, 0);
-  SetTupleOffsetAtSlot(slot_num, 0);
-
-  // Update all tuple offsets.
-  for (uint32_t i = 0; i < GetTupleCount(); ++i) {
-    uint32_t tuple_offset_i = GetTupleOffsetAtSlot(i);
-    if (GetTupleSize(i) != 0 && tuple_offset_i < tuple_offset) {
-      SetTupleOffsetAtSlot(i, tuple_offset_i + tuple_size);
-    }
+  // 紧挨着空闲区的元组直接并入空闲区，其他的只记为碎片，不再每次删除都移动数据
+  if (tuple_offset == GetFreeSpacePointer()) {
+    SetFreeSpacePointer(tuple_offset + tuple_size);
+  } else {
+    SetFragmentedBytes(GetFragmentedBytes() + tuple_size);
   }
+  // 空槽位放到空槽链表头部
+  SetTupleSize(slot_num, 0);
+  SetTupleOffsetAtSlot(slot_num, GetFreeSlotHead());
+  SetFreeSlotHead(slot_num);
 }
 
 void TablePage::RollbackDelete(const RowId &rid, Txn *txn, LogManager *log_manager) {
@@ -164,6 +169,27 @@ bool TablePage::GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_m
   return true;
 }
 
+uint32_t TablePage::GetTuples(std::vector<Row> &rows, Schema *schema, Txn *txn, LockManager *lock_manager) {
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < GetTupleCount(); i++) {
+    uint32_t tuple_size = GetTupleSize(i);
+    if (IsDeleted(tuple_size)) {
+      continue;
+    }
+    // 复用已有的 Row 对象，只释放它上一页的字段
+    if (count == rows.size()) {
+      rows.emplace_back();
+    } else {
+      rows[count].destroy();
+    }
+    rows[count].SetRowId(RowId(GetTablePageId(), i));
+    uint32_t __attribute__((unused)) read_bytes = rows[count].DeserializeFrom(GetData() + GetTupleOffsetAtSlot(i), schema);
+    ASSERT(tuple_size == read_bytes, "Unexpected behavior in tuple deserialize.");
+    count++;
+  }
+  return count;
+}
+
 bool TablePage::GetFirstTupleRid(RowId *first_rid) {
   // Find and return the first valid tuple.
   for (uint32_t i = 0; i < GetTupleCount(); i++) {
@@ -192,3 +218,74 @@ bool TablePage::GetNextTupleRid(const RowId &cur_rid, RowId *next_rid) {
   return false;
 }
 
+
+void TablePage::UpgradeFormat() {
+  if (IsFormatV1()) {
+    return;
+  }
+  // 旧格式删除时立即整理，没有碎片，只要把空槽位串成链表
+  LinkFreeSlots();
+  SetFragmentedBytes(0);
+}
+
+void TablePage::LinkFreeSlots() {
+  uint32_t free_slot_head = NO_FREE_SLOT;
+  for (uint32_t i = GetTupleCount(); i-- > 0;) {
+    if (GetTupleSize(i) == 0) {
+      SetTupleOffsetAtSlot(i, free_slot_head);
+      free_slot_head = i;
+    }
+  }
+  SetFreeSlotHead(free_slot_head);
+}
+
+uint32_t TablePage::Vacuum(uint32_t *reclaimed_bytes) {
+  UpgradeFormat();
+  uint32_t removed = 0;
+  *reclaimed_bytes = 0;
+  // 1. 标记删除的元组真正删掉
+  for (uint32_t i = 0; i < GetTupleCount(); i++) {
+    uint32_t tuple_size = GetTupleSize(i);
+    if (tuple_size != 0 && IsDeleted(tuple_size)) {
+      *reclaimed_bytes += UnsetDeletedFlag(tuple_size);
+      ApplyDelete(RowId(GetTablePageId(), i), nullptr, nullptr);
+      removed++;
+    }
+  }
+  // 2. 末尾的空槽位直接截掉，还给空闲区，剩下的空槽位重新串成链表
+  uint32_t tuple_count = GetTupleCount();
+  while (tuple_count > 0 && GetTupleSize(tuple_count - 1) == 0) {
+    tuple_count--;
+  }
+  if (tuple_count != GetTupleCount()) {
+    SetTupleCount(tuple_count);
+    LinkFreeSlots();
+  }
+  // 3. 碎片整理成连续空间
+  if (GetFragmentedBytes() > 0) {
+    Compact();
+  }
+  return removed;
+}
+
+void TablePage::Compact() {
+  // 按偏移从大到小把元组依次挪到页尾，目标位置总不低于原位置，不会覆盖还没挪的元组
+  std::vector<std::pair<uint32_t, uint32_t>> tuples;  // (offset, slot)
+  for (uint32_t i = 0; i < GetTupleCount(); i++) {
+    if (UnsetDeletedFlag(GetTupleSize(i)) != 0) {
+      tuples.emplace_back(GetTupleOffsetAtSlot(i), i);
+    }
+  }
+  std::sort(tuples.begin(), tuples.end(), std::greater<>());
+  uint32_t free_space_pointer = PAGE_SIZE;
+  for (auto &tuple : tuples) {
+    uint32_t tuple_size = UnsetDeletedFlag(GetTupleSize(tuple.second));
+    free_space_pointer -= tuple_size;
+    if (free_space_pointer != tuple.first) {
+      memmove(GetData() + free_space_pointer, GetData() + tuple.first, tuple_size);
+      SetTupleOffsetAtSlot(tuple.second, free_space_pointer);
+    }
+  }
+  SetFreeSpacePointer(free_space_pointer);
+  SetFragmentedBytes(0);
+}
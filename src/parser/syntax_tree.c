@@ -171,6 +171,12 @@ const char *GetSyntaxNodeTypeStr(SyntaxNodeType type) {
       return "kNodeTrxCommit";
     case kNodeTrxRollback:
       return "kNodeTrxRollback";
+    case kNodeShowBufferStatus:
+      return "kNodeShowBufferStatus";
+    case kNodeSetVariable:
+      return "kNodeSetVariable";
+    case kNodeVacuum:
+      return "kNodeVacuum";
     default:
       return "error type";
   }
@@ -0,0 +1,306 @@
+#include "storage/async_io.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "glog/logging.h"
+#include "storage/disk_manager.h"
+
+void IOBatch::Add() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  pending_++;
+}
+
+void IOBatch::Done() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  // 持锁通知，保证Wait返回(batch可能随之析构)时这里已经不再访问batch
+  if (--pending_ == 0) {
+    cv_.notify_all();
+  }
+}
+
+void IOBatch::Wait() {
+  std::unique_lock<std::mutex> lock(latch_);
+  cv_.wait(lock, [this] { return pending_ == 0; });
+}
+
+AsyncIOEngine::AsyncIOEngine(DiskManager *disk_manager, size_t queue_depth, bool use_io_uring)
+    : disk_manager_(disk_manager), queue_depth_(std::max<size_t>(queue_depth, 1)) {
+  // 内核不支持io_uring(或被seccomp禁止)时退回线程池
+  if (use_io_uring && SetupIOUring()) {
+    backend_ = AsyncIOBackend::kIOUring;
+    threads_.emplace_back(&AsyncIOEngine::ReapLoop, this);
+  } else {
+    backend_ = AsyncIOBackend::kThreadPool;
+    for (int i = 0; i < ASYNC_IO_THREADS; i++) {
+      threads_.emplace_back(&AsyncIOEngine::WorkerLoop, this);
+    }
+  }
+}
+
+AsyncIOEngine::~AsyncIOEngine() {
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    submit_cv_.wait(lock, [this] { return inflight_ == 0; });
+    stop_ = true;
+  }
+  if (backend_ == AsyncIOBackend::kIOUring) {
+    // 所有请求都已完成，NOP是reaper收到的最后一个完成事件
+    std::scoped_lock<std::mutex> lock(sq_latch_);
+    if (!PushIOUring(nullptr)) {
+      // 叫不醒reaper，只能让它连同环一起留下，不能释放它还在用的映射
+      threads_.back().detach();
+      threads_.pop_back();
+      ring_fd_ = -1;
+    }
+  } else {
+    work_cv_.notify_all();
+  }
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+  if (ring_fd_ >= 0) {
+    munmap(sqes_, sqes_size_);
+    if (cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    munmap(sq_ring_, sq_ring_size_);
+    close(ring_fd_);
+  }
+}
+
+void AsyncIOEngine::SubmitRead(page_id_t logical_page_id, uint32_t num_pages, char *page_data, IOBatch *batch) {
+  ASSERT(logical_page_id >= 0, "Invalid page id.");
+  ASSERT(num_pages <= DiskManager::GetContiguousPages(logical_page_id), "Pages are not contiguous.");
+  size_t offset = static_cast<size_t>(disk_manager_->MapPageId(logical_page_id)) * PAGE_SIZE;
+  auto request = new Request{false, logical_page_id, num_pages, batch, offset,
+                             {{page_data, static_cast<size_t>(num_pages) * PAGE_SIZE}}};
+  Submit(request);
+}
+
+void AsyncIOEngine::SubmitWrite(page_id_t logical_page_id, const char *page_data, IOBatch *batch) {
+  SubmitWrites(logical_page_id, {page_data}, batch);
+}
+
+void AsyncIOEngine::SubmitWrites(page_id_t logical_page_id, std::vector<const char *> pages, IOBatch *batch) {
+  ASSERT(logical_page_id >= 0, "Invalid page id.");
+  ASSERT(!pages.empty() && pages.size() <= DiskManager::GetContiguousPages(logical_page_id),
+         "Pages are not contiguous.");
+  size_t offset = static_cast<size_t>(disk_manager_->MapPageId(logical_page_id)) * PAGE_SIZE;
+  auto request = new Request{true, logical_page_id, static_cast<uint32_t>(pages.size()), batch, offset, {}};
+  for (auto page_data : pages) {
+    request->iov.push_back({const_cast<char *>(page_data), PAGE_SIZE});
+  }
+  Submit(request);
+}
+
+void AsyncIOEngine::Submit(Request *request) {
+  request->batch->Add();
+  {
+    // 在途请求数达到队列深度时等待
+    std::unique_lock<std::mutex> lock(latch_);
+    submit_cv_.wait(lock, [this] { return inflight_ < queue_depth_; });
+    inflight_++;
+    if (inflight_ > max_inflight_) {
+      max_inflight_ = inflight_;
+    }
+    if (backend_ == AsyncIOBackend::kThreadPool) {
+      queue_.push_back(request);
+      work_cv_.notify_one();
+      return;
+    }
+  }
+  if (!disk_manager_->CanTransferDirectly(request->iov)) {
+    // O_DIRECT下内核不接受未对齐的缓冲区，这样的请求直接在提交线程里同步完成
+    RunRequest(request);
+    return;
+  }
+  bool submitted;
+  {
+    std::scoped_lock<std::mutex> lock(sq_latch_);
+    submitted = PushIOUring(request);
+  }
+  if (!submitted) {
+    // 内核不接受提交时在提交线程里同步完成，不能让等待的batch挂住
+    RunRequest(request);
+  }
+}
+
+void AsyncIOEngine::Finish(Request *request) {
+  IOBatch *batch = request->batch;
+  delete request;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    inflight_--;
+  }
+  num_completed_++;
+  submit_cv_.notify_all();
+  batch->Done();
+}
+
+void AsyncIOEngine::WorkerLoop() {
+  while (true) {
+    Request *request;
+    {
+      std::unique_lock<std::mutex> lock(latch_);
+      work_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      request = queue_.front();
+      queue_.pop_front();
+    }
+    RunRequest(request);
+  }
+}
+
+void AsyncIOEngine::RunRequest(Request *request) {
+  if (request->is_write) {
+    disk_manager_->WritePhysicalPages(disk_manager_->MapPageId(request->logical_page_id), request->iov);
+    disk_manager_->num_writes_ += request->num_pages;
+  } else {
+    disk_manager_->ReadPages(request->logical_page_id, request->num_pages,
+                             static_cast<char *>(request->iov[0].iov_base));
+  }
+  Finish(request);
+}
+
+bool AsyncIOEngine::SetupIOUring() {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  // 多留一个位置给停止reaper的NOP
+  int fd = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(queue_depth_ + 1), &params));
+  if (fd < 0) {
+    LOG(INFO) << "io_uring is not available (" << strerror(errno) << "), using the thread pool for async I/O";
+    return false;
+  }
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  void *sq_ring = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  void *cq_ring = sq_ring;
+  if (sq_ring != MAP_FAILED && !single_mmap) {
+    cq_ring = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+  }
+  void *sqes = MAP_FAILED;
+  if (cq_ring != MAP_FAILED) {
+    sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  }
+  if (sqes == MAP_FAILED) {
+    LOG(WARNING) << "Can not map the io_uring rings: " << strerror(errno);
+    if (cq_ring != MAP_FAILED && cq_ring != sq_ring) {
+      munmap(cq_ring, cq_ring_size_);
+    }
+    if (sq_ring != MAP_FAILED) {
+      munmap(sq_ring, sq_ring_size_);
+    }
+    close(fd);
+    return false;
+  }
+  ring_fd_ = fd;
+  sq_ring_ = sq_ring;
+  cq_ring_ = cq_ring;
+  sqes_ = sqes;
+  auto sq_base = static_cast<char *>(sq_ring);
+  auto cq_base = static_cast<char *>(cq_ring);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq_base + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq_base + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq_base + params.sq_off.array);
+  cq_head_ = reinterpret_cast<unsigned *>(cq_base + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq_base + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq_base + params.cq_off.ring_mask);
+  cqes_ = cq_base + params.cq_off.cqes;
+  return true;
+}
+
+bool AsyncIOEngine::PushIOUring(Request *request) {
+  // 在途请求数不超过队列深度，提交环不会满
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  auto sqe = static_cast<struct io_uring_sqe *>(sqes_) + index;
+  memset(sqe, 0, sizeof(*sqe));
+  if (request == nullptr) {
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = 0;
+  } else {
+    sqe->opcode = request->is_write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = disk_manager_->fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(request->iov.data());
+    sqe->len = request->iov.size();
+    sqe->off = request->offset;
+    sqe->user_data = reinterpret_cast<uint64_t>(request);
+  }
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  // 提交失败的sqe仍留在环里，重试直到内核取走
+  while (syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0) < 0) {
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      // 内核没有取走sqe，收回它，免得以后的提交把它和同步重做的请求再执行一次
+      LOG(ERROR) << "io_uring submit failed: " << strerror(errno);
+      __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+      return false;
+    }
+  }
+  return true;
+}
+
+void AsyncIOEngine::ReapLoop() {
+  auto cqes = static_cast<struct io_uring_cqe *>(cqes_);
+  bool wait_failed = false;
+  while (true) {
+    unsigned head = *cq_head_;
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      // 完成环为空，阻塞等待至少一个完成事件
+      if (syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR) {
+        // 等待一直出错时改为每毫秒查一次完成环，不空转，错误也只记一次
+        if (!wait_failed) {
+          LOG(ERROR) << "io_uring wait failed: " << strerror(errno) << ", polling the completion ring";
+          wait_failed = true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      continue;
+    }
+    struct io_uring_cqe *cqe = cqes + (head & *cq_mask_);
+    uint64_t user_data = cqe->user_data;
+    int result = cqe->res;
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+    if (user_data == 0) {
+      return;
+    }
+    CompleteIOUring(reinterpret_cast<Request *>(user_data), result);
+  }
+}
+
+void AsyncIOEngine::CompleteIOUring(Request *request, int count) {
+  size_t length = static_cast<size_t>(request->num_pages) * PAGE_SIZE;
+  if (count < 0 || static_cast<size_t>(count) != length) {
+    // 读到文件末尾之外或者出错时同步重做，ReadPhysicalPages会把文件末尾之外的部分补0
+    page_id_t physical_page_id = disk_manager_->MapPageId(request->logical_page_id);
+    if (request->is_write) {
+      LOG(WARNING) << "Async write of page " << request->logical_page_id << " returned " << count << ", retrying";
+      disk_manager_->WritePhysicalPages(physical_page_id, request->iov);
+    } else {
+      disk_manager_->ReadPhysicalPages(physical_page_id, request->num_pages,
+                                       static_cast<char *>(request->iov[0].iov_base));
+    }
+  } else if (request->is_write) {
+    disk_manager_->ExtendFileSize(request->offset + length);
+  }
+  if (request->is_write) {
+    disk_manager_->num_writes_ += request->num_pages;
+  }
+  Finish(request);
+}
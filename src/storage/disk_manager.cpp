@@ -1,7 +1,15 @@
 #include "storage/disk_manager.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
 #include <filesystem>
 #include <stdexcept>
 
@@ -9,35 +17,108 @@
 #include "page/bitmap_page.h"
 
 
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+DiskManager::DiskManager(const std::string &db_file, bool direct_io, bool read_only)
+    : file_name_(db_file), read_only_(read_only) {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    std::filesystem::path p = db_file;
-    if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
+  if (read_only) {
+    // 只读打开时把整个文件映射进内存，页直接从映射中读取
+    fd_ = open(db_file.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+      LOG(ERROR) << "Can not open db file " << db_file << ": " << strerror(errno);
       throw std::exception();
     }
+    struct stat stat_buf;
+    if (fstat(fd_, &stat_buf) == 0) {
+      file_size_ = stat_buf.st_size;
+    }
+    mapping_size_ = file_size_;
+    if (mapping_size_ > 0) {
+      void *mapping = mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd_, 0);
+      if (mapping == MAP_FAILED) {
+        LOG(ERROR) << "Can not map db file " << db_file << ": " << strerror(errno);
+        close(fd_);
+        throw std::exception();
+      }
+      mapping_ = static_cast<char *>(mapping);
+    }
+    ReadPhysicalPage(META_PAGE_ID, meta_data_);
+    return;
+  }
+  // directory does not exist
+  std::filesystem::path p = db_file;
+  if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
+  if (direct_io) {
+    // tmpfs等文件系统不支持O_DIRECT，退回普通的带缓存读写
+    fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    direct_io_ = fd_ >= 0;
+    if (fd_ < 0 && errno == EINVAL) {
+      LOG(WARNING) << "O_DIRECT is not supported for " << db_file << ", using buffered I/O";
+    }
+  }
+  if (fd_ < 0) {
+    fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  if (fd_ < 0) {
+    LOG(ERROR) << "Can not open db file " << db_file << ": " << strerror(errno);
+    throw std::exception();
+  }
+  struct stat stat_buf;
+  if (fstat(fd_, &stat_buf) == 0) {
+    file_size_ = stat_buf.st_size;
   }
   ReadPhysicalPage(META_PAGE_ID, meta_data_);
 }
 
 void DiskManager::Close() {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  WritePhysicalPage(META_PAGE_ID, meta_data_);
   if (!closed) {
-    db_io_.close();
+    delete async_io_.exchange(nullptr);
+    Sync();
+    if (mapping_ != nullptr) {
+      munmap(mapping_, mapping_size_);
+      mapping_ = nullptr;
+    }
+    close(fd_);
+    // 文件号可能被进程重新分配给别的文件，关闭后不能再用
+    fd_ = -1;
     closed = true;
   }
 }
 
+void DiskManager::Sync() {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  if (read_only_ || closed) {
+    return;
+  }
+  // 修改过的bitmap只在检查点写回
+  for(uint32_t extent_id = 0; extent_id < bitmaps_.size(); extent_id++) {
+    if(bitmap_dirty_[extent_id]) {
+      WritePhysicalPage(GetBitmapPageId(extent_id), bitmaps_[extent_id].get());
+      bitmap_dirty_[extent_id] = false;
+    }
+  }
+  WritePhysicalPage(META_PAGE_ID, meta_data_);
+  if (fdatasync(fd_) != 0) {
+    LOG(ERROR) << "I/O error while syncing: " << strerror(errno);
+  }
+}
+
+AsyncIOEngine *DiskManager::GetAsyncIO() {
+  AsyncIOEngine *async_io = async_io_;
+  if (async_io == nullptr) {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    // 文件关闭后不再启动新的引擎
+    if (closed) {
+      return nullptr;
+    }
+    if (async_io_ == nullptr) {
+      async_io_ = new AsyncIOEngine(this);
+    }
+    async_io = async_io_;
+  }
+  return async_io;
+}
+
 void DiskManager::ReadPage(page_id_t logical_page_id, char *page_data) {
   ASSERT(logical_page_id >= 0, "Invalid page id.");
   ReadPhysicalPage(MapPageId(logical_page_id), page_data);
@@ -45,7 +126,67 @@ void DiskManager::ReadPage(page_id_t logical_page_id, char *page_data) {
 
 void DiskManager::WritePage(page_id_t logical_page_id, const char *page_data) {
   ASSERT(logical_page_id >= 0, "Invalid page id.");
+  if (read_only_) {
+    LOG(ERROR) << "Can not write page " << logical_page_id << " of read only db file " << file_name_;
+    return;
+  }
+  if (closed) {
+    LOG(ERROR) << "Can not write page " << logical_page_id << " of closed db file " << file_name_;
+    return;
+  }
   WritePhysicalPage(MapPageId(logical_page_id), page_data);
+  num_writes_++;
+}
+
+const char *DiskManager::GetMappedPage(page_id_t logical_page_id) {
+  if (mapping_ == nullptr || logical_page_id < 0 || logical_page_id > MAX_VALID_PAGE_ID) {
+    return nullptr;
+  }
+  size_t offset = static_cast<size_t>(MapPageId(logical_page_id)) * PAGE_SIZE;
+  if (offset + PAGE_SIZE > mapping_size_) {
+    return nullptr;
+  }
+  return mapping_ + offset;
+}
+
+void DiskManager::ReadPages(page_id_t logical_page_id, uint32_t num_pages, char *page_data) {
+  ASSERT(logical_page_id >= 0, "Invalid page id.");
+  ASSERT(num_pages <= GetContiguousPages(logical_page_id), "Pages are not contiguous.");
+  ReadPhysicalPages(MapPageId(logical_page_id), num_pages, page_data);
+}
+
+void DiskManager::WritePages(std::vector<std::pair<page_id_t, const char *>> pages) {
+  if (pages.empty()) {
+    return;
+  }
+  if (read_only_) {
+    LOG(ERROR) << "Can not write " << pages.size() << " pages of read only db file " << file_name_;
+    return;
+  }
+  if (closed) {
+    LOG(ERROR) << "Can not write " << pages.size() << " pages of closed db file " << file_name_;
+    return;
+  }
+  // 逻辑页号到物理页号的映射是单调的，按逻辑页号排序即按物理位置排序
+  std::sort(pages.begin(), pages.end(),
+            [](const auto &a, const auto &b) { return a.first < b.first; });
+  IOBatch batch;
+  AsyncIOEngine *async_io = GetAsyncIO();
+  for (size_t i = 0; i < pages.size();) {
+    // 物理上相邻的一段页合并成一次pwritev
+    size_t end = i + 1;
+    while (end < pages.size() && end - i < IOV_MAX &&
+           MapPageId(pages[end].first) == MapPageId(pages[end - 1].first) + 1) {
+      end++;
+    }
+    std::vector<const char *> run;
+    for (size_t j = i; j < end; j++) {
+      run.push_back(pages[j].second);
+    }
+    async_io->SubmitWrites(pages[i].first, std::move(run), &batch);
+    i = end;
+  }
+  batch.Wait();
 }
 
 // /**
@@ -86,53 +227,135 @@ void DiskManager::WritePage(page_id_t logical_page_id, const char *page_data) {
 // * | Meta Page | Free Page BitMap 1 | Page 1 | Page 2 | ....
 // *      | Page N | Free Page BitMap 2 | Page N+1 | ... | Page 2N | ... |
 // 从磁盘中分配一个空闲页，并返回空闲页的逻辑页号；
-page_id_t DiskManager::AllocatePage() {
+page_id_t DiskManager::AllocatePage(ExtentReservation *reservation) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  // 只读打开的文件不能分配页
+  if(read_only_)
+    return INVALID_PAGE_ID;
   // 获取meta_page， 类型为DiskFileMetaPage*
   auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
-  // uint32_t GetExtentNums() { return num_extents_; }
-  // uint32_t GetAllocatedPages() { return num_allocated_pages_; }
-  // uint32_t GetExtentUsedPage(uint32_t extent_id) {
-  //   if (extent_id >= num_extents_) {
-  //     return 0;
-  //   }
-  //   return extent_used_page_[extent_id];
-  // }
   // 如果已经分配的页数超过最大页数，返回INVALID_PAGE_ID
   if(meta_page->GetAllocatedPages() >= MAX_VALID_PAGE_ID)
     return INVALID_PAGE_ID;
-  // 找到第一个可分配的page的extent
-  // extent_num表示当前已经分配的extent数， GetExtentNums()返回uint32_t类型
-  // extent_free表示当前可分配的extent
+  // 跳过已经满了的extent，free_extent_hint_之前的extent都已经满了
   uint32_t extent_num = meta_page->GetExtentNums();
-  uint32_t extent_free = 0;
-  for(extent_free = 0; extent_free < extent_num; extent_free++) {
-    if(meta_page->extent_used_page_[extent_free] < BITMAP_SIZE) {
-      break;
+  while(free_extent_hint_ < extent_num && meta_page->extent_used_page_[free_extent_hint_] >= BITMAP_SIZE) {
+    free_extent_hint_++;
+  }
+  if(reservation != nullptr) {
+    // 依次取出预留段中的页，用完后尽量紧接着上一段再预留一段
+    while(true) {
+      if(reservation->next_page_id_ != INVALID_PAGE_ID && reservation->next_page_id_ < reservation->end_page_id_) {
+        page_id_t page_id = reservation->next_page_id_++;
+        if(TakePage(page_id))
+          return page_id;
+        continue;
+      }
+      page_id_t start = reservation->end_page_id_;
+      ReleaseReservation(reservation);
+      if(!ReserveRun(reservation, start)) {
+        LOG(ERROR) << "Allocate page failed" << std::endl;
+        return INVALID_PAGE_ID;
+      }
+    }
+  }
+  // 不属于任何对象的页：找第一个不在预留段中的空闲页
+  // extent_id最大等于extent_num,此时意味着需要新建一个分区
+  for(uint32_t extent_id = free_extent_hint_; extent_id <= extent_num && extent_id < MAX_VALID_PAGE_ID / BITMAP_SIZE; extent_id++) {
+    if(extent_id < extent_num && meta_page->extent_used_page_[extent_id] >= BITMAP_SIZE)
+      continue;
+    auto bitmap_page = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(GetBitmap(extent_id));
+    page_id_t extent_start = extent_id * BITMAP_SIZE;
+    uint32_t page_offset = bitmap_page->GetNextFreePage();
+    if(page_offset >= BITMAP_SIZE || !bitmap_page->IsPageFree(page_offset))
+      page_offset = bitmap_page->FindFreePage(0);
+    page_id_t run_end;
+    while(page_offset < BITMAP_SIZE && (run_end = GetReservedRunEnd(extent_start + page_offset)) != INVALID_PAGE_ID) {
+      page_offset = bitmap_page->FindFreePage(run_end - extent_start);
+    }
+    if(page_offset < BITMAP_SIZE) {
+      TakePage(extent_start + page_offset);
+      // 返回逻辑页号
+      return extent_start + page_offset;
     }
   }
-  // 此时extent_free为可分配的extent，extent_free最大等于extent_num,此时意味着需要新建一个分区
-  // 知道分区后，找到对应的bitmap_page
-  char page_data[PAGE_SIZE];
-  // 计算物理页号，每个extent的第一个page用于存储bitmap，额外加上meta_page
-  page_id_t physical_page_id = extent_free * (BITMAP_SIZE + 1) + 1;
-  // page_data用于存储bitmap_page
-  ReadPhysicalPage(physical_page_id, page_data);
-  auto bitmap_page = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(page_data);
-  // 利用bitmap_page分配一个空闲页
-  uint32_t page_offset = 0;
-  if(!bitmap_page->AllocatePage(page_offset)) {
-    LOG(ERROR) << "Allocate page failed" << std::endl;
-  }
-  // 将bitmap_page写回磁盘，更新bitmap_page
-  WritePhysicalPage(physical_page_id, page_data);
+  LOG(ERROR) << "Allocate page failed" << std::endl;
+  return INVALID_PAGE_ID;
+}
+
+bool DiskManager::TakePage(page_id_t logical_page_id) {
+  uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+  // bitmap常驻内存，分配只修改内存中的bitmap，检查点时再写回磁盘
+  auto bitmap_page = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(GetBitmap(extent_id));
+  if(!bitmap_page->AllocatePageAt(logical_page_id % BITMAP_SIZE))
+    return false;
+  bitmap_dirty_[extent_id] = true;
   // 更新meta_page
-  meta_page->extent_used_page_[extent_free]++;
+  auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  meta_page->extent_used_page_[extent_id]++;
   meta_page->num_allocated_pages_++;
-  // 如果extent_used_page_[extent_free]为1，表示新建了一个extent
-  if(meta_page->extent_used_page_[extent_free] == 1)
-    meta_page->num_extents_++;
-  // 返回逻辑页号
-  return extent_free * BITMAP_SIZE + page_offset;
+  // 用到了新的extent
+  if(extent_id >= meta_page->num_extents_)
+    meta_page->num_extents_ = extent_id + 1;
+  return true;
+}
+
+bool DiskManager::ReserveRun(ExtentReservation *reservation, page_id_t start) {
+  auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  uint32_t extent_num = meta_page->GetExtentNums();
+  // 优先紧接着上一段，没有上一段时从第一个未满的extent开始
+  if(start == INVALID_PAGE_ID || start / BITMAP_SIZE < free_extent_hint_)
+    start = free_extent_hint_ * BITMAP_SIZE;
+  for(uint32_t extent_id = start / BITMAP_SIZE; extent_id <= extent_num && extent_id < MAX_VALID_PAGE_ID / BITMAP_SIZE; extent_id++) {
+    if(extent_id < extent_num && meta_page->extent_used_page_[extent_id] >= BITMAP_SIZE)
+      continue;
+    auto bitmap_page = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(GetBitmap(extent_id));
+    page_id_t extent_start = extent_id * BITMAP_SIZE;
+    // 找到第一个不在别人预留段中的空闲页作为段的起点
+    uint32_t page_offset = bitmap_page->FindFreePage(extent_id == start / BITMAP_SIZE ? start - extent_start : 0);
+    page_id_t run_end;
+    while(page_offset < BITMAP_SIZE && (run_end = GetReservedRunEnd(extent_start + page_offset)) != INVALID_PAGE_ID) {
+      page_offset = bitmap_page->FindFreePage(run_end - extent_start);
+    }
+    if(page_offset >= BITMAP_SIZE)
+      continue;
+    // 向后延伸，直到段长足够、遇到已分配的页、遇到别人的预留段或者到达extent末尾
+    page_id_t first_page_id = extent_start + page_offset;
+    page_id_t limit = std::min<page_id_t>(first_page_id + EXTENT_RESERVATION_PAGES, extent_start + BITMAP_SIZE);
+    auto next_run = reserved_runs_.upper_bound(first_page_id);
+    if(next_run != reserved_runs_.end() && next_run->first < limit)
+      limit = next_run->first;
+    page_id_t end_page_id = first_page_id + 1;
+    while(end_page_id < limit && bitmap_page->IsPageFree(end_page_id - extent_start)) {
+      end_page_id++;
+    }
+    reserved_runs_[first_page_id] = end_page_id;
+    reservation->next_page_id_ = first_page_id;
+    reservation->end_page_id_ = end_page_id;
+    return true;
+  }
+  return false;
+}
+
+page_id_t DiskManager::GetReservedRunEnd(page_id_t logical_page_id) {
+  // 起点不大于该页的最后一个预留段
+  auto iter = reserved_runs_.upper_bound(logical_page_id);
+  if(iter == reserved_runs_.begin())
+    return INVALID_PAGE_ID;
+  --iter;
+  return logical_page_id < iter->second ? iter->second : INVALID_PAGE_ID;
+}
+
+void DiskManager::ReleaseReservation(ExtentReservation *reservation) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  // 段中没有用到的页在bitmap中一直是空闲的，只需删除预留记录
+  if(reservation->end_page_id_ != INVALID_PAGE_ID) {
+    auto iter = reserved_runs_.upper_bound(reservation->end_page_id_ - 1);
+    if(iter != reserved_runs_.begin() && (--iter)->second == reservation->end_page_id_)
+      reserved_runs_.erase(iter);
+  }
+  reservation->next_page_id_ = INVALID_PAGE_ID;
+  reservation->end_page_id_ = INVALID_PAGE_ID;
 }
 // /**
 //  * TODO: Student Implement
@@ -158,15 +381,15 @@ page_id_t DiskManager::AllocatePage() {
  */
 // 释放磁盘中逻辑页号对应的物理页。
 void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
   auto meta_page = reinterpret_cast<DiskFileMetaPage *> (meta_data_);
   // logical_page__id = i * BITMAP_SIZE + offset
-  // physical_page_id = i * (BITMAP_SIZE + 1) + 1 + offset
-  // 已知逻辑页号，计算物理页号
-  page_id_t physical_page_id = (logical_page_id / BITMAP_SIZE) * (BITMAP_SIZE + 1) + 1;
-  // 没有offset，计算的是bitmap_page的物理页号
-  char page_data[PAGE_SIZE];
-  ReadPhysicalPage(physical_page_id, page_data);
-  auto bitmap_page = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(page_data);
+  uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+  if(read_only_ || logical_page_id < 0 || extent_id >= meta_page->GetExtentNums()) {
+    LOG(ERROR) << "Deallocate page failed" << std::endl;
+    return;
+  }
+  auto bitmap_page = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(GetBitmap(extent_id));
   // 计算出page_offset
   // bool BitmapPage<PageSize>::DeAllocatePage(uint32_t page_offset)
   uint32_t page_offset = logical_page_id % BITMAP_SIZE;
@@ -175,12 +398,23 @@ void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
   }
   else {
     // 释放成功
-    WritePhysicalPage(physical_page_id, page_data);
+    bitmap_dirty_[extent_id] = true;
     meta_page->num_allocated_pages_--;
-    meta_page->extent_used_page_[logical_page_id / BITMAP_SIZE]--;
+    meta_page->extent_used_page_[extent_id]--;
+    // 该extent又有了空闲页
+    if(extent_id < free_extent_hint_)
+      free_extent_hint_ = extent_id;
   }
+}
 
-
+// 一次释放多个页，整个过程只加一次锁
+void DiskManager::DeAllocatePages(std::vector<page_id_t> logical_page_ids) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  // 按页号排序，同一个extent的页连续处理
+  std::sort(logical_page_ids.begin(), logical_page_ids.end());
+  for(auto page_id : logical_page_ids) {
+    DeAllocatePage(page_id);
+  }
 }
 // /**
 //  * TODO: Student Implement
@@ -201,17 +435,32 @@ void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
  */
 // 判断该逻辑页号对应的数据页是否空闲。
 bool DiskManager::IsPageFree(page_id_t logical_page_id) {
-  if(logical_page_id > MAX_VALID_PAGE_ID)
+  if(logical_page_id < 0 || logical_page_id > MAX_VALID_PAGE_ID)
     return false;
-  // 先计算物理页号，然后读取bitmap_page，判断该页是否空闲
-  page_id_t physical_page_id = MapPageId(logical_page_id)-1-logical_page_id%BITMAP_SIZE;
-  char page_data[PAGE_SIZE];
-  ReadPhysicalPage(physical_page_id, page_data);
-  auto bitmap_page = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(page_data);
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  // 还没有用到的extent中的页都是空闲的
+  uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+  if(extent_id >= reinterpret_cast<DiskFileMetaPage *>(meta_data_)->GetExtentNums())
+    return true;
+  auto bitmap_page = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(GetBitmap(extent_id));
   // bool BitmapPage<PageSize>::IsPageFree(uint32_t page_offset) const
   uint32_t offset = logical_page_id % BITMAP_SIZE;
   return bitmap_page->IsPageFree(offset);
 }
+
+char *DiskManager::GetBitmap(uint32_t extent_id) {
+  if(extent_id >= bitmaps_.size()) {
+    bitmaps_.resize(extent_id + 1);
+    bitmap_dirty_.resize(extent_id + 1, false);
+  }
+  // 第一次用到时从磁盘读入，之后常驻内存
+  if(bitmaps_[extent_id] == nullptr) {
+    bitmaps_[extent_id] = AllocateAlignedPages(1);
+    ReadPhysicalPage(GetBitmapPageId(extent_id), bitmaps_[extent_id].get());
+  }
+  return bitmaps_[extent_id].get();
+}
+
 /**
  * TODO: Student Implement
  */
@@ -224,45 +473,118 @@ page_id_t DiskManager::MapPageId(page_id_t logical_page_id) {
   return extent_id * (BITMAP_SIZE + 1) + 1 + offset + 1;
 }
 
-int DiskManager::GetFileSize(const std::string &file_name) {
-  struct stat stat_buf;
-  int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? stat_buf.st_size : -1;
+void DiskManager::ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
+  ReadPhysicalPages(physical_page_id, 1, page_data);
 }
 
-void DiskManager::ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
-  int offset = physical_page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset >= GetFileSize(file_name_)) {
-#ifdef ENABLE_BPM_DEBUG
-    LOG(INFO) << "Read less than a page" << std::endl;
-#endif
-    memset(page_data, 0, PAGE_SIZE);
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-#ifdef ENABLE_BPM_DEBUG
-      LOG(INFO) << "Read less than a page" << std::endl;
-#endif
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+void DiskManager::ReadPhysicalPages(page_id_t physical_page_id, uint32_t num_pages, char *page_data) {
+  if (!CanTransferDirectly({{page_data, static_cast<size_t>(num_pages) * PAGE_SIZE}})) {
+    // O_DIRECT要求缓冲区按页对齐，不对齐时先读到对齐的缓冲区再拷贝
+    AlignedPages buffer = AllocateAlignedPages(num_pages);
+    ReadPhysicalPages(physical_page_id, num_pages, buffer.get());
+    memcpy(page_data, buffer.get(), static_cast<size_t>(num_pages) * PAGE_SIZE);
+    return;
+  }
+  size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
+  size_t length = static_cast<size_t>(num_pages) * PAGE_SIZE;
+  size_t file_size = file_size_;
+  size_t read_count = 0;
+  // 超出文件末尾的部分视为全0，pread可能一次读不完，需要循环读取
+  size_t to_read = offset < file_size ? std::min(length, file_size - offset) : 0;
+  while (read_count < to_read) {
+    ssize_t rc = pread(fd_, page_data + read_count, to_read - read_count, offset + read_count);
+    if (rc < 0 && errno == EINTR) {
+      continue;
     }
+    if (rc <= 0) {
+      if (rc < 0) {
+        LOG(ERROR) << "I/O error while reading: " << strerror(errno);
+      }
+      break;
+    }
+    read_count += rc;
   }
+  memset(page_data + read_count, 0, length - read_count);
 }
 
 void DiskManager::WritePhysicalPage(page_id_t physical_page_id, const char *page_data) {
+  if (!CanTransferDirectly({{const_cast<char *>(page_data), PAGE_SIZE}})) {
+    AlignedPages buffer = AllocateAlignedPages(1);
+    memcpy(buffer.get(), page_data, PAGE_SIZE);
+    WritePhysicalPage(physical_page_id, buffer.get());
+    return;
+  }
   size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG(ERROR) << "I/O error while writing";
+  size_t write_count = 0;
+  while (write_count < PAGE_SIZE) {
+    ssize_t rc = pwrite(fd_, page_data + write_count, PAGE_SIZE - write_count, offset + write_count);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc < 0) {
+      LOG(ERROR) << "I/O error while writing: " << strerror(errno);
+      return;
+    }
+    write_count += rc;
+  }
+  ExtendFileSize(offset + PAGE_SIZE);
+}
+
+void DiskManager::WritePhysicalPages(page_id_t physical_page_id, std::vector<struct iovec> iov) {
+  if (!CanTransferDirectly(iov)) {
+    // 有不对齐的缓冲区时整段拷贝到一个对齐的缓冲区里，用一个iovec写出
+    AlignedPages buffer = AllocateAlignedPages(iov.size());
+    for (size_t i = 0; i < iov.size(); i++) {
+      memcpy(buffer.get() + i * PAGE_SIZE, iov[i].iov_base, PAGE_SIZE);
+    }
+    WritePhysicalPages(physical_page_id, {{buffer.get(), iov.size() * PAGE_SIZE}});
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
+  size_t length = 0;
+  for (auto &buffer : iov) {
+    length += buffer.iov_len;
+  }
+  size_t write_count = 0;
+  size_t first = 0;
+  while (write_count < length) {
+    int iov_count = static_cast<int>(std::min<size_t>(iov.size() - first, IOV_MAX));
+    ssize_t rc = pwritev(fd_, iov.data() + first, iov_count, offset + write_count);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc < 0) {
+      LOG(ERROR) << "I/O error while writing: " << strerror(errno);
+      return;
+    }
+    write_count += rc;
+    // 只写了一部分时，跳过已经写完的缓冲区，从写了一半的缓冲区的剩余部分继续
+    while (rc > 0) {
+      if (static_cast<size_t>(rc) >= iov[first].iov_len) {
+        rc -= iov[first].iov_len;
+        first++;
+      } else {
+        iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + rc;
+        iov[first].iov_len -= rc;
+        rc = 0;
+      }
+    }
+  }
+  ExtendFileSize(offset + length);
+}
+
+bool DiskManager::CanTransferDirectly(const std::vector<struct iovec> &iov) const {
+  if (!direct_io_) {
+    return true;
+  }
+  return std::all_of(iov.begin(), iov.end(), [](const struct iovec &buffer) {
+    return reinterpret_cast<uintptr_t>(buffer.iov_base) % PAGE_SIZE == 0;
+  });
+}
+
+void DiskManager::ExtendFileSize(size_t end) {
+  // 文件变长时更新缓存的文件大小
+  size_t file_size = file_size_;
+  while (file_size < end && !file_size_.compare_exchange_weak(file_size, end)) {
+  }
 }
@@ -1,58 +1,341 @@
 #include "storage/table_heap.h"
 
+#include <algorithm>
+#include <memory>
+
+#include "glog/logging.h"
+
 /**
  * TODO: Student Implement
  */
-bool TableHeap::InsertTuple(Row &row, Txn *txn) {
+bool TableHeap::InsertTuple(Row &row, Txn *txn, BufferAccessStrategy *strategy) {
   uint32_t tuple_size = row.GetSerializedSize(schema_);
-  if (tuple_size > PAGE_SIZE) {
+  // 空页都放不下的行直接拒绝，不追加新页；只读打开的数据库中页不可写
+  if (tuple_size > TablePage::SIZE_MAX_ROW || buffer_pool_manager_->IsReadOnly()) {
     return false;
   }
-  page_id_t page_id = first_page_id_;
-  page_id_t prev_page_id = INVALID_PAGE_ID;
-  // TablePage *page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(page_id));
-  bool is_sucess = false;
-  while (!is_sucess) {
-    if (page_id == INVALID_PAGE_ID) {
-      buffer_pool_manager_->NewPage(page_id);
-      auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
-      if (page == nullptr) {
-        return false;
+  std::lock_guard<std::mutex> guard(latch_);
+  LoadFreeSpaceMap();
+  // 1. 只追加的表总是先试最后一页，只碰一个页
+  if (last_page_id_ != INVALID_PAGE_ID && InsertIntoPage(last_page_id_, row, txn, strategy)) {
+    return true;
+  }
+  // 2. 在空闲空间映射中找一个类别足够的页，fsm_max_ 跳过肯定没有空间的映射页
+  uint8_t min_category = FreeSpaceMapPage::ToCategory(TablePage::GetSpaceNeeded(tuple_size), true);
+  for (size_t i = 0; i < fsm_pages_.size(); i++) {
+    if (fsm_max_[i] < min_category) {
+      continue;
+    }
+    auto fsm_page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(fsm_pages_[i]));
+    if (fsm_page == nullptr) {
+      return false;
+    }
+    int slot = -1;
+    while (true) {
+      fsm_page->RLatch();
+      slot = fsm_page->FindSlot(min_category, slot + 1);
+      page_id_t page_id = slot == -1 ? INVALID_PAGE_ID : fsm_page->GetTablePageId(slot);
+      fsm_page->RUnlatch();
+      if (slot == -1) {
+        break;
       }
-      page->WLatch();
-      page->Init(page_id, prev_page_id, log_manager_, txn);
-      is_sucess = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
-      page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(page_id, true);
-      if (prev_page_id == INVALID_PAGE_ID) {
-        first_page_id_ = page_id;
-      } else {
-        auto temp_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(prev_page_id));
-        temp_page->WLatch();
-        temp_page->SetNextPageId(page_id);
-        temp_page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(prev_page_id, true);
+      // 插入失败说明类别过期，InsertIntoPage 已经把它改成了真实值
+      if (page_id != last_page_id_ && InsertIntoPage(page_id, row, txn, strategy)) {
+        buffer_pool_manager_->UnpinPage(fsm_pages_[i], false);
+        return true;
       }
+    }
+    fsm_page->RLatch();
+    fsm_max_[i] = fsm_page->GetMaxCategory();
+    fsm_page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(fsm_pages_[i], false);
+  }
+  // 3. 没有页放得下，在链表末尾追加新页
+  page_id_t page_id;
+  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(page_id, strategy, &reservation_));
+  if (page == nullptr) {
+    return false;
+  }
+  page->WLatch();
+  page->Init(page_id, last_page_id_, log_manager_, txn);
+  bool is_success = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+  uint32_t free_space = page->GetFreeSpaceRemaining();
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  if (last_page_id_ == INVALID_PAGE_ID) {
+    first_page_id_ = page_id;
+  } else {
+    auto prev_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_page_id_));
+    prev_page->WLatch();
+    prev_page->SetNextPageId(page_id);
+    prev_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(last_page_id_, true);
+  }
+  last_page_id_ = page_id;
+  AppendFreeSpaceEntry(page_id, free_space);
+  return is_success;
+}
+
+size_t TableHeap::InsertTuples(std::vector<Row> &rows, Txn *txn, BufferAccessStrategy *strategy) {
+  if (rows.empty() || buffer_pool_manager_->IsReadOnly()) {
+    return 0;
+  }
+  // 大批量插入只使用一个小的私有环，避免把其他查询的热点页换出
+  std::unique_ptr<BufferAccessStrategy> bulk_write;
+  if (strategy == nullptr && rows.size() >= BULK_WRITE_MIN_ROWS) {
+    bulk_write = std::make_unique<BufferAccessStrategy>(AccessStrategyType::kBulkWrite, buffer_pool_manager_);
+    strategy = bulk_write.get();
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  LoadFreeSpaceMap();
+  size_t next = 0;
+  // 1. 先把最后一页填满
+  if (last_page_id_ != INVALID_PAGE_ID) {
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_page_id_, strategy));
+    if (page == nullptr) {
+      return 0;
+    }
+    page->WLatch();
+    next = FillPage(page, rows, next, txn);
+    uint32_t free_space = page->GetFreeSpaceRemaining();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(last_page_id_, next > 0);
+    SetFreeSpace(last_page_id_, free_space);
+  }
+  // 2. 剩下的行连续追加新页，上一页保持 pin 直到链上下一页，不必再取回来改 next 指针
+  TablePage *prev_page = nullptr;
+  while (next < rows.size()) {
+    // 空页都放不下这一行，不再追加新页
+    if (rows[next].GetSerializedSize(schema_) > TablePage::SIZE_MAX_ROW) {
+      break;
+    }
+    page_id_t page_id;
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(page_id, strategy, &reservation_));
+    if (page == nullptr) {
       break;
+    }
+    page->WLatch();
+    page->Init(page_id, last_page_id_, log_manager_, txn);
+    size_t end = FillPage(page, rows, next, txn);
+    uint32_t free_space = page->GetFreeSpaceRemaining();
+    page->WUnlatch();
+    if (prev_page != nullptr) {
+      prev_page->WLatch();
+      prev_page->SetNextPageId(page_id);
+      prev_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(last_page_id_, true);
+    } else if (last_page_id_ == INVALID_PAGE_ID) {
+      first_page_id_ = page_id;
     } else {
-      auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
-      if (page == nullptr) {
-        return false;
+      auto tail_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_page_id_, strategy));
+      tail_page->WLatch();
+      tail_page->SetNextPageId(page_id);
+      tail_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(last_page_id_, true);
+    }
+    prev_page = page;
+    last_page_id_ = page_id;
+    AppendFreeSpaceEntry(page_id, free_space);
+    next = end;
+  }
+  if (prev_page != nullptr) {
+    buffer_pool_manager_->UnpinPage(last_page_id_, true);
+  }
+  return next;
+}
+
+size_t TableHeap::FillPage(TablePage *page, std::vector<Row> &rows, size_t begin, Txn *txn) {
+  while (begin < rows.size() && page->InsertTuple(rows[begin], schema_, txn, lock_manager_, log_manager_)) {
+    begin++;
+  }
+  return begin;
+}
+
+bool TableHeap::InsertIntoPage(page_id_t page_id, Row &row, Txn *txn, BufferAccessStrategy *strategy) {
+  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id, strategy));
+  if (page == nullptr) {
+    return false;
+  }
+  page->WLatch();
+  bool is_success = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+  uint32_t free_space = page->GetFreeSpaceRemaining();
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, is_success);
+  SetFreeSpace(page_id, free_space);
+  return is_success;
+}
+
+void TableHeap::LoadFreeSpaceMap() {
+  if (fsm_loaded_) {
+    return;
+  }
+  fsm_loaded_ = true;
+  // 读出映射页链，重建页号到槽位的索引
+  for (page_id_t fsm_page_id = fsm_page_id_; fsm_page_id != INVALID_PAGE_ID;) {
+    auto fsm_page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(fsm_page_id));
+    ASSERT(fsm_page != nullptr, "Can not fetch free space map page.");
+    fsm_pages_.push_back(fsm_page_id);
+    fsm_max_.push_back(fsm_page->GetMaxCategory());
+    uint32_t count = fsm_page->GetEntryCount();
+    for (uint32_t slot = 0; slot < count; slot++) {
+      page_id_t page_id = fsm_page->GetTablePageId(slot);
+      // 被 vacuum 释放的页只留下一个空槽位
+      if (page_id == INVALID_PAGE_ID) {
+        fsm_entries_++;
+        continue;
       }
-      page->WLatch();
-      is_sucess = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
-      page->WUnlatch();
-      prev_page_id = page_id;
-      page->RLatch();
-      page_id = page->GetNextPageId();
-      page->RUnlatch();
-      buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+      last_page_id_ = page_id;
+      AddFreeSpaceRun(last_page_id_, fsm_entries_++);
+    }
+    page_id_t next_page_id = fsm_page->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(fsm_page_id, false);
+    fsm_page_id = next_page_id;
+  }
+  if (buffer_pool_manager_->IsReadOnly()) {
+    return;
+  }
+  // 映射没有覆盖到的页（映射出现之前写下的堆）沿链表补上，正常情况下只读最后一页
+  page_id_t page_id = last_page_id_ == INVALID_PAGE_ID ? first_page_id_ : last_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    ASSERT(page != nullptr, "Can not fetch table page.");
+    page->RLatch();
+    uint32_t free_space = page->GetFreeSpaceRemaining();
+    page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    if (page_id != last_page_id_) {
+      last_page_id_ = page_id;
+      AppendFreeSpaceEntry(page_id, free_space);
+    }
+    page_id = next_page_id;
+  }
+}
+
+void TableHeap::RecordFreeSpace(page_id_t page_id, uint32_t free_space) {
+  if (buffer_pool_manager_->IsReadOnly()) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  LoadFreeSpaceMap();
+  SetFreeSpace(page_id, free_space);
+}
+
+void TableHeap::SetFreeSpace(page_id_t page_id, uint32_t free_space) {
+  int slot = LookupFreeSpaceSlot(page_id);
+  if (slot == -1) {
+    return;
+  }
+  size_t index = slot / FreeSpaceMapPage::CAPACITY;
+  uint32_t offset = slot % FreeSpaceMapPage::CAPACITY;
+  auto fsm_page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(fsm_pages_[index]));
+  if (fsm_page == nullptr) {
+    return;
+  }
+  uint8_t category = FreeSpaceMapPage::ToCategory(free_space);
+  fsm_page->WLatch();
+  bool is_dirty = fsm_page->GetCategory(offset) != category;
+  if (is_dirty) {
+    fsm_page->SetCategory(offset, category);
+  }
+  fsm_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(fsm_pages_[index], is_dirty);
+  fsm_max_[index] = std::max(fsm_max_[index], category);
+}
+
+void TableHeap::AppendFreeSpaceEntry(page_id_t page_id, uint32_t free_space) {
+  // 最后一个映射页满了（或者还没有映射页），新开一个映射页接到链尾
+  if (fsm_entries_ % FreeSpaceMapPage::CAPACITY == 0) {
+    page_id_t fsm_page_id;
+    auto new_page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->NewPage(fsm_page_id));
+    if (new_page == nullptr) {
+      // 映射只是提示，页仍然在链表里，重新打开时会被补上
+      LOG(WARNING) << "Can not allocate free space map page, page " << page_id << " is not tracked.";
+      return;
     }
+    new_page->Init(fsm_page_id);
+    buffer_pool_manager_->UnpinPage(fsm_page_id, true);
+    if (fsm_pages_.empty()) {
+      fsm_page_id_ = fsm_page_id;
+    } else {
+      auto prev_page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(fsm_pages_.back()));
+      prev_page->WLatch();
+      prev_page->SetNextPageId(fsm_page_id);
+      prev_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(fsm_pages_.back(), true);
+    }
+    fsm_pages_.push_back(fsm_page_id);
+    fsm_max_.push_back(0);
+  }
+  auto fsm_page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(fsm_pages_.back()));
+  if (fsm_page == nullptr) {
+    return;
+  }
+  uint8_t category = FreeSpaceMapPage::ToCategory(free_space);
+  fsm_page->WLatch();
+  fsm_page->Append(page_id, category);
+  fsm_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(fsm_pages_.back(), true);
+  fsm_max_.back() = std::max(fsm_max_.back(), category);
+  AddFreeSpaceRun(page_id, fsm_entries_++);
+}
+
+void TableHeap::AddFreeSpaceRun(page_id_t page_id, uint32_t slot) {
+  // 页号和槽位都与上一段相接的页并入上一段
+  auto it = fsm_runs_.upper_bound(page_id);
+  if (it != fsm_runs_.begin()) {
+    --it;
+    if (static_cast<uint32_t>(page_id - it->first) == it->second.count && it->second.first_slot + it->second.count == slot) {
+      it->second.count++;
+      return;
+    }
+  }
+  fsm_runs_[page_id] = FreeSpaceRun{slot, 1};
+}
+
+void TableHeap::ForgetFreeSpaceEntry(page_id_t page_id) {
+  int slot = LookupFreeSpaceSlot(page_id);
+  if (slot == -1) {
+    return;
+  }
+  size_t index = slot / FreeSpaceMapPage::CAPACITY;
+  auto fsm_page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(fsm_pages_[index]));
+  if (fsm_page != nullptr) {
+    fsm_page->WLatch();
+    fsm_page->ClearEntry(slot % FreeSpaceMapPage::CAPACITY);
+    fsm_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(fsm_pages_[index], true);
+  }
+  // 页所在的段从这一页处断开，前后两段分别保留
+  auto it = --fsm_runs_.upper_bound(page_id);
+  FreeSpaceRun run = it->second;
+  uint32_t before = page_id - it->first;
+  if (before == 0) {
+    fsm_runs_.erase(it);
+  } else {
+    it->second.count = before;
+  }
+  if (before + 1 < run.count) {
+    fsm_runs_[page_id + 1] = FreeSpaceRun{run.first_slot + before + 1, run.count - before - 1};
   }
-  return is_sucess;
+}
+
+int TableHeap::LookupFreeSpaceSlot(page_id_t page_id) const {
+  auto it = fsm_runs_.upper_bound(page_id);
+  if (it == fsm_runs_.begin()) {
+    return -1;
+  }
+  --it;
+  if (static_cast<uint32_t>(page_id - it->first) >= it->second.count) {
+    return -1;
+  }
+  return static_cast<int>(it->second.first_slot + (page_id - it->first));
 }
 
 bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
+  if (buffer_pool_manager_->IsReadOnly()) {
+    return false;
+  }
   // Find the page which contains the tuple.
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   // If the page could not be found, then abort the recovery.
@@ -61,7 +344,9 @@ bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
   }
   // Otherwise, mark the tuple as deleted.
   page->WLatch();
-  page->MarkDelete(rid, txn, lock_manager_, log_manager_);
+  if (page->MarkDelete(rid, txn, lock_manager_, log_manager_)) {
+    dead_tuples_++;
+  }
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
   return true;
@@ -71,12 +356,17 @@ bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
  * TODO: Student Implement
  */
 bool TableHeap::UpdateTuple(const Row &row, const RowId &rid, Txn *txn) {
+  if (buffer_pool_manager_->IsReadOnly()) {
+    return false;
+  }
   auto old_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   old_page->WLatch();
   Row old_row = Row(rid);
   bool update_result = old_page->UpdateTuple(row, &old_row, schema_, txn, lock_manager_, log_manager_);
+  uint32_t free_space = old_page->GetFreeSpaceRemaining();
   old_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(old_page->GetPageId(), true);
+  RecordFreeSpace(rid.GetPageId(), free_space);
   return update_result;
 }
 
@@ -90,8 +380,11 @@ void TableHeap::ApplyDelete(const RowId &rid, Txn *txn) {
   assert(page != nullptr);
   page->WLatch();
   page->ApplyDelete(rid, txn, log_manager_);
+  uint32_t free_space = page->GetFreeSpaceRemaining();
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  // Step3: Record the space freed in the free space map.
+  RecordFreeSpace(rid.GetPageId(), free_space);
 }
 
 void TableHeap::RollbackDelete(const RowId &rid, Txn *txn) {
@@ -121,23 +414,133 @@ bool TableHeap::GetTuple(Row *row, Txn *txn) {
 }
 
 void TableHeap::DeleteTable(page_id_t page_id) {
-  if (page_id != INVALID_PAGE_ID) {
-    auto temp_table_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));  // 删除table_heap
-    if (temp_table_page->GetNextPageId() != INVALID_PAGE_ID) DeleteTable(temp_table_page->GetNextPageId());
-    buffer_pool_manager_->UnpinPage(page_id, false);
-    buffer_pool_manager_->DeletePage(page_id);
+  std::lock_guard<std::mutex> guard(latch_);
+  bool whole_heap = page_id == INVALID_PAGE_ID || page_id == first_page_id_;
+  if (page_id == INVALID_PAGE_ID) {
+    page_id = first_page_id_;
+  }
+  if (!whole_heap) {
+    LoadFreeSpaceMap();
+  }
+  // 先收集整条页链，再一次性释放
+  std::vector<page_id_t> page_ids;
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  while (page_id != INVALID_PAGE_ID) {
+    auto temp_table_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    assert(temp_table_page != nullptr);
+    if (page_ids.empty()) {
+      prev_page_id = temp_table_page->GetPrevPageId();
+    }
+    page_ids.push_back(page_id);
+    page_id = temp_table_page->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_ids.back(), false);
+  }
+  if (whole_heap) {
+    // 整个堆连同空闲空间映射页一起释放
+    for (page_id_t fsm_page_id = fsm_page_id_; fsm_page_id != INVALID_PAGE_ID;) {
+      auto fsm_page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(fsm_page_id));
+      assert(fsm_page != nullptr);
+      page_ids.push_back(fsm_page_id);
+      fsm_page_id = fsm_page->GetNextPageId();
+      buffer_pool_manager_->UnpinPage(page_ids.back(), false);
+    }
+    fsm_page_id_ = INVALID_PAGE_ID;
+    last_page_id_ = INVALID_PAGE_ID;
+    fsm_pages_.clear();
+    fsm_max_.clear();
+    fsm_runs_.clear();
+    fsm_entries_ = 0;
+    fsm_loaded_ = true;
   } else {
-    DeleteTable(first_page_id_);
+    // 只释放链表的尾部时，这些页从映射中去掉，不会再被插入选中
+    for (auto deleted_page_id : page_ids) {
+      ForgetFreeSpaceEntry(deleted_page_id);
+    }
+    if (std::find(page_ids.begin(), page_ids.end(), last_page_id_) != page_ids.end()) {
+      last_page_id_ = prev_page_id;
+    }
+  }
+  buffer_pool_manager_->DeletePages(page_ids);
+}
+
+VacuumStats TableHeap::Vacuum([[maybe_unused]] Txn *txn, bool free_empty_pages) {
+  VacuumStats stats;
+  if (buffer_pool_manager_->IsReadOnly()) {
+    return stats;
+  }
+  std::lock_guard<std::mutex> vacuum_guard(vacuum_latch_);
+  uint32_t dead_tuples = dead_tuples_.load();
+  std::vector<page_id_t> freed_page_ids;
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  page_id_t page_id;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    LoadFreeSpaceMap();
+    page_id = first_page_id_;
+  }
+  while (page_id != INVALID_PAGE_ID) {
+    // latch_ 只在处理一页时持有，插入不必等整条链扫完
+    std::lock_guard<std::mutex> guard(latch_);
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      LOG(WARNING) << "Can not fetch table page " << page_id << ", vacuum stopped.";
+      break;
+    }
+    page->WLatch();
+    // 前一页被释放过，这一页的 prev 指针改成留下来的那一页
+    bool is_dirty = false;
+    if (page->GetPrevPageId() != prev_page_id) {
+      page->SetPrevPageId(prev_page_id);
+      is_dirty = true;
+    }
+    uint32_t old_free_space = page->GetFreeSpaceRemaining();
+    uint32_t reclaimed_bytes = 0;
+    uint32_t removed = page->Vacuum(&reclaimed_bytes);
+    uint32_t free_space = page->GetFreeSpaceRemaining();
+    page_id_t next_page_id = page->GetNextPageId();
+    // 第一页和最后一页的页号被目录和插入记着，不释放；别人还 pin 着的页也不释放
+    bool is_freed = free_empty_pages && page->IsEmpty() && page_id != first_page_id_ && page_id != last_page_id_ &&
+                    page->GetPinCount() == 1;
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, is_dirty || removed > 0 || free_space != old_free_space);
+    stats.pages_scanned++;
+    stats.tuples_removed += removed;
+    stats.bytes_reclaimed += reclaimed_bytes;
+    if (is_freed) {
+      // 前一页已经处理过，取回来把 next 指针跳过这一页
+      auto prev_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(prev_page_id));
+      prev_page->WLatch();
+      prev_page->SetNextPageId(next_page_id);
+      prev_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(prev_page_id, true);
+      ForgetFreeSpaceEntry(page_id);
+      freed_page_ids.push_back(page_id);
+    } else {
+      SetFreeSpace(page_id, free_space);
+      prev_page_id = page_id;
+    }
+    page_id = next_page_id;
+  }
+  // 摘下来以后又被别人 pin 住的页删不掉，只统计真正释放了的页
+  if (!freed_page_ids.empty()) {
+    size_t num_deleted = 0;
+    if (!buffer_pool_manager_->DeletePages(freed_page_ids, &num_deleted)) {
+      LOG(WARNING) << freed_page_ids.size() - num_deleted << " unlinked table pages are pinned and not freed.";
+    }
+    stats.pages_freed = num_deleted;
   }
+  // 只有 vacuum 会减少计数，而且持有 vacuum_latch_，不会减成负数
+  dead_tuples_ -= std::min(dead_tuples, stats.tuples_removed);
+  return stats;
 }
 
-bool TableHeap::GetNextTuple(const Row &row, Row &next_row, Txn *txn) {
+bool TableHeap::GetNextTuple(const Row &row, Row &next_row, Txn *txn, BufferAccessStrategy *strategy) {
   RowId rid = row.GetRowId();
   page_id_t page_id = rid.GetPageId();
   bool is_get = false;
   while (!is_get) {
     if (page_id == INVALID_PAGE_ID) return false;
-    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id, strategy));
     ASSERT(page != nullptr, "page is nullptr , page_id is wrong");
     page->RLatch();
     if (page->GetNextTupleRid(rid, &rid)) {
@@ -160,25 +563,13 @@ bool TableHeap::GetNextTuple(const Row &row, Row &next_row, Txn *txn) {
  * TODO: Student Implement
  */
 TableIterator TableHeap::Begin(Txn *txn) {
-  page_id_t page_id = first_page_id_;
-  bool is_get = false;
-  RowId rid;
-  while (!is_get) {
-    if (page_id == INVALID_PAGE_ID) return TableIterator(nullptr, RowId(), nullptr);
-    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
-    ASSERT(page != nullptr, "page is nullptr , page_id is wrong");
-    page->RLatch();
-    if (page->GetFirstTupleRid(&rid)) {
-      is_get = true;
-      page->RUnlatch();
-      buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
-    } else {
-      page->RUnlatch();
-      buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
-      page_id = page->GetNextPageId();
-    }
+  // 全表扫描只使用一个小的私有环，避免把其他查询的热点页换出
+  auto strategy = std::make_shared<BufferAccessStrategy>(AccessStrategyType::kBulkRead, buffer_pool_manager_);
+  // 迭代器自己跳过开头的空页
+  if (first_page_id_ == INVALID_PAGE_ID) {
+    return End();
   }
-  return TableIterator(this, rid, txn);
+  return TableIterator(this, RowId(first_page_id_, 0), txn, strategy);
 }
 
 /**
@@ -1,68 +1,84 @@
 #include "storage/table_iterator.h"
 
+#include <algorithm>
+
 #include "common/macros.h"
 #include "storage/table_heap.h"
 
 /**
  * TODO: Student Implement
  */
-TableIterator::TableIterator(TableHeap *table_heap, RowId rid, Txn *txn) {
-  row_.SetRowId(rid);
-  if (table_heap->GetTuple(&row_, txn)) {
-    table_heap_ = table_heap;
-    txn_ = txn;
+TableIterator::TableIterator(TableHeap *table_heap, RowId rid, Txn *txn, std::shared_ptr<BufferAccessStrategy> strategy)
+    : table_heap_(table_heap), txn_(txn), strategy_(std::move(strategy)) {
+  if (table_heap_ == nullptr) {
+    return;
+  }
+  if (rid.GetPageId() == INVALID_PAGE_ID || !LoadPage(rid.GetPageId())) {
+    Release();
+    return;
+  }
+  // 跳到 rid 所在槽位或它之后的第一个有效元组
+  while (pos_ < batch_size_ && batch_[pos_].GetRowId().GetSlotNum() < rid.GetSlotNum()) {
+    pos_++;
+  }
+  if (pos_ == batch_size_) {
+    NextPage();
   }
 }
 
-TableIterator::TableIterator(const TableIterator &other) {
-  table_heap_ = other.table_heap_;
-  row_ = other.row_;
-  txn_ = other.txn_;
-}
+TableIterator::TableIterator(const TableIterator &other) { *this = other; }
 
-TableIterator::TableIterator(TableIterator &other) {
-  table_heap_ = other.table_heap_;
-  row_ = other.row_;
-  txn_ = other.txn_;
-}
+TableIterator::TableIterator(TableIterator &other) { *this = static_cast<const TableIterator &>(other); }
 
-TableIterator::~TableIterator() {}
+TableIterator::~TableIterator() { Release(); }
 
 bool TableIterator::operator==(const TableIterator &itr) const {
   if (table_heap_ == nullptr && itr.table_heap_ == nullptr) {
     return true;
   } else
   {
-    return table_heap_ == itr.table_heap_ && row_.GetRowId() == itr.row_.GetRowId();
+    return table_heap_ == itr.table_heap_ && batch_[pos_].GetRowId() == itr.batch_[itr.pos_].GetRowId();
   }
 }
 
 bool TableIterator::operator!=(const TableIterator &itr) const { return !(*this == itr); }
 
 const Row &TableIterator::operator*() {
-  return row_;
+  return batch_[pos_];
 }
 
 Row *TableIterator::operator->() {
-  return &row_;
+  return &batch_[pos_];
 }
 
-TableIterator &TableIterator::operator=(const TableIterator &itr) noexcept { 
+TableIterator &TableIterator::operator=(const TableIterator &itr) noexcept {
+  if (this == &itr) {
+    return *this;
+  }
+  Release();
   table_heap_ = itr.table_heap_;
-  row_ = itr.row_;
   txn_ = itr.txn_;
+  strategy_ = itr.strategy_;
+  pages_scanned_ = itr.pages_scanned_;
+  next_read_ahead_ = itr.next_read_ahead_;
+  // 拷贝各自 pin 一次当前页
+  if (itr.page_ != nullptr) {
+    page_ = reinterpret_cast<TablePage *>(
+        table_heap_->buffer_pool_manager_->FetchPage(itr.page_->GetTablePageId(), strategy_.get()));
+  }
+  batch_.assign(itr.batch_.begin(), itr.batch_.begin() + itr.batch_size_);
+  batch_size_ = itr.batch_size_;
+  pos_ = itr.pos_;
   return *this;
 }
 
 // ++iter
 TableIterator &TableIterator::operator++() {
-  if(table_heap_->GetNextTuple(row_, row_, txn_)) {
-    return *this;
-  } else {
-    table_heap_ = nullptr;
-    txn_ = nullptr;
-    return *this;
+  // 当前页的元组用完了才去取下一页
+  if (++pos_ == batch_size_) {
+    NextPage();
   }
+  return *this;
 }
 
 // iter++
@@ -71,3 +87,58 @@ TableIterator TableIterator::operator++(int) {
   ++*this;
   return temp;
 }
+
+bool TableIterator::LoadPage(page_id_t page_id) {
+  auto page = reinterpret_cast<TablePage *>(table_heap_->buffer_pool_manager_->FetchPage(page_id, strategy_.get()));
+  if (page == nullptr) {
+    return false;
+  }
+  page_ = page;
+  // 一次读锁把整页的有效元组解码出来，之后逐行返回不再访问缓冲池
+  page->RLatch();
+  batch_size_ = page->GetTuples(batch_, table_heap_->schema_, txn_, table_heap_->lock_manager_);
+  page->RUnlatch();
+  pos_ = 0;
+  return true;
+}
+
+void TableIterator::NextPage() {
+  BufferPoolManager *bpm = table_heap_->buffer_pool_manager_;
+  while (true) {
+    // 当前页一直 pin 着，这里读到的 next 指针是最新的，vacuum 摘掉的页不会被走到
+    page_->RLatch();
+    page_id_t next_page_id = page_->GetNextPageId();
+    page_->RUnlatch();
+    bpm->UnpinPage(page_->GetTablePageId(), false);
+    page_ = nullptr;
+    if (next_page_id == INVALID_PAGE_ID || !LoadPage(next_page_id)) {
+      Release();
+      return;
+    }
+    // 迭代器沿着页链表进入了下一页，说明是顺序扫描：每扫过半个预读窗口，就预读当前页之后的一个窗口的页
+    // 窗口不超过环里除当前页以外的帧数，否则预读进来的页还没扫到就被环自己换出了
+    size_t window = READ_AHEAD_PAGES;
+    if (strategy_ != nullptr) {
+      window = std::min(window, strategy_->GetRingSize() - 1);
+    }
+    if (window > 0 && ++pages_scanned_ >= next_read_ahead_) {
+      bpm->ReadAhead(next_page_id, window + 1, TablePage::ReadNextPageId, strategy_);
+      next_read_ahead_ = pages_scanned_ + std::max<size_t>(window / 2, 1);
+    }
+    if (batch_size_ > 0) {
+      return;
+    }
+  }
+}
+
+void TableIterator::Release() {
+  if (page_ != nullptr) {
+    table_heap_->buffer_pool_manager_->UnpinPage(page_->GetTablePageId(), false);
+    page_ = nullptr;
+  }
+  table_heap_ = nullptr;
+  txn_ = nullptr;
+  strategy_ = nullptr;
+  batch_size_ = 0;
+  pos_ = 0;
+}
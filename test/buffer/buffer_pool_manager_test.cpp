@@ -1,8 +1,15 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
+#include <fstream>
+#include <iostream>
 #include <random>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -71,4 +78,636 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
 
   delete bpm;
   delete disk_manager;
-}
\ No newline at end of file
+}
+
+TEST(BufferPoolManagerTest, ShardedPoolTest) {
+  const std::string db_name = "bpm_sharded_test.db";
+  const size_t buffer_pool_size = 16;
+  const size_t num_instances = 4;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, num_instances);
+  EXPECT_EQ(num_instances, bpm->GetNumInstances());
+
+  // Scenario: page ids are handed out by the disk manager and spread over every shard.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page_id_temp);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id_temp);
+  }
+  // Scenario: every shard is full of pinned pages.
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id_temp));
+
+  // Scenario: unpinned pages are evicted to disk and can be fetched back through the right shard.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_TRUE(bpm->UnpinPage(i, true));
+  }
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page-" + std::to_string(i), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  // Scenario: deleted pages go back to the disk manager.
+  EXPECT_TRUE(bpm->DeletePage(3));
+  EXPECT_TRUE(bpm->IsPageFree(3));
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+// Throughput of concurrent FetchPage/UnpinPage hits, with every thread working on its own pages.
+static double ConcurrentFetchOpsPerSec(BufferPoolManager *bpm, size_t num_threads, size_t num_pages, size_t rounds) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([=]() {
+      for (size_t i = 0; i < rounds; i++) {
+        page_id_t page_id = (t + i * num_threads) % num_pages;
+        Page *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto stop = std::chrono::steady_clock::now();
+  return num_threads * rounds / std::chrono::duration<double>(stop - start).count();
+}
+
+TEST(BufferPoolManagerTest, ConcurrentFetchScalingTest) {
+  const std::string db_name = "bpm_scaling_test.db";
+  const size_t buffer_pool_size = 1024;
+  const size_t rounds = 50000;
+  const size_t num_pages = buffer_pool_size / 2;
+  size_t num_threads = std::max(2u, std::thread::hardware_concurrency());
+
+  std::vector<double> multi_ops;
+  for (size_t num_instances : {static_cast<size_t>(1), num_threads}) {
+    remove(db_name.c_str());
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, num_instances);
+    // the pages are created concurrently too, each page id is handed out exactly once
+    std::vector<std::vector<page_id_t>> page_ids(num_threads);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t]() {
+        for (size_t i = t; i < num_pages; i += num_threads) {
+          page_id_t page_id;
+          ASSERT_NE(nullptr, bpm->NewPage(page_id));
+          page_ids[t].push_back(page_id);
+          bpm->UnpinPage(page_id, false);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    std::vector<page_id_t> all_page_ids;
+    for (auto &ids : page_ids) {
+      all_page_ids.insert(all_page_ids.end(), ids.begin(), ids.end());
+    }
+    std::sort(all_page_ids.begin(), all_page_ids.end());
+    ASSERT_EQ(num_pages, all_page_ids.size());
+    for (size_t i = 0; i < num_pages; i++) {
+      ASSERT_EQ(static_cast<page_id_t>(i), all_page_ids[i]);
+    }
+
+    bpm->ResetStats();
+    double single = ConcurrentFetchOpsPerSec(bpm, 1, num_pages, rounds);
+    double multi = ConcurrentFetchOpsPerSec(bpm, num_threads, num_pages, rounds);
+    std::cout << "BufferPoolManager fetch/unpin, " << num_instances << " shard(s): 1 thread " << single << " ops/s, "
+              << num_threads << " threads " << multi << " ops/s" << std::endl;
+    // every fetch is a hit on a resident page
+    auto stats = bpm->GetStats();
+    EXPECT_EQ((1 + num_threads) * rounds, stats.hits);
+    EXPECT_EQ(0, stats.misses);
+    EXPECT_EQ(0, stats.evictions);
+    EXPECT_TRUE(bpm->CheckAllUnpinned());
+    multi_ops.push_back(multi);
+    delete bpm;
+    delete disk_manager;
+  }
+  // sharding must not slow concurrent hits down; with enough cores to contend on one latch it has to speed them up
+  EXPECT_LT(multi_ops[0] / 2, multi_ops[1]);
+  if (std::thread::hardware_concurrency() >= 4) {
+    EXPECT_LT(multi_ops[0], multi_ops[1]);
+  }
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, ReplacerPolicyPoolTest) {
+  const std::string db_name = "bpm_policy_test.db";
+  const size_t buffer_pool_size = 8;
+
+  for (ReplacerType replacer_type : {ReplacerType::kClock, ReplacerType::kLRUK}) {
+    remove(db_name.c_str());
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 1, replacer_type);
+
+    // Scenario: write three times as many pages as there are frames, evicting through the replacer.
+    page_id_t page_id_temp;
+    for (size_t i = 0; i < buffer_pool_size * 3; ++i) {
+      auto *page = bpm->NewPage(page_id_temp);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id_temp);
+      EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+    }
+    for (size_t i = 0; i < buffer_pool_size * 3; ++i) {
+      auto *page = bpm->FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page-" + std::to_string(i), std::string(page->GetData()));
+      EXPECT_TRUE(bpm->UnpinPage(i, false));
+    }
+    EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+    delete bpm;
+    delete disk_manager;
+  }
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, BufferRingTest) {
+  const std::string db_name = "bpm_ring_test.db";
+  const size_t buffer_pool_size = 64;
+  const size_t cold_pages = buffer_pool_size * 4;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: the working set fills the whole pool.
+  std::vector<Page *> hot_frames;
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    hot_frames.push_back(bpm->NewPage(page_id_temp));
+    ASSERT_NE(nullptr, hot_frames.back());
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  auto count_resident = [&]() {
+    size_t resident = 0;
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+      resident += hot_frames[i]->GetPageId() == static_cast<page_id_t>(i) ? 1 : 0;
+    }
+    return resident;
+  };
+
+  // Scenario: a bulk insert writes many more pages than the pool holds, but only recycles the frames of its ring.
+  BufferAccessStrategy bulk_write(AccessStrategyType::kBulkWrite, bpm);
+  EXPECT_EQ(buffer_pool_size / 8, bulk_write.GetRingSize());
+  std::set<Page *> ring_frames;
+  std::vector<page_id_t> cold_page_ids;
+  for (size_t i = 0; i < cold_pages; ++i) {
+    auto *page = bpm->NewPage(page_id_temp, &bulk_write);
+    ASSERT_NE(nullptr, page);
+    ring_frames.insert(page);
+    cold_page_ids.push_back(page_id_temp);
+    snprintf(page->GetData(), PAGE_SIZE, "cold-%d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  EXPECT_EQ(bulk_write.GetRingSize(), ring_frames.size());
+  EXPECT_EQ(buffer_pool_size - bulk_write.GetRingSize(), count_resident());
+
+  // Scenario: a sequential scan reads every cold page back through a read ring, still without touching the working set.
+  BufferAccessStrategy bulk_read(AccessStrategyType::kBulkRead, bpm);
+  for (auto page_id : cold_page_ids) {
+    auto *page = bpm->FetchPage(page_id, &bulk_read);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("cold-" + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(buffer_pool_size - bulk_write.GetRingSize() - bulk_read.GetRingSize(), count_resident());
+
+  // Scenario: the same scan through the shared pool flushes the working set.
+  for (auto page_id : cold_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0, count_resident());
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, BackgroundWriterTest) {
+  const std::string db_name = "bpm_bg_writer_test.db";
+  const size_t buffer_pool_size = 32;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: without the background writer, every eviction of a dirty page is a synchronous write.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size * 2; ++i) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  EXPECT_EQ(buffer_pool_size, bpm->GetSyncWriteCount());
+  EXPECT_EQ(0, bpm->GetBackgroundWriteCount());
+
+  // Scenario: the background writer cleans every dirty unpinned page, but leaves pinned pages alone.
+  auto *pinned = bpm->FetchPage(buffer_pool_size * 2 - 1);
+  ASSERT_NE(nullptr, pinned);
+  bpm->StartBackgroundWriter(0, 8, 1);
+  for (int i = 0; i < 5000 && bpm->GetBackgroundWriteCount() < buffer_pool_size - 1; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  bpm->StopBackgroundWriter();
+  EXPECT_EQ(buffer_pool_size - 1, bpm->GetBackgroundWriteCount());
+  EXPECT_TRUE(pinned->IsDirty());
+  EXPECT_TRUE(bpm->UnpinPage(buffer_pool_size * 2 - 1, false));
+
+  // Scenario: foreground eviction now finds clean frames, except for the page that was pinned.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page-" + std::to_string(i), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(buffer_pool_size + 1, bpm->GetSyncWriteCount());
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, ReadAheadTest) {
+  const std::string db_name = "bpm_read_ahead_test.db";
+  const size_t buffer_pool_size = 32;
+  // the page chain stores the next page id in the first bytes of every page
+  auto next_page_id = [](const char *page_data) { return *reinterpret_cast<const page_id_t *>(page_data); };
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: a chain 0 -> 1 -> ... -> 9 -> 20 -> 21 -> ... -> 29, with pages 10~19 not on it.
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < 30; ++i) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    page_id_t next = i == 9 ? 20 : (i == 29 ? INVALID_PAGE_ID : i + 1);
+    memcpy(page->GetData(), &next, sizeof(page_id_t));
+    snprintf(page->GetData() + sizeof(page_id_t), PAGE_SIZE - sizeof(page_id_t), "page-%d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  delete bpm;
+
+  // Scenario: on a cold pool, the chain is read ahead and a walk along it finds every page resident.
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  bpm->ReadAhead(0, 20, next_page_id);
+  for (int i = 0; i < 5000 && bpm->GetReadAheadCount() < 20; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(20, bpm->GetReadAheadCount());
+  for (page_id_t page_id = 0; page_id != INVALID_PAGE_ID;) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page-" + std::to_string(page_id), std::string(page->GetData() + sizeof(page_id_t)));
+    page_id_t next = next_page_id(page->GetData());
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    page_id = next;
+  }
+  EXPECT_EQ(20, bpm->GetReadAheadCount());
+
+  // Scenario: pages already resident are skipped, and a page number reused for a new page drops the prefetched copy.
+  bpm->ReadAhead(0, 20, next_page_id);
+  EXPECT_TRUE(bpm->DeletePage(29));
+  auto *page = bpm->NewPage(page_id_temp);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(29, page_id_temp);
+  EXPECT_EQ(0, page->GetData()[sizeof(page_id_t)]);
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  delete bpm;
+
+  // Scenario: the same works on a partitioned pool.
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 4);
+  bpm->ReadAhead(0, 10, next_page_id);
+  for (int i = 0; i < 5000 && bpm->GetReadAheadCount() < 10; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(10, bpm->GetReadAheadCount());
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  delete bpm;
+
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, StatsTest) {
+  const std::string db_name = "bpm_stats_test.db";
+  const size_t buffer_pool_size = 8;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  for (size_t num_instances : {1, 2}) {
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, num_instances);
+    std::vector<page_id_t> page_ids;
+    page_id_t page_id_temp;
+    // Scenario: 12 new pages, at most 3 pinned at a time, all dirty, in a pool of 8 frames.
+    for (size_t i = 0; i < 12; ++i) {
+      ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+      page_ids.push_back(page_id_temp);
+      if (i >= 2) {
+        EXPECT_TRUE(bpm->UnpinPage(page_ids[i - 2], true));
+      }
+    }
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[10], true));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[11], true));
+    auto stats = bpm->GetStats();
+    EXPECT_EQ(12, stats.new_pages);
+    EXPECT_EQ(4, stats.evictions);
+    EXPECT_EQ(4, stats.sync_writes);
+    EXPECT_LE(3, stats.pinned_high_water);
+    EXPECT_EQ(0, stats.pinned_frames);
+    EXPECT_EQ(8, stats.dirty_frames);
+    EXPECT_EQ(0, stats.free_frames);
+    EXPECT_EQ(buffer_pool_size, stats.pool_size);
+
+    // Scenario: fetching the 8 resident pages hits, fetching the 4 evicted ones misses.
+    for (auto page_id : page_ids) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+    stats = bpm->GetStats();
+    EXPECT_EQ(12, stats.hits + stats.misses);
+    EXPECT_LE(4, stats.misses);
+    EXPECT_EQ(stats.misses, stats.evictions - 4);
+
+    // Scenario: flush and delete are counted, and resetting clears every counter but keeps the occupancy.
+    ASSERT_NE(nullptr, bpm->FetchPage(page_ids[11]));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[11], true));
+    bpm->FlushAllPages();
+    EXPECT_TRUE(bpm->DeletePage(page_ids[0]));
+    stats = bpm->GetStats();
+    EXPECT_EQ(1, stats.flush_writes);
+    EXPECT_EQ(0, stats.dirty_frames);
+    EXPECT_EQ(1, stats.deleted_pages);
+    bpm->ResetStats();
+    stats = bpm->GetStats();
+    EXPECT_EQ(0, stats.hits + stats.misses + stats.evictions + stats.flush_writes + stats.new_pages);
+    EXPECT_EQ(buffer_pool_size - stats.free_frames,
+              stats.table_pages + stats.internal_pages + stats.leaf_pages + stats.meta_pages);
+    delete bpm;
+  }
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, WorkingSetTest) {
+  const std::string db_name = "bpm_working_set_test.db";
+  const std::string dump_name = "bpm_working_set_test.buffer_pool";
+  const size_t buffer_pool_size = 16;
+  auto read_dump = [](const std::string &file_name) {
+    std::ifstream file(file_name);
+    std::vector<page_id_t> page_ids;
+    page_id_t page_id;
+    while (file >> page_id) {
+      page_ids.push_back(page_id);
+    }
+    return page_ids;
+  };
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < 40; ++i) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  // Scenario: the working set is 20 pages scattered over the file, touched in a known order; the last one stays pinned.
+  std::vector<page_id_t> working_set;
+  for (page_id_t i = 19; i >= 0; --i) {
+    working_set.push_back(i * 2 + (i / 2) % 2);
+  }
+  for (auto page_id : working_set) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    if (page_id != working_set.back()) {
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+  }
+  ASSERT_TRUE(bpm->DumpWorkingSet(dump_name));
+  std::vector<page_id_t> expected(working_set.end() - buffer_pool_size, working_set.end());
+  EXPECT_EQ(expected, read_dump(dump_name));
+  EXPECT_TRUE(bpm->UnpinPage(working_set.back(), false));
+  delete bpm;
+
+  // Scenario: a restarted pool loads the dumped pages back and puts them in the same replacement order.
+  for (size_t num_instances : {1, 4}) {
+    bpm = new BufferPoolManager(buffer_pool_size, disk_manager, num_instances);
+    ASSERT_EQ(buffer_pool_size, bpm->LoadWorkingSet(dump_name));
+    for (int i = 0; i < 5000 && bpm->GetReadAheadCount() < buffer_pool_size; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(buffer_pool_size, bpm->GetReadAheadCount());
+    if (num_instances == 1) {
+      // the replacement order is restored right after the last page is installed
+      const std::string redump_name = dump_name + ".redump";
+      for (int i = 0; i < 5000; i++) {
+        ASSERT_TRUE(bpm->DumpWorkingSet(redump_name));
+        if (read_dump(redump_name) == expected) {
+          break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      EXPECT_EQ(expected, read_dump(redump_name));
+      remove(redump_name.c_str());
+    }
+    for (auto page_id : expected) {
+      auto *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page-" + std::to_string(page_id), std::string(page->GetData()));
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+    auto stats = bpm->GetStats();
+    EXPECT_EQ(buffer_pool_size, stats.hits);
+    EXPECT_EQ(0, stats.misses);
+    delete bpm;
+  }
+
+  // Scenario: pages freed since the dump are skipped.
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  EXPECT_TRUE(bpm->DeletePage(expected.front()));
+  EXPECT_TRUE(bpm->DeletePage(expected.back()));
+  EXPECT_EQ(buffer_pool_size - 2, bpm->LoadWorkingSet(dump_name));
+  EXPECT_EQ(0, bpm->LoadWorkingSet("no_such_file.buffer_pool"));
+  delete bpm;
+
+  delete disk_manager;
+  remove(db_name.c_str());
+  remove(dump_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "bpm_resize_test.db";
+  const size_t buffer_pool_size = BUFFER_POOL_CHUNK_SIZE * 2;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: fill the whole pool with dirty pages, keep the last one pinned.
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id_temp;
+  Page *pinned = nullptr;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id_temp);
+    page_ids.push_back(page_id_temp);
+    if (i + 1 < buffer_pool_size) {
+      EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+    } else {
+      pinned = page;
+    }
+  }
+
+  // Scenario: shrinking rounds up to a chunk; the released frames are written back, except the pinned one for now.
+  EXPECT_TRUE(bpm->SetPoolSize(BUFFER_POOL_CHUNK_SIZE - 10));
+  EXPECT_EQ(BUFFER_POOL_CHUNK_SIZE, bpm->GetPoolSize());
+  for (int i = 0; i < 5000 && bpm->GetStats().background_writes < BUFFER_POOL_CHUNK_SIZE - 1; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(BUFFER_POOL_CHUNK_SIZE - 1, bpm->GetStats().background_writes);
+  EXPECT_EQ("page-" + std::to_string(page_ids.back()), std::string(pinned->GetData()));
+  // a page fetched while being released is still served from its frame
+  EXPECT_EQ(pinned, bpm->FetchPage(page_ids.back()));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids.back(), true));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids.back(), true));
+  for (int i = 0; i < 5000 && bpm->GetStats().background_writes < BUFFER_POOL_CHUNK_SIZE; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(BUFFER_POOL_CHUNK_SIZE, bpm->GetStats().background_writes);
+
+  // Scenario: the pool only uses its remaining frames; every page is still readable, through at most 1024 frames.
+  std::set<Page *> frames;
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page-" + std::to_string(page_id), std::string(page->GetData()));
+    frames.insert(page);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(BUFFER_POOL_CHUNK_SIZE, frames.size());
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(BUFFER_POOL_CHUNK_SIZE, stats.pool_size);
+  EXPECT_EQ(0, stats.free_frames);
+
+  // Scenario: growing adds free frames at once.
+  EXPECT_TRUE(bpm->SetPoolSize(buffer_pool_size + 100));
+  stats = bpm->GetStats();
+  EXPECT_EQ(buffer_pool_size + 100, stats.pool_size);
+  EXPECT_EQ(buffer_pool_size + 100 - BUFFER_POOL_CHUNK_SIZE, stats.free_frames);
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+  }
+  EXPECT_EQ(buffer_pool_size, bpm->GetStats().pinned_frames);
+  EXPECT_FALSE(bpm->SetPoolSize(0));
+  // a pool larger than the physical memory is refused and the pool keeps its size
+  EXPECT_FALSE(bpm->SetPoolSize(999999999));
+  EXPECT_EQ(buffer_pool_size + 100, bpm->GetStats().pool_size);
+  delete bpm;
+
+  // Scenario: a partitioned pool is resized shard by shard.
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+  EXPECT_TRUE(bpm->SetPoolSize(buffer_pool_size * 2));
+  EXPECT_EQ(buffer_pool_size * 2, bpm->GetPoolSize());
+  EXPECT_TRUE(bpm->SetPoolSize(buffer_pool_size));
+  EXPECT_EQ(buffer_pool_size, bpm->GetPoolSize());
+  EXPECT_EQ(buffer_pool_size, bpm->GetStats().pool_size);
+  delete bpm;
+
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, DirectIOTest) {
+  const std::string db_name = "bpm_direct_io_test.db";
+  const size_t buffer_pool_size = BUFFER_POOL_CHUNK_SIZE + 10;
+  const size_t num_pages = buffer_pool_size * 2;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name, true);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: every frame is page aligned, and the frames of a pool lie back to back in one arena.
+  std::vector<page_id_t> page_ids;
+  std::vector<Page *> pages;
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+    pages.push_back(page);
+    page_ids.push_back(page_id_temp);
+  }
+  std::sort(pages.begin(), pages.end(), [](Page *a, Page *b) { return a->GetData() < b->GetData(); });
+  EXPECT_EQ(pages.front()->GetData() + (buffer_pool_size - 1) * PAGE_SIZE, pages.back()->GetData());
+  for (auto page_id : page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: pages evicted, flushed and read back through O_DIRECT (or buffered I/O where it is not supported).
+  for (size_t i = buffer_pool_size; i < num_pages; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+    page_ids.push_back(page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+
+  disk_manager = new DiskManager(db_name, true);
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  for (auto page_id : page_ids) {
+    EXPECT_FALSE(disk_manager->IsPageFree(page_id));
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ("page-" + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: buffers that are not page aligned still work, through an aligned copy.
+  std::vector<char> unaligned(PAGE_SIZE + 1);
+  disk_manager->ReadPage(page_ids.back(), unaligned.data() + 1);
+  EXPECT_EQ("page-" + std::to_string(page_ids.back()), std::string(unaligned.data() + 1));
+  snprintf(unaligned.data() + 1, PAGE_SIZE, "unaligned");
+  disk_manager->WritePage(page_ids.back(), unaligned.data() + 1);
+  {
+    IOBatch batch;
+    disk_manager->GetAsyncIO()->SubmitRead(page_ids.back(), 1, unaligned.data() + 1, &batch);
+  }
+  EXPECT_EQ("unaligned", std::string(unaligned.data() + 1));
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
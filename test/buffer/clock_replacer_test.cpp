@@ -0,0 +1,66 @@
+#include "buffer/clock_replacer.h"
+
+#include "gtest/gtest.h"
+
+TEST(CLOCKReplacerTest, SampleTest) {
+  CLOCKReplacer clock_replacer(7);
+
+  // Scenario: unpin six elements, i.e. add them to the replacer.
+  clock_replacer.Unpin(1);
+  clock_replacer.Unpin(2);
+  clock_replacer.Unpin(3);
+  clock_replacer.Unpin(4);
+  clock_replacer.Unpin(5);
+  clock_replacer.Unpin(6);
+  clock_replacer.Unpin(1);
+  EXPECT_EQ(6, clock_replacer.Size());
+
+  // Scenario: get three victims from the clock.
+  int value;
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(1, value);
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(2, value);
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(3, value);
+
+  // Scenario: pin elements in the replacer.
+  // Note that 3 has already been victimized, so pinning 3 should have no effect.
+  clock_replacer.Pin(3);
+  clock_replacer.Pin(4);
+  EXPECT_EQ(2, clock_replacer.Size());
+
+  // Scenario: unpin 4. We expect that the reference bit of 4 will be set to 1.
+  clock_replacer.Unpin(4);
+
+  // Scenario: continue looking for victims. We expect these victims.
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(5, value);
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(6, value);
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(0, clock_replacer.Size());
+  EXPECT_FALSE(clock_replacer.Victim(&value));
+}
+
+TEST(CLOCKReplacerTest, SecondChanceTest) {
+  CLOCKReplacer clock_replacer(4);
+  for (frame_id_t i = 0; i < 4; i++) {
+    clock_replacer.Unpin(i);
+  }
+  int value;
+  // Scenario: the first sweep clears every reference bit, so frame 0 is the victim.
+  ASSERT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+
+  // Scenario: a hit on frame 1 gives it a second chance, frame 2 goes first.
+  clock_replacer.Pin(1);
+  clock_replacer.Unpin(1);
+  ASSERT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+}
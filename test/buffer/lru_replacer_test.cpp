@@ -1,5 +1,8 @@
 #include "buffer/lru_replacer.h"
 
+#include <chrono>
+#include <iostream>
+
 #include "gtest/gtest.h"
 
 TEST(LRUReplacerTest, SampleTest) {
@@ -40,4 +43,32 @@ TEST(LRUReplacerTest, SampleTest) {
   EXPECT_EQ(6, value);
   lru_replacer.Victim(&value);
   EXPECT_EQ(4, value);
-}
\ No newline at end of file
+}
+
+// Measure the cost of a buffer pool hit (Pin + Unpin of a resident frame) on a full replacer.
+static double HitPathNanos(size_t pool_size, size_t rounds) {
+  LRUReplacer lru_replacer(pool_size);
+  for (size_t i = 0; i < pool_size; i++) {
+    lru_replacer.Unpin(i);
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < rounds; i++) {
+    // touch the oldest frame, i.e. the worst case for a list walk
+    frame_id_t frame_id = (i * 7919) % pool_size;
+    lru_replacer.Pin(frame_id);
+    lru_replacer.Unpin(frame_id);
+  }
+  auto stop = std::chrono::steady_clock::now();
+  EXPECT_EQ(pool_size, lru_replacer.Size());
+  return std::chrono::duration<double, std::nano>(stop - start).count() / rounds;
+}
+
+TEST(LRUReplacerTest, HitPathCostTest) {
+  const size_t rounds = 200000;
+  double small_pool = HitPathNanos(64, rounds);
+  double large_pool = HitPathNanos(DEFAULT_BUFFER_POOL_SIZE, rounds);
+  std::cout << "LRUReplacer hit path: pool_size=64 " << small_pool << " ns/op, pool_size=" << DEFAULT_BUFFER_POOL_SIZE
+            << " " << large_pool << " ns/op" << std::endl;
+  // 320x more frames should not cost anywhere near 320x per hit; allow generous slack for cache effects.
+  EXPECT_LT(large_pool, small_pool * 10);
+}
@@ -1,5 +1,8 @@
 #include "catalog/catalog.h"
 
+#include <fstream>
+#include <iterator>
+
 #include "common/instance.h"
 #include "gtest/gtest.h"
 #include "utils/utils.h"
@@ -126,4 +129,114 @@ TEST(CatalogTest, CatalogIndexTest) {
     ASSERT_EQ(rid.Get(), ret_02[i].Get());
   }
   delete db_02;
-}
\ No newline at end of file
+}
+TEST(CatalogTest, ReadOnlyOpenTest) {
+  auto db_01 = new DBStorageEngine(db_file_name, true);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  Txn txn;
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, db_01->catalog_mgr_->CreateTable("table-1", schema.get(), &txn, table_info));
+  IndexInfo *index_info = nullptr;
+  std::vector<std::string> index_keys{"id", "name"};
+  ASSERT_EQ(DB_SUCCESS, db_01->catalog_mgr_->CreateIndex("table-1", "index-1", index_keys, &txn, index_info, "bptree"));
+  auto make_row = [](int i) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i),
+                              Field(TypeId::kTypeChar, const_cast<char *>("minisql"), 7, true)};
+    return Row(fields);
+  };
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->InsertEntry(make_row(i), RowId(1000, i), nullptr));
+  }
+  delete db_01;
+  std::string db_path = "./databases/" + db_file_name;
+  std::ifstream before_file(db_path, std::ios::binary);
+  std::string before((std::istreambuf_iterator<char>(before_file)), std::istreambuf_iterator<char>());
+
+  // Scenario: two read only engines on the same file at once, both reading pages in place from their mapping.
+  auto db_02 = new DBStorageEngine(db_file_name, false, DEFAULT_BUFFER_POOL_SIZE, 1, ReplacerType::kLRU, false, true);
+  auto db_03 = new DBStorageEngine(db_file_name, false, DEFAULT_BUFFER_POOL_SIZE, 1, ReplacerType::kLRU, false, true);
+  for (auto db : {db_02, db_03}) {
+    ASSERT_TRUE(db->disk_mgr_->IsReadOnly());
+    EXPECT_EQ(0, db->bpm_->GetStats().pool_size);
+    IndexInfo *read_index_info = nullptr;
+    ASSERT_EQ(DB_SUCCESS, db->catalog_mgr_->GetIndex("table-1", "index-1", read_index_info));
+    for (int i = 0; i < 10; i++) {
+      std::vector<RowId> ret;
+      ASSERT_EQ(DB_SUCCESS, read_index_info->GetIndex()->ScanKey(make_row(i), ret, &txn));
+      ASSERT_EQ(1, ret.size());
+      EXPECT_EQ(RowId(1000, i).Get(), ret[0].Get());
+    }
+    Page *page = db->bpm_->FetchPage(INDEX_ROOTS_PAGE_ID);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(db->disk_mgr_->GetMappedPage(INDEX_ROOTS_PAGE_ID), page->GetData());
+    EXPECT_EQ(page, db->bpm_->FetchPage(INDEX_ROOTS_PAGE_ID));
+    EXPECT_TRUE(db->bpm_->UnpinPage(INDEX_ROOTS_PAGE_ID, false));
+
+    // Scenario: nothing can be written.
+    page_id_t page_id;
+    EXPECT_EQ(nullptr, db->bpm_->NewPage(page_id));
+    EXPECT_FALSE(db->bpm_->DeletePage(INDEX_ROOTS_PAGE_ID));
+    EXPECT_EQ(DB_FAILED, read_index_info->GetIndex()->InsertEntry(make_row(10), RowId(1000, 10), nullptr));
+    TableInfo *new_table_info = nullptr;
+    EXPECT_EQ(DB_FAILED, db->catalog_mgr_->CreateTable("table-2", schema.get(), &txn, new_table_info));
+    EXPECT_EQ(DB_FAILED, db->catalog_mgr_->DropIndex("table-1", "index-1"));
+  }
+  delete db_02;
+  delete db_03;
+  std::ifstream after_file(db_path, std::ios::binary);
+  std::string after((std::istreambuf_iterator<char>(after_file)), std::istreambuf_iterator<char>());
+  EXPECT_TRUE(before == after);
+  EXPECT_THROW(DBStorageEngine(db_file_name, true, DEFAULT_BUFFER_POOL_SIZE, 1, ReplacerType::kLRU, false, true),
+               std::logic_error);
+}
+
+TEST(CatalogTest, AutoVacuumTest) {
+  auto db_01 = new DBStorageEngine(db_file_name, true);
+  auto &catalog = db_01->catalog_mgr_;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  Txn txn;
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, catalog->CreateTable("table-1", schema.get(), &txn, table_info));
+  TableHeap *table_heap = table_info->GetTableHeap();
+  std::vector<RowId> rids;
+  for (int i = 0; i < 300; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i),
+                              Field(TypeId::kTypeChar, const_cast<char *>("minisql"), 7, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  // restart the autovacuum with a low threshold and a short interval
+  catalog->StopAutoVacuum();
+  catalog->StartAutoVacuum(100, 10);
+  for (int i = 0; i < 50; i++) {
+    ASSERT_TRUE(table_heap->MarkDelete(rids[i], nullptr));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  // below the threshold, nothing is vacuumed
+  EXPECT_EQ(50, table_heap->GetDeadTupleCount());
+  for (int i = 50; i < 200; i++) {
+    ASSERT_TRUE(table_heap->MarkDelete(rids[i], nullptr));
+  }
+  for (int i = 0; i < 200 && table_heap->GetDeadTupleCount() > 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(0, table_heap->GetDeadTupleCount());
+  catalog->StopAutoVacuum();
+  // the vacuumed rows are gone, the others are untouched
+  int count = 0;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+    ASSERT_EQ(CmpBool::kTrue, iter->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, 200 + count)));
+    count++;
+  }
+  EXPECT_EQ(100, count);
+  VacuumStats stats;
+  EXPECT_EQ(DB_SUCCESS, catalog->VacuumTable("table-1", stats));
+  EXPECT_EQ(0, stats.tuples_removed);
+  EXPECT_EQ(DB_TABLE_NOT_EXIST, catalog->VacuumTable("table-2", stats));
+  delete db_01;
+}
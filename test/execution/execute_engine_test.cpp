@@ -0,0 +1,193 @@
+#include "executor/execute_engine.h"
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+int yyparse(void);
+#include "parser/minisql_lex.h"
+#include "parser/parser.h"
+}
+
+/**
+ * Parse and execute one statement, the way main.cpp does.
+ * @return DB_FAILED if the statement has a syntax error
+ */
+static dberr_t RunSql(ExecuteEngine &engine, const std::string &sql) {
+  YY_BUFFER_STATE buffer = yy_scan_string(sql.c_str());
+  MinisqlParserInit();
+  yyparse();
+  dberr_t result = MinisqlParserGetError() ? DB_FAILED : engine.Execute(MinisqlGetParserRootNode());
+  MinisqlParserFinish();
+  yy_delete_buffer(buffer);
+  yylex_destroy();
+  return result;
+}
+
+/**
+ * @return the value printed in the row of the variable, -1 if there is no such row
+ */
+static long GetStatusValue(const std::string &output, const std::string &variable) {
+  std::istringstream lines(output);
+  std::string line;
+  while (std::getline(lines, line)) {
+    std::istringstream cells(line);
+    std::string bar, name, value;
+    if (cells >> bar >> name >> bar >> value && name == variable) {
+      return std::stol(value);
+    }
+  }
+  return -1;
+}
+
+TEST(ExecuteEngineTest, ShowBufferStatusTest) {
+  const std::string db_name = "show_buffer_status_test";
+  remove(("./databases/" + db_name).c_str());
+  ExecuteEngine engine;
+
+  // no database selected
+  testing::internal::CaptureStdout();
+  EXPECT_EQ(DB_FAILED, RunSql(engine, "show buffer status;"));
+  testing::internal::GetCapturedStdout();
+
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "create database " + db_name + ";"));
+  testing::internal::CaptureStdout();
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "use " + db_name + ";"));
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "create table t(id int, name char(16));"));
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "insert into t values(1, \"a\");"));
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "show buffer status;"));
+  std::string output = testing::internal::GetCapturedStdout();
+
+  EXPECT_NE(std::string::npos, output.find("Variable_name"));
+  EXPECT_EQ(DEFAULT_BUFFER_POOL_SIZE, GetStatusValue(output, "pool_size"));
+  // catalog meta, index roots, table meta, index meta and free space map pages; one data page and one leaf for the new row
+  EXPECT_EQ(5, GetStatusValue(output, "meta_pages"));
+  EXPECT_EQ(1, GetStatusValue(output, "table_pages"));
+  EXPECT_EQ(1, GetStatusValue(output, "index_leaf_pages"));
+  EXPECT_EQ(0, GetStatusValue(output, "pinned_frames"));
+  EXPECT_LE(1, GetStatusValue(output, "pinned_high_water"));
+  EXPECT_LE(1, GetStatusValue(output, "new_pages"));
+
+  // resize the pool of the current database
+  testing::internal::CaptureStdout();
+  EXPECT_EQ(DB_SUCCESS, RunSql(engine, "set buffer_pool_size = 40960;"));
+  EXPECT_EQ(DB_SUCCESS, RunSql(engine, "show buffer status;"));
+  EXPECT_EQ(DB_FAILED, RunSql(engine, "set buffer_pool_size = 0;"));
+  EXPECT_EQ(DB_FAILED, RunSql(engine, "set buffer_pool_size = 1.5;"));
+  EXPECT_EQ(DB_FAILED, RunSql(engine, "set buffer_pool_size = 999999999;"));
+  EXPECT_EQ(DB_FAILED, RunSql(engine, "set no_such_variable = 1;"));
+  output = testing::internal::GetCapturedStdout();
+  EXPECT_EQ(40960, GetStatusValue(output, "pool_size"));
+
+  // buffer and status are not keywords, anything else after show is still a syntax error
+  testing::internal::CaptureStdout();
+  EXPECT_EQ(DB_FAILED, RunSql(engine, "show buffer pool;"));
+  EXPECT_EQ(DB_FAILED, RunSql(engine, "show status buffer;"));
+  testing::internal::GetCapturedStdout();
+
+  EXPECT_EQ(DB_SUCCESS, RunSql(engine, "drop database " + db_name + ";"));
+  remove(("./databases/" + db_name).c_str());
+}
+
+TEST(ExecuteEngineTest, MultiRowInsertTest) {
+  const std::string db_name = "multi_row_insert_test";
+  remove(("./databases/" + db_name).c_str());
+  ExecuteEngine engine;
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "create database " + db_name + ";"));
+  testing::internal::CaptureStdout();
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "use " + db_name + ";"));
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "create table t(id int, name char(16), primary key(id));"));
+  testing::internal::GetCapturedStdout();
+
+  // every row of the statement is inserted and indexed
+  std::string sql = "insert into t values";
+  const int row_nums = 500;
+  for (int i = 0; i < row_nums; i++) {
+    sql += (i == 0 ? "(" : ", (") + std::to_string(i) + ", \"name" + std::to_string(i) + "\")";
+  }
+  testing::internal::CaptureStdout();
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, sql + ";"));
+  std::string output = testing::internal::GetCapturedStdout();
+  EXPECT_NE(std::string::npos, output.find("Query OK, " + std::to_string(row_nums) + " row affected"));
+  testing::internal::CaptureStdout();
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "select * from t;"));
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "select * from t where id = 321;"));
+  output = testing::internal::GetCapturedStdout();
+  EXPECT_NE(std::string::npos, output.find(std::to_string(row_nums) + " row in set"));
+  EXPECT_NE(std::string::npos, output.find("name321"));
+  EXPECT_NE(std::string::npos, output.find("1 row in set"));
+
+  // a duplicate key, in the index or earlier in the same statement, stops the insert before that row
+  testing::internal::CaptureStdout();
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "insert into t values(1000, \"a\"), (1001, \"b\"), (1000, \"c\"), (1002, \"d\");"));
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "insert into t values(2000, \"a\"), (5, \"b\");"));
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "select * from t;"));
+  output = testing::internal::GetCapturedStdout();
+  EXPECT_NE(std::string::npos, output.find("key already exists"));
+  EXPECT_NE(std::string::npos, output.find("Query OK, 2 row affected"));
+  EXPECT_NE(std::string::npos, output.find("Query OK, 1 row affected"));
+  EXPECT_NE(std::string::npos, output.find(std::to_string(row_nums + 3) + " row in set"));
+
+  EXPECT_EQ(DB_SUCCESS, RunSql(engine, "drop database " + db_name + ";"));
+  remove(("./databases/" + db_name).c_str());
+}
+
+TEST(ExecuteEngineTest, VacuumTest) {
+  const std::string db_name = "vacuum_test";
+  remove(("./databases/" + db_name).c_str());
+  ExecuteEngine engine;
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "create database " + db_name + ";"));
+  testing::internal::CaptureStdout();
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "use " + db_name + ";"));
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "create table t(id int, name char(16), primary key(id));"));
+  std::string sql = "insert into t values";
+  const int row_nums = 1000;
+  for (int i = 0; i < row_nums; i++) {
+    sql += (i == 0 ? "(" : ", (") + std::to_string(i) + ", \"name" + std::to_string(i) + "\")";
+  }
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, sql + ";"));
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "delete from t where id < 600;"));
+  testing::internal::GetCapturedStdout();
+
+  // the deleted rows are reclaimed and the pages they emptied are freed
+  testing::internal::CaptureStdout();
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "vacuum t;"));
+  std::string output = testing::internal::GetCapturedStdout();
+  EXPECT_NE(std::string::npos, output.find("Tuples_removed"));
+  std::istringstream lines(output);
+  std::string line;
+  std::vector<long> values;
+  while (std::getline(lines, line)) {
+    std::istringstream cells(line);
+    std::string bar, name, value;
+    if (cells >> bar >> name && name == "t") {
+      while (cells >> bar >> value) {
+        values.push_back(std::stol(value));
+      }
+    }
+  }
+  ASSERT_EQ(4, values.size());
+  EXPECT_EQ(600, values[1]);
+  EXPECT_LT(0, values[2]);
+  EXPECT_LT(0, values[3]);
+  EXPECT_NE(std::string::npos, output.find("600 row(s) and " + std::to_string(values[3]) + " page(s) reclaimed"));
+
+  // the table is still intact and a second vacuum finds nothing
+  testing::internal::CaptureStdout();
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "select * from t;"));
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "insert into t values(1, \"again\");"));
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "select * from t where id = 1;"));
+  ASSERT_EQ(DB_SUCCESS, RunSql(engine, "vacuum;"));
+  EXPECT_EQ(DB_TABLE_NOT_EXIST, RunSql(engine, "vacuum nosuchtable;"));
+  EXPECT_EQ(DB_FAILED, RunSql(engine, "vacuu t;"));
+  output = testing::internal::GetCapturedStdout();
+  EXPECT_NE(std::string::npos, output.find(std::to_string(row_nums - 600) + " row in set"));
+  EXPECT_NE(std::string::npos, output.find("again"));
+  EXPECT_NE(std::string::npos, output.find("0 row(s) and 0 page(s) reclaimed"));
+
+  EXPECT_EQ(DB_SUCCESS, RunSql(engine, "drop database " + db_name + ";"));
+  remove(("./databases/" + db_name).c_str());
+}
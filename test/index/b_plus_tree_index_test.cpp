@@ -47,7 +47,7 @@ TEST(BPlusTreeTests, BPlusTreeIndexSimpleTest) {
   std::vector<uint32_t> index_key_map{0, 1};
   const TableSchema table_schema(columns);
   auto *index_schema = Schema::ShallowCopySchema(&table_schema, index_key_map);
-  auto *index = new BPlusTreeIndex(0, index_schema, 256, bpm_);
+  auto *index = new BPlusTreeIndex<256>(0, index_schema, 256, bpm_);
   for (int i = 0; i < 10; i++) {
     std::vector<Field> fields{Field(TypeId::kTypeInt, i),
                               Field(TypeId::kTypeChar, const_cast<char *>("minisql"), 7, true)};
@@ -66,7 +66,7 @@ TEST(BPlusTreeTests, BPlusTreeIndexSimpleTest) {
     ASSERT_EQ(rid.Get(), ret[i].Get());
   }
   // Iterator Scan
-  IndexIterator iter = index->GetBeginIterator();
+  IndexIterator<256> iter = index->GetBeginIterator();
   uint32_t i = 0;
   for (; iter != index->GetEndIterator(); ++iter) {
     ASSERT_EQ(1000, (*iter).second.GetPageId());
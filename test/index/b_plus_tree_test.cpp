@@ -15,8 +15,9 @@ TEST(BPlusTreeTests, SampleTest) {
       new Column("int", TypeId::kTypeInt, 0, false, false),
   };
   Schema *table_schema = new Schema(columns);
+  // not one of the key size classes, the tree reads the key size at run time
   KeyManager KP(table_schema, 17);
-  BPlusTree tree(0, engine.bpm_, KP);
+  BPlusTree<0> tree(0, engine.bpm_, KP);
   TreeFileManagers mgr("tree_");
   // Prepare data
   const int n = 2000;
@@ -69,4 +70,110 @@ TEST(BPlusTreeTests, SampleTest) {
     ASSERT_TRUE(tree.GetValue(delete_seq[i], ans));
     ASSERT_EQ(kv_map[delete_seq[i]], ans[ans.size() - 1]);
   }
-}
\ No newline at end of file
+}
+TEST(BPlusTreeTests, NormalizedKeyTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 8, 1, true, false)};
+  Schema *table_schema = new Schema(columns);
+  KeyManager KP(table_schema, 16, KeyFormat::kNormalized);
+  BPlusTree<16> tree(0, engine.bpm_, KP);
+  // negative ids and names where one is a prefix of the other, the order is by id first
+  const int n = 2000;
+  vector<GenericKey *> keys;
+  for (int i = 0; i < n; i++) {
+    GenericKey *key = KP.InitKey();
+    std::string name = i % 2 == 0 ? "ab" : "abc";
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i / 2 - n / 4),
+                              Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), true)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    keys.push_back(key);
+  }
+  vector<GenericKey *> shuffled(keys);
+  ShuffleArray(shuffled);
+  for (int i = 0; i < n; i++) {
+    ASSERT_TRUE(tree.Insert(shuffled[i], RowId(i)));
+  }
+  ASSERT_TRUE(tree.Check());
+  // the leaves hold the keys in order
+  int count = 0;
+  for (auto iter = tree.Begin(); iter != tree.End(); ++iter, ++count) {
+    ASSERT_EQ(0, KP.CompareKeys(keys[count], (*iter).first));
+  }
+  ASSERT_EQ(n, count);
+  // remove every other key, the rest are still found and start their range scans
+  for (int i = 0; i < n; i += 2) {
+    tree.Remove(keys[i]);
+  }
+  ASSERT_TRUE(tree.Check());
+  vector<RowId> ans;
+  for (int i = 0; i < n; i++) {
+    ASSERT_EQ(i % 2 == 1, tree.GetValue(keys[i], ans));
+    if (i % 2 == 1) {
+      ASSERT_EQ(0, KP.CompareKeys(keys[i], (*tree.Begin(keys[i])).first));
+    }
+  }
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+// small nodes give a tree of several levels, so internal pages split, merge and borrow too
+template <int KeySize>
+static void CheckSmallNodes(DBStorageEngine &engine, Schema *table_schema, int key_size) {
+  KeyManager KP(table_schema, key_size);
+  BPlusTree<KeySize> tree(key_size, engine.bpm_, KP, 6, 5);
+  const int n = 1000;
+  vector<GenericKey *> keys;
+  for (int i = 0; i < n; i++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    keys.push_back(key);
+  }
+  vector<GenericKey *> shuffled(keys);
+  ShuffleArray(shuffled);
+  for (int i = 0; i < n; i++) {
+    ASSERT_TRUE(tree.Insert(shuffled[i], RowId(i)));
+  }
+  ASSERT_TRUE(tree.Check());
+  ShuffleArray(shuffled);
+  for (int i = 0; i < n / 2; i++) {
+    tree.Remove(shuffled[i]);
+  }
+  ASSERT_TRUE(tree.Check());
+  vector<RowId> ans;
+  for (int i = 0; i < n / 2; i++) {
+    ASSERT_FALSE(tree.GetValue(shuffled[i], ans));
+  }
+  for (int i = n / 2; i < n; i++) {
+    ASSERT_TRUE(tree.GetValue(shuffled[i], ans));
+  }
+  // the leaf chain still visits the remaining keys in order
+  int count = 0;
+  GenericKey *last = KP.InitKey();
+  for (auto iter = tree.Begin(); iter != tree.End(); ++iter, ++count) {
+    if (count > 0) {
+      ASSERT_LT(KP.CompareKeys(last, (*iter).first), 0);
+    }
+    memcpy(last, (*iter).first, key_size);
+  }
+  free(last);
+  ASSERT_EQ(n / 2, count);
+  for (int i = n / 2; i < n; i++) {
+    tree.Remove(shuffled[i]);
+  }
+  ASSERT_TRUE(tree.IsEmpty());
+  ASSERT_TRUE(tree.Check());
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+TEST(BPlusTreeTests, SmallNodeTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {new Column("int", TypeId::kTypeInt, 0, false, false)};
+  Schema *table_schema = new Schema(columns);
+  CheckSmallNodes<16>(engine, table_schema, 16);
+  CheckSmallNodes<0>(engine, table_schema, 17);
+}
@@ -0,0 +1,240 @@
+#include "index/generic_key.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/macros.h"
+#include "gtest/gtest.h"
+#include "utils/utils.h"
+
+// the order the old comparator gave by deserializing both keys and comparing field by field
+static int ExpectedCompare(const Row &lhs, const Row &rhs) {
+  for (uint32_t i = 0; i < lhs.GetFieldCount(); i++) {
+    if (lhs.GetField(i)->CompareLessThan(*rhs.GetField(i)) == CmpBool::kTrue) {
+      return -1;
+    }
+    if (lhs.GetField(i)->CompareGreaterThan(*rhs.GetField(i)) == CmpBool::kTrue) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static Field RandomField(TypeId type, std::vector<std::string> &strings) {
+  if (RandomUtils::RandomInt(0, 9) == 0) {
+    return Field(type);
+  }
+  switch (type) {
+    case TypeId::kTypeInt:
+      return Field(type, RandomUtils::RandomInt(-50, 50));
+    case TypeId::kTypeFloat:
+      return Field(type, RandomUtils::RandomFloat(-5.f, 5.f));
+    default: {
+      // short strings over a small alphabet, so equal prefixes and equal keys are common
+      std::string str;
+      int len = RandomUtils::RandomInt(0, 4);
+      for (int i = 0; i < len; i++) {
+        str.push_back(static_cast<char>('a' + RandomUtils::RandomInt(0, 2)));
+      }
+      strings.push_back(str);
+      return Field(type, const_cast<char *>(strings.back().c_str()), str.size(), true);
+    }
+  }
+}
+
+// normalized keys order null before any value instead of skipping the field
+static int ExpectedNormalizedCompare(const Row &lhs, const Row &rhs) {
+  for (uint32_t i = 0; i < lhs.GetFieldCount(); i++) {
+    bool lhs_null = lhs.GetField(i)->IsNull();
+    bool rhs_null = rhs.GetField(i)->IsNull();
+    if (lhs_null || rhs_null) {
+      if (lhs_null != rhs_null) {
+        return lhs_null ? -1 : 1;
+      }
+      continue;
+    }
+    if (lhs.GetField(i)->CompareLessThan(*rhs.GetField(i)) == CmpBool::kTrue) {
+      return -1;
+    }
+    if (lhs.GetField(i)->CompareGreaterThan(*rhs.GetField(i)) == CmpBool::kTrue) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void CheckCompareKeys(const std::vector<Column *> &columns, KeyFormat format = KeyFormat::kRow) {
+  const TableSchema schema(columns);
+  KeyManager KP(const_cast<TableSchema *>(&schema), 128, format);
+  auto expected = format == KeyFormat::kRow ? ExpectedCompare : ExpectedNormalizedCompare;
+  GenericKey *k1 = KP.InitKey();
+  GenericKey *k2 = KP.InitKey();
+  for (int n = 0; n < 2000; n++) {
+    std::vector<std::string> strings;
+    strings.reserve(2 * columns.size());
+    std::vector<Field> lhs_fields, rhs_fields;
+    for (auto column : columns) {
+      lhs_fields.push_back(RandomField(column->GetType(), strings));
+      rhs_fields.push_back(RandomField(column->GetType(), strings));
+    }
+    Row lhs(lhs_fields);
+    Row rhs(rhs_fields);
+    KP.SerializeFromKey(k1, lhs, const_cast<TableSchema *>(&schema));
+    KP.SerializeFromKey(k2, rhs, const_cast<TableSchema *>(&schema));
+    ASSERT_EQ(expected(lhs, rhs), KP.CompareKeys(k1, k2));
+    ASSERT_EQ(expected(rhs, lhs), KP.CompareKeys(k2, k1));
+    ASSERT_EQ(0, KP.CompareKeys(k1, k1));
+    // the key decodes back to the row it came from
+    Row decoded(INVALID_ROWID);
+    KP.DeserializeToKey(k1, decoded, const_cast<TableSchema *>(&schema));
+    ASSERT_EQ(lhs.GetFieldCount(), decoded.GetFieldCount());
+    for (uint32_t i = 0; i < lhs.GetFieldCount(); i++) {
+      ASSERT_EQ(lhs.GetField(i)->IsNull(), decoded.GetField(i)->IsNull());
+      if (!lhs.GetField(i)->IsNull()) {
+        ASSERT_EQ(CmpBool::kTrue, lhs.GetField(i)->CompareEquals(*decoded.GetField(i)));
+      }
+    }
+  }
+  free(k1);
+  free(k2);
+}
+
+TEST(GenericKeyTest, SingleColumnCompareTest) {
+  CheckCompareKeys({new Column("id", TypeId::kTypeInt, 0, true, false)});
+  CheckCompareKeys({new Column("account", TypeId::kTypeFloat, 0, true, false)});
+  CheckCompareKeys({new Column("name", TypeId::kTypeChar, 8, 0, true, false)});
+}
+
+TEST(GenericKeyTest, CompositeCompareTest) {
+  CheckCompareKeys({new Column("name", TypeId::kTypeChar, 8, 0, true, false),
+                    new Column("id", TypeId::kTypeInt, 1, true, false),
+                    new Column("account", TypeId::kTypeFloat, 2, true, false)});
+  // more than eight columns, the null bitmap takes two bytes
+  std::vector<Column *> columns;
+  for (uint32_t i = 0; i < 10; i++) {
+    TypeId type = i % 2 == 0 ? TypeId::kTypeInt : TypeId::kTypeChar;
+    columns.push_back(type == TypeId::kTypeInt ? new Column("c" + std::to_string(i), type, i, true, false)
+                                               : new Column("c" + std::to_string(i), type, 8, i, true, false));
+  }
+  CheckCompareKeys(columns);
+}
+
+TEST(GenericKeyTest, NormalizedCompareTest) {
+  CheckCompareKeys({new Column("id", TypeId::kTypeInt, 0, true, false)}, KeyFormat::kNormalized);
+  CheckCompareKeys({new Column("account", TypeId::kTypeFloat, 0, true, false)}, KeyFormat::kNormalized);
+  CheckCompareKeys({new Column("name", TypeId::kTypeChar, 8, 0, true, false)}, KeyFormat::kNormalized);
+  CheckCompareKeys({new Column("name", TypeId::kTypeChar, 8, 0, true, false),
+                    new Column("id", TypeId::kTypeInt, 1, true, false),
+                    new Column("account", TypeId::kTypeFloat, 2, true, false)},
+                   KeyFormat::kNormalized);
+}
+
+TEST(GenericKeyTest, LowerBoundTest) {
+  for (auto format : {KeyFormat::kRow, KeyFormat::kNormalized}) {
+    std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                     new Column("name", TypeId::kTypeChar, 4, 1, false, false)};
+    const TableSchema schema(columns);
+    KeyManager KP(const_cast<TableSchema *>(&schema), 32, format);
+    // sorted keys laid out like the pairs of a leaf page, many of them share the first int
+    const size_t stride = KP.GetKeySize() + sizeof(RowId);
+    const int n = 300;
+    std::vector<char> pairs(n * stride);
+    std::vector<std::string> names{"a", "ab", "b", "ba"};
+    for (int i = 0; i < n; i++) {
+      std::vector<Field> fields{Field(TypeId::kTypeInt, 2 * (i / 4) - n / 4),
+                                Field(TypeId::kTypeChar, const_cast<char *>(names[i % 4].c_str()),
+                                      names[i % 4].size(), true)};
+      KP.SerializeFromKey(reinterpret_cast<GenericKey *>(pairs.data() + i * stride), Row(fields),
+                          const_cast<TableSchema *>(&schema));
+    }
+    GenericKey *key = KP.InitKey();
+    for (int id = -n / 4 - 2; id <= n / 4 + 2; id++) {
+      for (auto &name : {std::string("a"), std::string("aa"), std::string("b"), std::string("c")}) {
+        std::vector<Field> fields{Field(TypeId::kTypeInt, id),
+                                  Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), true)};
+        KP.SerializeFromKey(key, Row(fields), const_cast<TableSchema *>(&schema));
+        int lo = RandomUtils::RandomInt(0, n / 2);
+        int hi = RandomUtils::RandomInt(lo, n);
+        int expected = lo;
+        while (expected < hi &&
+               KP.CompareKeys(reinterpret_cast<GenericKey *>(pairs.data() + expected * stride), key) < 0) {
+          expected++;
+        }
+        ASSERT_EQ(expected, KP.LowerBound(pairs.data(), stride, lo, hi, key));
+        ASSERT_EQ(0, KP.LowerBound(pairs.data(), stride, 0, 0, key));
+      }
+    }
+    free(key);
+  }
+}
+
+// Time lookups of dense int keys in a leaf sized pair array, with LowerBound and with a plain binary search.
+static double LowerBoundNanos(const KeyManager &KP, const std::vector<char> &pairs, size_t stride, int n,
+                              const std::vector<GenericKey *> &keys, bool prefix_search) {
+  size_t rounds = 0;
+  int sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < 200; round++) {
+    for (auto key : keys) {
+      if (prefix_search) {
+        sum += KP.LowerBound(pairs.data(), stride, 0, n, key);
+      } else {
+        int lo = 0, hi = n;
+        while (lo < hi) {
+          int mid = (lo + hi) / 2;
+          if (KP.CompareKeys(reinterpret_cast<const GenericKey *>(pairs.data() + mid * stride), key) < 0) {
+            lo = mid + 1;
+          } else {
+            hi = mid;
+          }
+        }
+        sum += lo;
+      }
+      rounds++;
+    }
+  }
+  auto stop = std::chrono::steady_clock::now();
+  EXPECT_LT(0, sum);
+  return std::chrono::duration<double, std::nano>(stop - start).count() / rounds;
+}
+
+TEST(GenericKeyTest, LowerBoundDenseIntTest) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, true, false)};
+  const TableSchema schema(columns);
+  KeyManager KP(const_cast<TableSchema *>(&schema), 16, KeyFormat::kNormalized);
+  // as many pairs as a leaf page holds, a few null keys first and then consecutive ids
+  const size_t stride = KP.GetKeySize() + sizeof(RowId);
+  const int n = (PAGE_SIZE - 64) / stride;
+  const int nulls = 4;
+  std::vector<char> pairs(n * stride);
+  for (int i = 0; i < n; i++) {
+    std::vector<Field> fields{i < nulls ? Field(TypeId::kTypeInt) : Field(TypeId::kTypeInt, i - nulls)};
+    KP.SerializeFromKey(reinterpret_cast<GenericKey *>(pairs.data() + i * stride), Row(fields),
+                        const_cast<TableSchema *>(&schema));
+  }
+  std::vector<GenericKey *> keys;
+  for (int id = -2; id < n; id++) {
+    std::vector<Field> fields{id == -2 ? Field(TypeId::kTypeInt) : Field(TypeId::kTypeInt, id)};
+    keys.push_back(KP.InitKey());
+    KP.SerializeFromKey(keys.back(), Row(fields), const_cast<TableSchema *>(&schema));
+    int expected = id == -2 ? 0 : std::min(n, std::max(id, 0) + nulls);
+    ASSERT_EQ(expected, KP.LowerBound(pairs.data(), stride, 0, n, keys.back()));
+  }
+  // best of a few runs, so a preempted run does not decide the result
+  double binary_search = 1e9, prefix_search = 1e9;
+  for (int run = 0; run < 5; run++) {
+    binary_search = std::min(binary_search, LowerBoundNanos(KP, pairs, stride, n, keys, false));
+    prefix_search = std::min(prefix_search, LowerBoundNanos(KP, pairs, stride, n, keys, true));
+  }
+  std::cout << "LowerBound over " << n << " dense int keys: binary search " << binary_search << " ns/op, prefix search "
+            << prefix_search << " ns/op" << std::endl;
+#ifdef __OPTIMIZE__
+  // without optimization the intrinsics are not inlined and the timings say nothing about the search
+  EXPECT_LT(prefix_search, binary_search);
+#endif
+  for (auto key : keys) {
+    free(key);
+  }
+}
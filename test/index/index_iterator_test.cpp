@@ -13,7 +13,7 @@ TEST(BPlusTreeTests, IndexIteratorTest) {
   };
   Schema *table_schema = new Schema(columns);
   KeyManager KP(table_schema, 16);
-  BPlusTree tree(0, engine.bpm_, KP);
+  BPlusTree<16> tree(0, engine.bpm_, KP);
   // Generate insert record
   vector<GenericKey *> insert_key;
   for (int i = 1; i <= 50; i++) {
@@ -0,0 +1,134 @@
+#include "page/table_page.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/field.h"
+#include "record/schema.h"
+
+using Fields = std::vector<Field>;
+
+static Row MakeRow(int32_t id, const std::string &name) {
+  Fields fields{Field(TypeId::kTypeInt, id),
+                Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), true)};
+  return Row(fields);
+}
+
+static void CheckTuple(TablePage &page, Schema *schema, const RowId &rid, int32_t id, const std::string &name) {
+  Row row(rid);
+  ASSERT_TRUE(page.GetTuple(&row, schema, nullptr, nullptr));
+  ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, id)));
+  ASSERT_EQ(name, std::string(row.GetField(1)->GetData(), row.GetField(1)->GetLength()));
+}
+
+TEST(PageTests, TablePageFreeSlotTest) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TablePage page;
+  page.Init(0, INVALID_PAGE_ID, nullptr, nullptr);
+  const uint32_t empty_space = page.GetFreeSpaceRemaining();
+
+  // fill the page with small tuples
+  std::vector<RowId> rids;
+  for (int i = 0;; i++) {
+    Row row = MakeRow(i, "t" + std::to_string(i));
+    if (!page.InsertTuple(row, schema.get(), nullptr, nullptr, nullptr)) {
+      break;
+    }
+    ASSERT_EQ(i, row.GetRowId().GetSlotNum());
+    rids.push_back(row.GetRowId());
+  }
+  ASSERT_LT(100, rids.size());
+  uint32_t full_space = page.GetFreeSpaceRemaining();
+
+  // deletes only record their bytes as free, every other tuple is still where it was
+  uint32_t freed = 0;
+  for (size_t i = 0; i < rids.size(); i += 2) {
+    Row row(rids[i]);
+    ASSERT_TRUE(page.GetTuple(&row, schema.get(), nullptr, nullptr));
+    freed += row.GetSerializedSize(schema.get());
+    ASSERT_TRUE(page.MarkDelete(rids[i], nullptr, nullptr, nullptr));
+    page.ApplyDelete(rids[i], nullptr, nullptr);
+  }
+  ASSERT_EQ(full_space + freed, page.GetFreeSpaceRemaining());
+  for (size_t i = 1; i < rids.size(); i += 2) {
+    CheckTuple(page, schema.get(), rids[i], i, "t" + std::to_string(i));
+  }
+
+  // inserts reuse the empty slots and compact the page once the contiguous space runs out
+  std::vector<bool> reused(rids.size(), false);
+  for (size_t i = 0; i < rids.size(); i += 2) {
+    Row row = MakeRow(-static_cast<int32_t>(i), "n" + std::to_string(i));
+    ASSERT_TRUE(page.InsertTuple(row, schema.get(), nullptr, nullptr, nullptr));
+    uint32_t slot = row.GetRowId().GetSlotNum();
+    ASSERT_EQ(0, slot % 2);
+    ASSERT_FALSE(reused[slot]);
+    reused[slot] = true;
+    CheckTuple(page, schema.get(), row.GetRowId(), -static_cast<int32_t>(i), "n" + std::to_string(i));
+  }
+  Row extra = MakeRow(0, "extra-row-that-does-not-fit");
+  ASSERT_FALSE(page.InsertTuple(extra, schema.get(), nullptr, nullptr, nullptr));
+  for (size_t i = 1; i < rids.size(); i += 2) {
+    CheckTuple(page, schema.get(), rids[i], i, "t" + std::to_string(i));
+  }
+
+  // shrinking updates in place, growing updates use the space the shrink left
+  Row old_row(rids[1]);
+  Row shorter = MakeRow(1, "s");
+  ASSERT_TRUE(page.UpdateTuple(shorter, &old_row, schema.get(), nullptr, nullptr, nullptr));
+  CheckTuple(page, schema.get(), rids[1], 1, "s");
+  Row old_row3(rids[3]);
+  Row longer = MakeRow(3, "t3x");
+  ASSERT_TRUE(page.UpdateTuple(longer, &old_row3, schema.get(), nullptr, nullptr, nullptr));
+  CheckTuple(page, schema.get(), rids[3], 3, "t3x");
+  for (size_t i = 5; i < rids.size(); i += 2) {
+    CheckTuple(page, schema.get(), rids[i], i, "t" + std::to_string(i));
+  }
+
+  // deleting everything gives back the whole page
+  for (size_t i = 0; i < rids.size(); i++) {
+    ASSERT_TRUE(page.MarkDelete(rids[i], nullptr, nullptr, nullptr));
+    page.ApplyDelete(rids[i], nullptr, nullptr);
+  }
+  RowId first_rid;
+  ASSERT_FALSE(page.GetFirstTupleRid(&first_rid));
+  ASSERT_EQ(empty_space, page.GetFreeSpaceRemaining() + TablePage::GetSpaceNeeded(0) * rids.size());
+}
+
+TEST(PageTests, TablePageOldFormatTest) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TablePage page;
+  page.Init(7, INVALID_PAGE_ID, nullptr, nullptr);
+  std::vector<RowId> rids;
+  for (int i = 0; i < 3; i++) {
+    Row row = MakeRow(i, "old" + std::to_string(i));
+    ASSERT_TRUE(page.InsertTuple(row, schema.get(), nullptr, nullptr, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  // a page written before the free slot list had 4 byte FreeSpacePointer and TupleCount fields
+  uint32_t free_space_pointer = *reinterpret_cast<uint16_t *>(page.GetData() + 16);
+  uint32_t tuple_count = *reinterpret_cast<uint16_t *>(page.GetData() + 20);
+  memcpy(page.GetData() + 16, &free_space_pointer, sizeof(uint32_t));
+  memcpy(page.GetData() + 20, &tuple_count, sizeof(uint32_t));
+  uint32_t free_space = page.GetFreeSpaceRemaining();
+
+  for (int i = 0; i < 3; i++) {
+    CheckTuple(page, schema.get(), rids[i], i, "old" + std::to_string(i));
+  }
+  ASSERT_TRUE(page.MarkDelete(rids[1], nullptr, nullptr, nullptr));
+  page.ApplyDelete(rids[1], nullptr, nullptr);
+  Row row = MakeRow(10, "new");
+  ASSERT_TRUE(page.InsertTuple(row, schema.get(), nullptr, nullptr, nullptr));
+  ASSERT_EQ(rids[1], row.GetRowId());
+  CheckTuple(page, schema.get(), rids[0], 0, "old0");
+  CheckTuple(page, schema.get(), rids[1], 10, "new");
+  CheckTuple(page, schema.get(), rids[2], 2, "old2");
+  ASSERT_EQ(free_space + MakeRow(1, "old1").GetSerializedSize(schema.get()) -
+                row.GetSerializedSize(schema.get()),
+            page.GetFreeSpaceRemaining());
+}
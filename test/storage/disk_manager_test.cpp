@@ -1,6 +1,10 @@
 #include "storage/disk_manager.h"
 
+#include <filesystem>
+#include <string>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -56,4 +60,181 @@ TEST(DiskManagerTest, FreePageAllocationTest) {
   EXPECT_EQ(extent_nums * DiskManager::BITMAP_SIZE - 5, meta_page->GetAllocatedPages());
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 2, meta_page->GetExtentUsedPage(0));
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 3, meta_page->GetExtentUsedPage(1));
-}
\ No newline at end of file
+}
+
+TEST(DiskManagerTest, ConcurrentPageIOTest) {
+  std::string db_name = "disk_io_test.db";
+  remove(db_name.c_str());
+  DiskManager *disk_mgr = new DiskManager(db_name);
+  const int num_threads = 4;
+  const int pages_per_thread = 256;
+  for (int i = 0; i < num_threads * pages_per_thread; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+  }
+
+  // Scenario: reading beyond the end of file gives a zeroed page.
+  char buf[PAGE_SIZE];
+  memset(buf, 1, PAGE_SIZE);
+  disk_mgr->ReadPage(num_threads * pages_per_thread - 1, buf);
+  EXPECT_EQ(0, buf[0]);
+  EXPECT_EQ(0, buf[PAGE_SIZE - 1]);
+
+  // Scenario: threads write and read back their own pages at the same time, without a shared file cursor.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([disk_mgr, t]() {
+      char data[PAGE_SIZE];
+      for (int round = 0; round < 2; round++) {
+        for (int i = t; i < num_threads * pages_per_thread; i += num_threads) {
+          memset(data, 0, PAGE_SIZE);
+          snprintf(data, PAGE_SIZE, "page-%d-%d", i, round);
+          disk_mgr->WritePage(i, data);
+        }
+        for (int i = t; i < num_threads * pages_per_thread; i += num_threads) {
+          disk_mgr->ReadPage(i, data);
+          EXPECT_EQ("page-" + std::to_string(i) + "-" + std::to_string(round), std::string(data));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(2 * num_threads * pages_per_thread, disk_mgr->GetNumWrites());
+
+  // Scenario: after Sync the meta page is on disk, even if the disk manager is never closed.
+  disk_mgr->Sync();
+  DiskManager *reopened = new DiskManager(db_name);
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(reopened->GetMetaData());
+  EXPECT_EQ(num_threads * pages_per_thread, meta_page->GetAllocatedPages());
+  reopened->ReadPage(7, buf);
+  EXPECT_EQ("page-7-1", std::string(buf));
+  reopened->Close();
+  delete reopened;
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, ResidentBitmapTest) {
+  std::string db_name = "disk_bitmap_test.db";
+  remove(db_name.c_str());
+  DiskManager *disk_mgr = new DiskManager(db_name);
+  const uint32_t num_pages = DiskManager::BITMAP_SIZE + 100;
+  for (uint32_t i = 0; i < num_pages; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+  }
+
+  // Scenario: allocation does no I/O, the bitmaps reach the file at the next Sync.
+  EXPECT_EQ(0, std::filesystem::file_size(db_name));
+  EXPECT_FALSE(disk_mgr->IsPageFree(num_pages - 1));
+  EXPECT_TRUE(disk_mgr->IsPageFree(num_pages));
+  EXPECT_TRUE(disk_mgr->IsPageFree(3 * DiskManager::BITMAP_SIZE));
+  disk_mgr->Sync();
+  EXPECT_LT(0, std::filesystem::file_size(db_name));
+
+  // Scenario: a page freed in a full extent is handed out again before the rest of the file.
+  disk_mgr->DeAllocatePage(10);
+  disk_mgr->DeAllocatePage(5);
+  EXPECT_EQ(5, disk_mgr->AllocatePage());
+  EXPECT_EQ(10, disk_mgr->AllocatePage());
+  EXPECT_EQ(num_pages, disk_mgr->AllocatePage());
+
+  // Scenario: emptying an extent and filling it again does not add an extent.
+  for (uint32_t i = 0; i < DiskManager::BITMAP_SIZE; i++) {
+    disk_mgr->DeAllocatePage(i);
+  }
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_EQ(0, meta_page->GetExtentUsedPage(0));
+  EXPECT_EQ(0, disk_mgr->AllocatePage());
+  EXPECT_EQ(2, meta_page->GetExtentNums());
+
+  // Scenario: changes made after the last Sync are written by Close and seen after reopening.
+  disk_mgr->Close();
+  delete disk_mgr;
+  disk_mgr = new DiskManager(db_name);
+  EXPECT_FALSE(disk_mgr->IsPageFree(0));
+  EXPECT_TRUE(disk_mgr->IsPageFree(1));
+  EXPECT_FALSE(disk_mgr->IsPageFree(num_pages));
+  EXPECT_EQ(1, disk_mgr->AllocatePage());
+  meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_EQ(103, meta_page->GetAllocatedPages());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, ExtentReservationTest) {
+  std::string db_name = "disk_reservation_test.db";
+  remove(db_name.c_str());
+  DiskManager *disk_mgr = new DiskManager(db_name);
+  ExtentReservation table, index;
+
+  // Scenario: interleaved allocations of two objects each fill their own runs in order.
+  const int index_num_pages = EXTENT_RESERVATION_PAGES + 10;
+  std::vector<page_id_t> table_pages, index_pages;
+  for (int i = 0; i < 2 * EXTENT_RESERVATION_PAGES; i++) {
+    table_pages.push_back(disk_mgr->AllocatePage(&table));
+    if (i < index_num_pages) {
+      index_pages.push_back(disk_mgr->AllocatePage(&index));
+    }
+  }
+  for (int i = 0; i < 2 * EXTENT_RESERVATION_PAGES; i++) {
+    EXPECT_EQ(i % EXTENT_RESERVATION_PAGES + 2 * EXTENT_RESERVATION_PAGES * (i / EXTENT_RESERVATION_PAGES),
+              table_pages[i]);
+  }
+  for (int i = 0; i < index_num_pages; i++) {
+    EXPECT_EQ(table_pages[i] + EXTENT_RESERVATION_PAGES, index_pages[i]);
+  }
+
+  // Scenario: an allocation without a reservation skips the rest of the index's run.
+  EXPECT_TRUE(disk_mgr->IsPageFree(index_pages.back() + 1));
+  EXPECT_EQ(4 * EXTENT_RESERVATION_PAGES, disk_mgr->AllocatePage());
+
+  // Scenario: dropping an object frees all its pages at once, and released runs are reused.
+  disk_mgr->DeAllocatePages(table_pages);
+  disk_mgr->ReleaseReservation(&table);
+  for (auto page_id : table_pages) {
+    ASSERT_TRUE(disk_mgr->IsPageFree(page_id));
+  }
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_EQ(index_num_pages + 1, meta_page->GetAllocatedPages());
+  EXPECT_EQ(0, disk_mgr->AllocatePage(&table));
+  EXPECT_EQ(1, disk_mgr->AllocatePage(&table));
+  disk_mgr->ReleaseReservation(&table);
+  disk_mgr->ReleaseReservation(&index);
+  EXPECT_EQ(2, disk_mgr->AllocatePage());
+  EXPECT_EQ(3, disk_mgr->AllocatePage(&index));
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, CoalescedWriteTest) {
+  std::string db_name = "disk_coalesce_test.db";
+  remove(db_name.c_str());
+  DiskManager *disk_mgr = new DiskManager(db_name);
+  const page_id_t extent_end = DiskManager::BITMAP_SIZE;
+  // unsorted pages [10, 30), [40, 41) and [extent_end - 5, extent_end + 5), which the next bitmap page splits in two
+  std::vector<page_id_t> page_ids;
+  for (page_id_t i = 40; i < 41; i++) page_ids.push_back(i);
+  for (page_id_t i = extent_end - 5; i < extent_end + 5; i++) page_ids.push_back(i);
+  for (page_id_t i = 29; i >= 10; i--) page_ids.push_back(i);
+  std::vector<std::vector<char>> data(page_ids.size(), std::vector<char>(PAGE_SIZE, 0));
+  std::vector<std::pair<page_id_t, const char *>> pages;
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    snprintf(data[i].data(), PAGE_SIZE, "page-%d", page_ids[i]);
+    pages.emplace_back(page_ids[i], data[i].data());
+  }
+
+  disk_mgr->WritePages(pages);
+  EXPECT_EQ(page_ids.size(), disk_mgr->GetNumWrites());
+  // one request per physically contiguous run
+  EXPECT_EQ(4, disk_mgr->GetAsyncIO()->GetNumCompleted());
+  char buf[PAGE_SIZE];
+  for (auto page_id : page_ids) {
+    disk_mgr->ReadPage(page_id, buf);
+    ASSERT_EQ("page-" + std::to_string(page_id), std::string(buf));
+  }
+  disk_mgr->ReadPage(30, buf);
+  EXPECT_EQ(0, buf[0]);
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
@@ -1,5 +1,6 @@
 #include "storage/table_heap.h"
 
+#include <algorithm>
 #include <unordered_map>
 #include <vector>
 
@@ -61,3 +62,467 @@ TEST(TableHeapTest, TableHeapSampleTest) {
   }
   ASSERT_EQ(size, 0);
 }
+
+TEST(TableHeapTest, ColdScanReadAheadTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 5000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, sizeof(characters), true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  // without read-ahead a cold scan misses once per page of the table
+  size_t table_pages = 0;
+  for (page_id_t page_id = first_page_id; page_id != INVALID_PAGE_ID; table_pages++) {
+    auto page = reinterpret_cast<TablePage *>(bpm_->FetchPage(page_id));
+    page_id_t next_page_id = page->GetNextPageId();
+    bpm_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  delete table_heap;
+  delete bpm_;
+
+  // scan the table on a cold buffer pool that is smaller than the table
+  bpm_ = new BufferPoolManager(64, disk_mgr_);
+  table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr);
+  bpm_->ResetStats();
+  int count = 0;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+    ASSERT_EQ(CmpBool::kTrue, iter->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, count)));
+    count++;
+  }
+  ASSERT_EQ(row_nums, count);
+  // pages loaded ahead stay in the ring until the scan reaches them, so the scan itself misses less
+  BufferPoolStats stats = bpm_->GetStats();
+  ASSERT_GT(stats.read_ahead_pages, 0);
+  EXPECT_LT(stats.misses, table_pages);
+  ASSERT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+}
+
+TEST(TableHeapTest, InterleavedInsertContiguityTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 1000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *heaps[2] = {TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr),
+                         TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr)};
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  for (int i = 0; i < row_nums; i++) {
+    for (auto table_heap : heaps) {
+      Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, sizeof(characters), true)};
+      Row row(fields);
+      ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    }
+  }
+
+  // each heap's page chain lies in consecutive page ids although the inserts were interleaved
+  std::vector<page_id_t> page_ids[2];
+  for (int h = 0; h < 2; h++) {
+    for (page_id_t page_id = heaps[h]->GetFirstPageId(); page_id != INVALID_PAGE_ID;) {
+      page_ids[h].push_back(page_id);
+      auto page = reinterpret_cast<TablePage *>(bpm_->FetchPage(page_id));
+      page_id_t next_page_id = page->GetNextPageId();
+      bpm_->UnpinPage(page_id, false);
+      page_id = next_page_id;
+    }
+    ASSERT_LT(1, page_ids[h].size());
+    for (size_t i = 1; i < page_ids[h].size(); i++) {
+      EXPECT_EQ(page_ids[h][i - 1] + 1, page_ids[h][i]);
+    }
+  }
+
+  // freeing a heap returns all its pages
+  heaps[0]->FreeTableHeap();
+  for (auto page_id : page_ids[0]) {
+    EXPECT_TRUE(bpm_->IsPageFree(page_id));
+  }
+  EXPECT_FALSE(bpm_->IsPageFree(page_ids[1][0]));
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete heaps[0];
+  delete heaps[1];
+  delete bpm_;
+  delete disk_mgr_;
+}
+
+TEST(TableHeapTest, FreeSpaceMapTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 5000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, sizeof(characters), true)};
+    Row row(fields);
+    bpm_->ResetStats();
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    // appending touches the last page and its map page, and a few more pages when a new page is linked
+    auto stats = bpm_->GetStats();
+    ASSERT_GE(5, stats.hits + stats.misses);
+    rids.push_back(row.GetRowId());
+  }
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  page_id_t fsm_page_id = table_heap->GetFsmPageId();
+  ASSERT_NE(INVALID_PAGE_ID, fsm_page_id);
+  page_id_t last_page_id = rids.back().GetPageId();
+
+  // free every tuple of the second page, the next inserts go there instead of the end of the heap
+  page_id_t hole_page_id = INVALID_PAGE_ID;
+  int freed = 0;
+  for (auto &rid : rids) {
+    if (rid.GetPageId() == first_page_id) {
+      continue;
+    }
+    if (hole_page_id == INVALID_PAGE_ID) {
+      hole_page_id = rid.GetPageId();
+    }
+    if (rid.GetPageId() != hole_page_id) {
+      break;
+    }
+    ASSERT_TRUE(table_heap->MarkDelete(rid, nullptr));
+    table_heap->ApplyDelete(rid, nullptr);
+    freed++;
+  }
+  ASSERT_LT(1, freed);
+  // fill the last page so that the inserts can not stay there
+  for (int i = 0;; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, sizeof(characters), true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    if (row.GetRowId().GetPageId() != last_page_id) {
+      ASSERT_EQ(hole_page_id, row.GetRowId().GetPageId());
+      freed--;
+      break;
+    }
+  }
+  delete table_heap;
+  delete bpm_;
+
+  // the map is persisted: a reopened heap still finds the hole
+  bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr, fsm_page_id);
+  for (int i = 0; i < freed; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, sizeof(characters), true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    ASSERT_EQ(hole_page_id, row.GetRowId().GetPageId());
+  }
+  Fields fields{Field(TypeId::kTypeInt, 0), Field(TypeId::kTypeChar, characters, sizeof(characters), true)};
+  Row row(fields);
+  ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  ASSERT_NE(hole_page_id, row.GetRowId().GetPageId());
+  delete table_heap;
+
+  // a heap opened without its map rebuilds it from the page chain
+  table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr);
+  ASSERT_TRUE(table_heap->MarkDelete(rids[0], nullptr));
+  table_heap->ApplyDelete(rids[0], nullptr);
+  last_page_id = row.GetRowId().GetPageId();
+  for (;;) {
+    Row next_row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(next_row, nullptr));
+    if (next_row.GetRowId().GetPageId() != last_page_id) {
+      ASSERT_EQ(first_page_id, next_row.GetRowId().GetPageId());
+      break;
+    }
+  }
+  page_id_t rebuilt_fsm_page_id = table_heap->GetFsmPageId();
+  ASSERT_NE(INVALID_PAGE_ID, rebuilt_fsm_page_id);
+  table_heap->FreeTableHeap();
+  EXPECT_TRUE(bpm_->IsPageFree(first_page_id));
+  EXPECT_TRUE(bpm_->IsPageFree(rebuilt_fsm_page_id));
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+}
+
+TEST(TableHeapTest, InsertTuplesTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 5000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  Fields first_fields{Field(TypeId::kTypeInt, -1), Field(TypeId::kTypeChar, characters, sizeof(characters), true)};
+  Row first_row(first_fields);
+  ASSERT_TRUE(table_heap->InsertTuple(first_row, nullptr));
+  std::vector<Row> rows;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, sizeof(characters), true)};
+    rows.emplace_back(fields);
+  }
+  bpm_->ResetStats();
+  ASSERT_EQ(row_nums, table_heap->InsertTuples(rows, nullptr));
+  // the batch first fills the page of the single insert, then every new page is pinned once and never fetched again
+  auto stats = bpm_->GetStats();
+  EXPECT_EQ(first_row.GetRowId().GetPageId(), rows[0].GetRowId().GetPageId());
+  EXPECT_LT(1, stats.new_pages);
+  EXPECT_GE(2 * stats.new_pages + 2, stats.hits + stats.misses);
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+
+  // the rows are chained in insertion order and a later single insert continues at the last page
+  int count = -1;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+    ASSERT_EQ(CmpBool::kTrue, iter->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, count)));
+    count++;
+  }
+  ASSERT_EQ(row_nums, count);
+  Row last_row(first_fields);
+  ASSERT_TRUE(table_heap->InsertTuple(last_row, nullptr));
+  EXPECT_EQ(rows.back().GetRowId().GetPageId(), last_row.GetRowId().GetPageId());
+  std::vector<Row> empty_rows;
+  EXPECT_EQ(0, table_heap->InsertTuples(empty_rows, nullptr));
+
+  // a row that does not fit in an empty page is rejected without appending a page to the chain
+  const uint32_t blob_len = VARCHAR_MAX_LEN - 1;
+  std::vector<Column *> big_columns = {new Column("a", TypeId::kTypeChar, blob_len, 0, false, false),
+                                       new Column("b", TypeId::kTypeChar, blob_len, 1, false, false)};
+  auto big_schema = std::make_shared<Schema>(big_columns);
+  TableHeap *big_heap = TableHeap::Create(bpm_, big_schema.get(), nullptr, nullptr, nullptr);
+  std::string blob(blob_len, 'b');
+  Fields big_fields{Field(TypeId::kTypeChar, const_cast<char *>(blob.data()), blob_len, true),
+                    Field(TypeId::kTypeChar, const_cast<char *>(blob.data()), blob_len, true)};
+  Row big_row(big_fields);
+  std::vector<Row> big_rows{big_row};
+  bpm_->ResetStats();
+  EXPECT_FALSE(big_heap->InsertTuple(big_row, nullptr));
+  EXPECT_EQ(0, big_heap->InsertTuples(big_rows, nullptr));
+  EXPECT_EQ(0, bpm_->GetStats().new_pages);
+  EXPECT_TRUE(big_heap->Begin(nullptr) == big_heap->End());
+  delete big_heap;
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+}
+
+TEST(TableHeapTest, InsertTuplesBulkWriteRingTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  const size_t buffer_pool_size = 64;
+  auto bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  // the working set of other queries takes every free frame
+  std::vector<std::pair<Page *, page_id_t>> hot_pages;
+  page_id_t page_id;
+  Page *page;
+  while ((page = bpm_->NewPage(page_id)) != nullptr && hot_pages.size() < buffer_pool_size) {
+    hot_pages.emplace_back(page, page_id);
+    bpm_->UnpinPage(page_id, false);
+    if (bpm_->GetStats().free_frames == 0) {
+      break;
+    }
+  }
+  // a large batch writes far more pages than the pool holds, but only recycles the frames of its ring
+  std::vector<Row> rows;
+  for (int i = 0; i < BULK_WRITE_MIN_ROWS * 5; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, sizeof(characters), true)};
+    rows.emplace_back(fields);
+  }
+  ASSERT_EQ(rows.size(), table_heap->InsertTuples(rows, nullptr));
+  EXPECT_LT(buffer_pool_size, bpm_->GetStats().new_pages);
+  size_t resident = 0;
+  for (auto &hot_page : hot_pages) {
+    resident += hot_page.first->GetPageId() == hot_page.second ? 1 : 0;
+  }
+  // besides the ring, only the free space map pages are loaded through the shared pool
+  EXPECT_LE(hot_pages.size() - buffer_pool_size / 8 - 2, resident);
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  int count = 0;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+    ASSERT_EQ(CmpBool::kTrue, iter->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, count)));
+    count++;
+  }
+  ASSERT_EQ(rows.size(), count);
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+}
+
+TEST(TableHeapTest, VacuumTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 3000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  std::vector<RowId> rids;
+  std::vector<page_id_t> page_ids;
+  uint32_t row_size = 0;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, sizeof(characters), true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    row_size = row.GetSerializedSize(schema.get());
+    rids.push_back(row.GetRowId());
+    if (page_ids.empty() || page_ids.back() != row.GetRowId().GetPageId()) {
+      page_ids.push_back(row.GetRowId().GetPageId());
+    }
+  }
+  ASSERT_LT(4, page_ids.size());
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  page_id_t fsm_page_id = table_heap->GetFsmPageId();
+
+  // empty the second and third page, and every other tuple of the fourth page
+  std::vector<bool> deleted(row_nums, false);
+  uint32_t marked = 0;
+  for (int i = 0; i < row_nums; i++) {
+    page_id_t page_id = rids[i].GetPageId();
+    if (page_id == page_ids[1] || page_id == page_ids[2] || (page_id == page_ids[3] && i % 2 == 0)) {
+      ASSERT_TRUE(table_heap->MarkDelete(rids[i], nullptr));
+      deleted[i] = true;
+      marked++;
+    }
+  }
+  EXPECT_EQ(marked, table_heap->GetDeadTupleCount());
+
+  VacuumStats stats = table_heap->Vacuum(nullptr);
+  EXPECT_EQ(page_ids.size(), stats.pages_scanned);
+  EXPECT_EQ(marked, stats.tuples_removed);
+  EXPECT_EQ(static_cast<uint64_t>(marked) * row_size, stats.bytes_reclaimed);
+  EXPECT_EQ(2, stats.pages_freed);
+  EXPECT_EQ(0, table_heap->GetDeadTupleCount());
+  EXPECT_TRUE(bpm_->IsPageFree(page_ids[1]));
+  EXPECT_TRUE(bpm_->IsPageFree(page_ids[2]));
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+
+  // the chain skips the freed pages and the remaining tuples keep their rids
+  int count = 0;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+    while (deleted[count]) {
+      count++;
+    }
+    ASSERT_EQ(rids[count], iter->GetRowId());
+    ASSERT_EQ(CmpBool::kTrue, iter->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, count)));
+    count++;
+  }
+  ASSERT_EQ(row_nums, count);
+  auto page = reinterpret_cast<TablePage *>(bpm_->FetchPage(page_ids[3]));
+  EXPECT_EQ(page_ids[0], page->GetPrevPageId());
+  bpm_->UnpinPage(page_ids[3], false);
+
+  // nothing left to reclaim
+  stats = table_heap->Vacuum(nullptr);
+  EXPECT_EQ(0, stats.tuples_removed);
+  EXPECT_EQ(0, stats.pages_freed);
+  delete table_heap;
+  delete bpm_;
+
+  // after reopening, inserts that overflow the last page go to the holes of the fourth page, not to a freed page
+  bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr, fsm_page_id);
+  for (int i = 0;; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, sizeof(characters), true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    if (row.GetRowId().GetPageId() != page_ids.back()) {
+      ASSERT_EQ(page_ids[3], row.GetRowId().GetPageId());
+      break;
+    }
+  }
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+}
+
+TEST(TableHeapTest, IteratorPageAtATimeTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 5000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  std::vector<RowId> rids;
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, sizeof(characters), true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+    if (page_ids.empty() || page_ids.back() != row.GetRowId().GetPageId()) {
+      page_ids.push_back(row.GetRowId().GetPageId());
+    }
+  }
+  // an empty page in the middle of the chain is skipped
+  for (auto &rid : rids) {
+    if (rid.GetPageId() == page_ids[1]) {
+      ASSERT_TRUE(table_heap->MarkDelete(rid, nullptr));
+    }
+  }
+
+  // the scan fetches each page once and keeps only the current one pinned
+  bpm_->ResetStats();
+  int count = 0;
+  page_id_t current_page_id = INVALID_PAGE_ID;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+    if (iter->GetRowId().GetPageId() != current_page_id) {
+      current_page_id = iter->GetRowId().GetPageId();
+      ASSERT_EQ(1, bpm_->GetStats().pinned_frames);
+    }
+    if (rids[count].GetPageId() == page_ids[1]) {
+      count = std::find_if(rids.begin(), rids.end(), [&](const RowId &rid) { return rid.GetPageId() == page_ids[2]; }) -
+              rids.begin();
+    }
+    ASSERT_EQ(rids[count], iter->GetRowId());
+    ASSERT_EQ(CmpBool::kTrue, iter->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, count)));
+    count++;
+  }
+  ASSERT_EQ(row_nums, count);
+  // one fetch per page by the scan, the read-ahead follows the chain through resident pages without fetching them
+  auto stats = bpm_->GetStats();
+  EXPECT_EQ(page_ids.size(), stats.hits + stats.misses);
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+
+  // copies pin the page on their own and can be advanced independently
+  auto iter = table_heap->Begin(nullptr);
+  auto copy = iter;
+  ++iter;
+  EXPECT_EQ(rids[0], copy->GetRowId());
+  EXPECT_EQ(rids[1], iter->GetRowId());
+  copy = table_heap->End();
+  EXPECT_FALSE(bpm_->CheckAllUnpinned());
+  iter = table_heap->End();
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+}